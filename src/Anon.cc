@@ -4,8 +4,11 @@
 #include <unistd.h>
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
+#include <string_view>
 
 #include "zeek/Event.h"
+#include "zeek/Hash.h"
 #include "zeek/ID.h"
 #include "zeek/IPAddr.h"
 #include "zeek/NetVar.h"
@@ -15,6 +18,8 @@
 #include "zeek/net_util.h"
 #include "zeek/util.h"
 
+#include "zeek/3rdparty/doctest.h"
+
 namespace zeek::detail {
 
 AnonymizeIPAddr* ip_anonymizer[NUM_ADDR_ANONYMIZATION_METHODS] = {nullptr};
@@ -127,6 +132,83 @@ ipaddr32_t AnonymizeIPAddr_PrefixMD5::anonymize(ipaddr32_t input) {
     return htonl(output);
 }
 
+ipaddr32_t AnonymizeIPAddr_PrefixPRF::anonymize(ipaddr32_t input) {
+    // Network order means the most significant byte comes first.
+    uint8_t bytes[4];
+    memcpy(bytes, &input, sizeof(bytes));
+    AnonymizeBytes(bytes, sizeof(bytes));
+
+    ipaddr32_t output;
+    memcpy(&output, bytes, sizeof(output));
+    return output;
+}
+
+IPAddr AnonymizeIPAddr_PrefixPRF::AnonymizeAddr(const IPAddr& addr) {
+    if ( addr.GetFamily() == IPv4 ) {
+        const uint32_t* bytes;
+        addr.GetBytes(&bytes);
+        ipaddr32_t output = Anonymize(*bytes);
+        return IPAddr(IPv4, &output, IPAddr::Network);
+    }
+
+    in6_addr a;
+    addr.CopyIPv6(&a);
+    AnonymizeBytes(a.s6_addr, sizeof(a.s6_addr));
+    return IPAddr(a);
+}
+
+size_t AnonymizeIPAddr_PrefixPRF::PrefixKeyHash::operator()(const PrefixKey& k) const {
+    return std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char*>(k.data()), k.size()));
+}
+
+void AnonymizeIPAddr_PrefixPRF::AnonymizeBytes(uint8_t* bytes, int len) {
+    // The PRF's input: the address length, to separate the families, the
+    // number of prefix bits, and the prefix padded with zeros.
+    struct {
+        uint8_t len;
+        uint8_t bits;
+        uint8_t prefix[16];
+    } in;
+
+    uint8_t output[16];
+    PrefixKey key = {};
+    key[0] = len;
+
+    for ( int i = 0; i < len; ++i ) {
+        key[1] = i;
+        key[2 + i] = bytes[i];
+
+        uint8_t flips = 0;
+
+        if ( auto it = prefixes.find(key); it != prefixes.end() )
+            flips = it->second;
+
+        else {
+            memset(&in, 0, sizeof(in));
+            in.len = len;
+            memcpy(in.prefix, bytes, i);
+
+            for ( int j = 0; j < 8; ++j ) {
+                // x_i' = x_i ^ LSB(PRF(x_0 ... x_{i-1})).
+                in.bits = i * 8 + j;
+                in.prefix[i] = bytes[i] & ~(0xff >> j);
+
+                if ( KeyedHash::StaticHash64(&in, sizeof(in)) & 1 )
+                    flips |= 0x80 >> j;
+            }
+
+            if ( prefixes.size() >= MAX_CACHED_PREFIXES )
+                prefixes.clear();
+
+            prefixes.emplace(key, flips);
+        }
+
+        output[i] = bytes[i] ^ flips;
+    }
+
+    memcpy(bytes, output, len);
+}
+
 AnonymizeIPAddr_A50::~AnonymizeIPAddr_A50() {
     for ( auto& b : blocks )
         delete[] b;
@@ -323,12 +405,19 @@ static TableValPtr anon_preserve_orig_addr;
 static TableValPtr anon_preserve_resp_addr;
 static TableValPtr anon_preserve_other_addr;
 
+// The globals selecting each class's method. We look at their current
+// values on every use, so that scripts can change them at run-time.
+static IDPtr anon_orig_addr_method;
+static IDPtr anon_resp_addr_method;
+static IDPtr anon_other_addr_method;
+
 void init_ip_addr_anonymizers() {
     ip_anonymizer[KEEP_ORIG_ADDR] = nullptr;
     ip_anonymizer[SEQUENTIALLY_NUMBERED] = new AnonymizeIPAddr_Seq();
     ip_anonymizer[RANDOM_MD5] = new AnonymizeIPAddr_RandomMD5();
     ip_anonymizer[PREFIX_PRESERVING_A50] = new AnonymizeIPAddr_A50();
     ip_anonymizer[PREFIX_PRESERVING_MD5] = new AnonymizeIPAddr_PrefixMD5();
+    ip_anonymizer[PREFIX_PRESERVING_PRF] = new AnonymizeIPAddr_PrefixPRF();
 
     auto id = global_scope()->Find("preserve_orig_addr");
 
@@ -344,30 +433,45 @@ void init_ip_addr_anonymizers() {
 
     if ( id )
         anon_preserve_other_addr = cast_intrusive<TableVal>(id->GetVal());
+
+    anon_orig_addr_method = global_scope()->Find("orig_addr_anonymization");
+    anon_resp_addr_method = global_scope()->Find("resp_addr_anonymization");
+    anon_other_addr_method = global_scope()->Find("other_addr_anonymization");
 }
 
-ipaddr32_t anonymize_ip(ipaddr32_t ip, enum ip_addr_anonymization_class_t cl) {
-    TableVal* preserve_addr = nullptr;
-    auto addr = make_intrusive<AddrVal>(ip);
+// Returns the current value of a method global, or the given default if
+// it's not defined.
+static int current_method(const IDPtr& id, int dflt) {
+    if ( id ) {
+        if ( const auto& v = id->GetVal() )
+            return v->AsInt();
+    }
 
-    int method = -1;
+    return dflt;
+}
 
+// Returns the anonymization method for a class, and the addresses to keep.
+static int anonymization_method(enum ip_addr_anonymization_class_t cl, TableVal** preserve_addr) {
     switch ( cl ) {
         case ORIG_ADDR: // client address
-            preserve_addr = anon_preserve_orig_addr.get();
-            method = orig_addr_anonymization;
-            break;
+            *preserve_addr = anon_preserve_orig_addr.get();
+            return current_method(anon_orig_addr_method, orig_addr_anonymization);
 
         case RESP_ADDR: // server address
-            preserve_addr = anon_preserve_resp_addr.get();
-            method = resp_addr_anonymization;
-            break;
+            *preserve_addr = anon_preserve_resp_addr.get();
+            return current_method(anon_resp_addr_method, resp_addr_anonymization);
 
         default:
-            preserve_addr = anon_preserve_other_addr.get();
-            method = other_addr_anonymization;
-            break;
+            *preserve_addr = anon_preserve_other_addr.get();
+            return current_method(anon_other_addr_method, other_addr_anonymization);
     }
+}
+
+ipaddr32_t anonymize_ip(ipaddr32_t ip, enum ip_addr_anonymization_class_t cl) {
+    TableVal* preserve_addr = nullptr;
+    auto addr = make_intrusive<AddrVal>(ip);
+
+    int method = anonymization_method(cl, &preserve_addr);
 
     ipaddr32_t new_ip = 0;
 
@@ -394,6 +498,44 @@ ipaddr32_t anonymize_ip(ipaddr32_t ip, enum ip_addr_anonymization_class_t cl) {
     return new_ip;
 }
 
+bool ipv6_anonymization_supported(enum ip_addr_anonymization_class_t cl) {
+    TableVal* preserve_addr = nullptr;
+    int method = anonymization_method(cl, &preserve_addr);
+    return method == KEEP_ORIG_ADDR || method == PREFIX_PRESERVING_PRF;
+}
+
+IPAddr anonymize_ip(const IPAddr& ip, enum ip_addr_anonymization_class_t cl) {
+    if ( ip.GetFamily() == IPv4 ) {
+        const uint32_t* bytes;
+        ip.GetBytes(&bytes);
+        ipaddr32_t new_ip = anonymize_ip(*bytes, cl);
+        return IPAddr(IPv4, &new_ip, IPAddr::Network);
+    }
+
+    TableVal* preserve_addr = nullptr;
+    int method = anonymization_method(cl, &preserve_addr);
+
+    IPAddr new_ip = ip;
+
+    if ( preserve_addr && preserve_addr->FindOrDefault(make_intrusive<AddrVal>(ip)) )
+        ; // Keep as is.
+
+    else if ( method == PREFIX_PRESERVING_PRF ) {
+        if ( ! ip_anonymizer[method] )
+            reporter->InternalError("IP anonymizer not initialized");
+
+        new_ip = static_cast<AnonymizeIPAddr_PrefixPRF*>(ip_anonymizer[method])->AnonymizeAddr(ip);
+    }
+
+    else if ( method != KEEP_ORIG_ADDR )
+        reporter->InternalError("IP anonymization method does not support IPv6");
+
+#ifdef LOG_ANONYMIZATION_MAPPING
+    log_anonymization_mapping(ip, new_ip);
+#endif
+    return new_ip;
+}
+
 #ifdef LOG_ANONYMIZATION_MAPPING
 
 void log_anonymization_mapping(ipaddr32_t input, ipaddr32_t output) {
@@ -401,6 +543,63 @@ void log_anonymization_mapping(ipaddr32_t input, ipaddr32_t output) {
         event_mgr.Enqueue(anonymization_mapping, make_intrusive<AddrVal>(input), make_intrusive<AddrVal>(output));
 }
 
+void log_anonymization_mapping(const IPAddr& input, const IPAddr& output) {
+    if ( anonymization_mapping )
+        event_mgr.Enqueue(anonymization_mapping, make_intrusive<AddrVal>(input), make_intrusive<AddrVal>(output));
+}
+
 #endif
 
+TEST_SUITE_BEGIN("Anon");
+
+namespace {
+
+// Returns the number of leading bits two addresses have in common.
+int common_prefix_len(const IPAddr& a, const IPAddr& b) {
+    in6_addr x, y;
+    a.CopyIPv6(&x);
+    b.CopyIPv6(&y);
+
+    for ( int i = 0; i < 128; ++i ) {
+        uint8_t mask = 0x80 >> (i % 8);
+        if ( (x.s6_addr[i / 8] & mask) != (y.s6_addr[i / 8] & mask) )
+            return i;
+    }
+
+    return 128;
+}
+
+} // namespace
+
+TEST_CASE("prefix-preserving PRF anonymization") {
+    AnonymizeIPAddr_PrefixPRF anon;
+
+    const char* addrs[] = {"10.0.0.1",    "10.0.0.2",    "10.0.1.1",       "10.128.0.1",     "192.168.1.1",
+                           "2001:db8::1", "2001:db8::2", "2001:db8:1::1", "2001:db9::1", "fe80::1"};
+
+    for ( auto a : addrs ) {
+        for ( auto b : addrs ) {
+            IPAddr x(a), y(b);
+
+            if ( x.GetFamily() != y.GetFamily() )
+                continue;
+
+            auto ax = anon.AnonymizeAddr(x);
+            auto ay = anon.AnonymizeAddr(y);
+            CHECK(ax.GetFamily() == x.GetFamily());
+            CHECK(common_prefix_len(ax, ay) == common_prefix_len(x, y));
+        }
+    }
+
+    // The mapping must not depend on what's been memoized already.
+    AnonymizeIPAddr_PrefixPRF fresh;
+
+    for ( auto a : addrs ) {
+        IPAddr x(a);
+        CHECK(fresh.AnonymizeAddr(x) == anon.AnonymizeAddr(x));
+    }
+}
+
+TEST_SUITE_END();
+
 } // namespace zeek::detail
@@ -10,10 +10,14 @@
 
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <map>
+#include <unordered_map>
 #include <vector>
 
+#include "zeek/IPAddr.h"
+
 namespace zeek::detail {
 
 // TODO: Anon.h may not be the right place to put these functions ...
@@ -31,6 +35,7 @@ enum ip_addr_anonymization_method_t {
     RANDOM_MD5,
     PREFIX_PRESERVING_A50,
     PREFIX_PRESERVING_MD5,
+    PREFIX_PRESERVING_PRF,
     NUM_ADDR_ANONYMIZATION_METHODS,
 };
 
@@ -80,6 +85,45 @@ protected:
     } prefix;
 };
 
+// Prefix-preserving anonymization along the lines of Crypto-PAn (Fan et al.,
+// "Prefix-Preserving IP Address Anonymization", 2004), using a keyed
+// highwayhash as the pseudo-random function. As the key derives from
+// digest_salt, all nodes of a cluster map addresses the same way. Unlike the
+// other methods, this one supports IPv6.
+//
+// Each output bit takes one PRF evaluation over the preceding input bits.
+// The bits computed for each byte of an address get memoized by the prefix
+// leading up to it, so that addresses sharing a prefix only pay for the
+// bytes in which they differ.
+class AnonymizeIPAddr_PrefixPRF : public AnonymizeIPAddr {
+public:
+    ipaddr32_t anonymize(ipaddr32_t addr) override;
+
+    /**
+     * Anonymizes an address of either family.
+     */
+    IPAddr AnonymizeAddr(const IPAddr& addr);
+
+    // The max number of memoized prefixes, after which the cache starts
+    // over.
+    static constexpr size_t MAX_CACHED_PREFIXES = 1 << 20;
+
+protected:
+    // Anonymizes an address of the given length in bytes, in place.
+    void AnonymizeBytes(uint8_t* bytes, int len);
+
+    // The address length, the index of a byte, and the address's bytes up
+    // to and including that one.
+    using PrefixKey = std::array<uint8_t, 18>;
+
+    struct PrefixKeyHash {
+        size_t operator()(const PrefixKey& k) const;
+    };
+
+    // The bits to flip in the byte following a prefix.
+    std::unordered_map<PrefixKey, uint8_t, PrefixKeyHash> prefixes;
+};
+
 class AnonymizeIPAddr_A50 : public AnonymizeIPAddr {
 public:
     AnonymizeIPAddr_A50() { init(); }
@@ -126,7 +170,15 @@ extern AnonymizeIPAddr* ip_anonymizer[NUM_ADDR_ANONYMIZATION_METHODS];
 void init_ip_addr_anonymizers();
 ipaddr32_t anonymize_ip(ipaddr32_t ip, enum ip_addr_anonymization_class_t cl);
 
+// Anonymizes an address of either family. For IPv6 addresses, the class
+// must use a method that supports them; see ipv6_anonymization_supported().
+IPAddr anonymize_ip(const IPAddr& ip, enum ip_addr_anonymization_class_t cl);
+
+// Returns true if the method configured for a class supports IPv6 addresses.
+bool ipv6_anonymization_supported(enum ip_addr_anonymization_class_t cl);
+
 #define LOG_ANONYMIZATION_MAPPING
 void log_anonymization_mapping(ipaddr32_t input, ipaddr32_t output);
+void log_anonymization_mapping(const IPAddr& input, const IPAddr& output);
 
 } // namespace zeek::detail
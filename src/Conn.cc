@@ -247,8 +247,9 @@ const RecordValPtr& Connection::GetVal() {
         conn_val->Assign(1, std::move(orig_endp));
         conn_val->Assign(2, std::move(resp_endp));
         // 3 and 4 are set below.
-        conn_val->Assign(5, make_intrusive<TableVal>(id::string_set)); // service
-        conn_val->Assign(6, val_mgr->EmptyString());                   // history
+        // 5 (service) is left to the record type's deferred initialization,
+        // so the set only gets created if a script actually accesses it.
+        conn_val->Assign(6, val_mgr->EmptyString()); // history
 
         if ( ! uid )
             uid.Set(zeek::detail::bits_per_uid);
@@ -3,6 +3,7 @@
 #include <netdb.h>
 #include <sys/socket.h>
 #include <cstdint>
+#include <list>
 #include <string>
 
 #include "zeek/IPAddr.h"
@@ -70,6 +71,11 @@ protected:
     ListValPtr addrs_val;
 
     double creation_time = 0.0;
+
+    // Position in the DNS_Mgr's list of cached mappings, if in it.
+    std::list<DNS_Mapping*>::iterator lru_pos;
+    bool cached = false;
+
     bool no_mapping = false; // when initializing from a file, immediately hit EOF
     bool init_failed = false;
     bool failed = false;
@@ -12,8 +12,11 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <algorithm>
+#include <atomic>
 #include <cerrno>
 #include <cstdlib>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 #ifdef TIME_WITH_SYS_TIME
@@ -49,9 +52,6 @@ using ztd::out_ptr::out_ptr;
 // Number of seconds we'll wait for a reply.
 constexpr int DNS_TIMEOUT = 5;
 
-// The maximum allowed number of pending asynchronous requests.
-constexpr int MAX_PENDING_REQUESTS = 20;
-
 // The maximum number of bytes requested via UDP. TCP fallback won't happen on
 // requests until a response is larger than this.
 constexpr int MAX_UDP_BUFFER_SIZE = 4096;
@@ -149,7 +149,7 @@ public:
     int RequestType() const { return request_type; }
     bool IsTxt() const { return request_type == 16; }
 
-    void MakeRequest(ares_channel channel, DNS_Mgr* mgr);
+    bool MakeRequest(ares_channel channel, DNS_Mgr* mgr);
     void ProcessAsyncResult(bool timed_out, DNS_Mgr* mgr);
 
 private:
@@ -173,7 +173,7 @@ DNS_Request::DNS_Request(std::string host, int request_type, bool async)
 
 DNS_Request::DNS_Request(const IPAddr& addr, bool async) : addr(addr), async(async) { request_type = T_PTR; }
 
-void DNS_Request::MakeRequest(ares_channel channel, DNS_Mgr* mgr) {
+bool DNS_Request::MakeRequest(ares_channel channel, DNS_Mgr* mgr) {
     // This needs to get deleted at the end of the callback method.
     auto req_data = std::make_unique<CallbackArgs>();
     req_data->req = this;
@@ -191,6 +191,7 @@ void DNS_Request::MakeRequest(ares_channel channel, DNS_Mgr* mgr) {
         // in the same mapping.
         ares_addrinfo_hints hints = {ARES_AI_CANONNAME, AF_UNSPEC, 0, 0};
         ares_getaddrinfo(channel, host.c_str(), NULL, &hints, addrinfo_cb, req_data.release());
+        return true;
     }
     else {
         std::string query_host;
@@ -205,17 +206,20 @@ void DNS_Request::MakeRequest(ares_channel channel, DNS_Mgr* mgr) {
                                        out_ptr<unsigned char*>(query_str), &len, MAX_UDP_BUFFER_SIZE);
 
         if ( status != ARES_SUCCESS || query_str == nullptr )
-            return;
+            return false;
 
         // Store this so it can be destroyed when the request is destroyed.
         this->query = std::move(query_str);
         ares_send(channel, this->query.get(), len, query_cb, req_data.release());
+        return true;
     }
 }
 
 void DNS_Request::ProcessAsyncResult(bool timed_out, DNS_Mgr* mgr) {
-    if ( ! async )
+    if ( ! async ) {
+        mgr->FinishSyncRequest(this);
         return;
+    }
 
     if ( request_type == T_A )
         mgr->CheckAsyncHostRequest(host, timed_out);
@@ -272,6 +276,20 @@ static int get_ttl(unsigned char* abuf, int alen, int* ttl) {
     return status;
 }
 
+/**
+ * Returns the TTL for caching a failed lookup. Answers saying that a name doesn't
+ * exist, or doesn't have records of the requested type, go into the negative cache.
+ * For other failures, like timeouts, we don't have a TTL from the response data, so
+ * we use DNS_TIMEOUT since it's small enough that the failed response will expire
+ * soon.
+ */
+static uint32_t failure_ttl(DNS_Mgr* mgr, int status) {
+    if ( status == ARES_ENOTFOUND || status == ARES_ENODATA )
+        return mgr->NegativeCacheTTL();
+
+    return DNS_TIMEOUT;
+}
+
 /**
  * Called in response to ares_getaddrinfo requests. Builds a hostent structure from
  * the result data and sends it to the DNS manager via AddResult().
@@ -288,10 +306,7 @@ static void addrinfo_cb(void* arg, int status, int timeouts, struct ares_addrinf
         // anything.
         if ( status != ARES_ECANCELLED && status != ARES_EDESTRUCTION ) {
             // Insert something into the cache so that the request loop will end correctly.
-            // We use the DNS_TIMEOUT value as the TTL here since it's small enough that the
-            // failed response will expire soon, and because we don't have the TTL from the
-            // response data.
-            mgr->AddResult(req, nullptr, DNS_TIMEOUT);
+            mgr->AddResult(req, nullptr, failure_ttl(mgr, status));
         }
     }
     else {
@@ -357,10 +372,7 @@ static void query_cb(void* arg, int status, int timeouts, unsigned char* buf, in
         // anything.
         if ( status != ARES_ECANCELLED && status != ARES_EDESTRUCTION ) {
             // Insert something into the cache so that the request loop will end correctly.
-            // We use the DNS_TIMEOUT value as the TTL here since it's small enough that the
-            // failed response will expire soon, and because we don't have the TTL from the
-            // response data.
-            mgr->AddResult(req, nullptr, DNS_TIMEOUT);
+            mgr->AddResult(req, nullptr, failure_ttl(mgr, status));
         }
     }
     else {
@@ -387,10 +399,8 @@ static void query_cb(void* arg, int status, int timeouts, unsigned char* buf, in
 
                 if ( status == ARES_SUCCESS )
                     mgr->AddResult(req, he.get(), ttl);
-                else {
-                    // See above for why DNS_TIMEOUT here.
-                    mgr->AddResult(req, nullptr, DNS_TIMEOUT);
-                }
+                else
+                    mgr->AddResult(req, nullptr, failure_ttl(mgr, status));
                 break;
             }
             case T_TXT: {
@@ -411,10 +421,8 @@ static void query_cb(void* arg, int status, int timeouts, unsigned char* buf, in
 
                     delete[] he.h_name;
                 }
-                else {
-                    // See above for why DNS_TIMEOUT here.
-                    mgr->AddResult(req, nullptr, DNS_TIMEOUT);
-                }
+                else
+                    mgr->AddResult(req, nullptr, failure_ttl(mgr, r));
 
                 break;
             }
@@ -548,6 +556,10 @@ void DNS_Mgr::InitPostScript() {
     if ( ! doctest::is_running_in_test ) {
         dm_rec = id::find_type<RecordType>("dns_mapping");
 
+        max_pending_requests = std::max<zeek_uint_t>(id::find_const("dns_max_pending_requests")->AsCount(), 1);
+        max_cache_entries = id::find_const("dns_max_cache_entries")->AsCount();
+        negative_cache_ttl = static_cast<uint32_t>(id::find_const("dns_negative_cache_ttl")->AsInterval());
+
         // Registering will call InitSource(), which sets up all of the DNS library stuff
         iosource_mgr->Register(this, true);
     }
@@ -607,8 +619,7 @@ ValPtr DNS_Mgr::Lookup(const std::string& name, int request_type) {
 
     switch ( mode ) {
         case DNS_PRIME: {
-            auto req = new DNS_Request(name, request_type);
-            req->MakeRequest(channel, this);
+            QueueSyncRequest(new DNS_Request(name, request_type));
             return empty_addr_set();
         }
 
@@ -618,8 +629,7 @@ ValPtr DNS_Mgr::Lookup(const std::string& name, int request_type) {
             return nullptr;
 
         case DNS_DEFAULT: {
-            auto req = new DNS_Request(name, request_type);
-            req->MakeRequest(channel, this);
+            QueueSyncRequest(new DNS_Request(name, request_type));
             Resolve();
 
             // Call LookupHost() a second time to get the newly stored value out of the cache.
@@ -652,8 +662,7 @@ TableValPtr DNS_Mgr::LookupHost(const std::string& name) {
         case DNS_PRIME: {
             // We pass T_A here, but DNSRequest::MakeRequest() will special-case that in
             // a request that gets both T_A and T_AAAA results at one time.
-            auto req = new DNS_Request(name, T_A);
-            req->MakeRequest(channel, this);
+            QueueSyncRequest(new DNS_Request(name, T_A));
             return empty_addr_set();
         }
 
@@ -662,8 +671,7 @@ TableValPtr DNS_Mgr::LookupHost(const std::string& name) {
         case DNS_DEFAULT: {
             // We pass T_A here, but DNSRequest::MakeRequest() will special-case that in
             // a request that gets both T_A and T_AAAA results at one time.
-            auto req = new DNS_Request(name, T_A);
-            req->MakeRequest(channel, this);
+            QueueSyncRequest(new DNS_Request(name, T_A));
             Resolve();
 
             // Call LookupHost() a second time to get the newly stored value out of the cache.
@@ -692,8 +700,7 @@ StringValPtr DNS_Mgr::LookupAddr(const IPAddr& addr) {
     // Not found, or priming.
     switch ( mode ) {
         case DNS_PRIME: {
-            auto req = new DNS_Request(addr);
-            req->MakeRequest(channel, this);
+            QueueSyncRequest(new DNS_Request(addr));
             return make_intrusive<StringVal>("<none>");
         }
 
@@ -702,8 +709,7 @@ StringValPtr DNS_Mgr::LookupAddr(const IPAddr& addr) {
             return nullptr;
 
         case DNS_DEFAULT: {
-            auto req = new DNS_Request(addr);
-            req->MakeRequest(channel, this);
+            QueueSyncRequest(new DNS_Request(addr));
             Resolve();
 
             // Call LookupAddr() a second time to get the newly stored value out of the cache.
@@ -828,7 +834,6 @@ void DNS_Mgr::Lookup(const std::string& name, int request_type, LookupCallback*
 }
 
 void DNS_Mgr::Resolve() {
-    int nfds = 0;
     struct timeval *tvp, tv;
     struct pollfd pollfds[ARES_GETSOCK_MAXNUM];
     ares_socket_t socks[ARES_GETSOCK_MAXNUM];
@@ -836,7 +841,14 @@ void DNS_Mgr::Resolve() {
     tv.tv_sec = DNS_TIMEOUT;
     tv.tv_usec = 0;
 
-    for ( int i = 0; i < MAX_PENDING_REQUESTS; i++ ) {
+    // Keep going until all requests are done. c-ares times out requests that
+    // don't get an answer, so this ends eventually.
+    while ( true ) {
+        IssueSyncRequests();
+
+        if ( syncs_pending == 0 && asyncs_pending == 0 )
+            break;
+
         int nfds = 0;
         int bitmap = ares_getsock(channel, socks, ARES_GETSOCK_MAXNUM);
 
@@ -916,41 +928,27 @@ void DNS_Mgr::AddResult(DNS_Request* dr, struct hostent* h, uint32_t ttl, bool m
     DNS_MappingPtr prev_mapping = nullptr;
     bool keep_prev = true;
 
-    MappingMap::iterator it;
-    if ( dr->RequestType() == T_PTR ) {
+    auto key = RequestKey(dr);
+
+    if ( dr->RequestType() == T_PTR )
         new_mapping = std::make_shared<DNS_Mapping>(dr->Addr(), h, ttl);
-        it = all_mappings.find(dr->Addr());
-        if ( it == all_mappings.end() ) {
-            auto result = all_mappings.emplace(dr->Addr(), new_mapping);
-            it = result.first;
-        }
-        else
-            prev_mapping = it->second;
-    }
-    else {
+    else
         new_mapping = std::make_shared<DNS_Mapping>(dr->Host(), h, ttl, dr->RequestType());
-        auto key = std::make_pair(dr->RequestType(), dr->Host());
 
-        it = all_mappings.find(key);
-        if ( it == all_mappings.end() ) {
-            auto result = all_mappings.emplace(std::move(key), new_mapping);
-            it = result.first;
-        }
-        else
-            prev_mapping = it->second;
-    }
+    if ( auto it = all_mappings.find(key); it != all_mappings.end() )
+        prev_mapping = it->second;
 
     if ( prev_mapping && prev_mapping->Valid() ) {
         if ( new_mapping->Valid() ) {
             if ( merge )
                 new_mapping->Merge(prev_mapping);
 
-            it->second = new_mapping;
+            CacheMapping(key, new_mapping);
             keep_prev = false;
         }
     }
     else {
-        it->second = new_mapping;
+        CacheMapping(key, new_mapping);
         keep_prev = false;
     }
 
@@ -1041,9 +1039,9 @@ void DNS_Mgr::LoadCache(const std::string& path) {
     auto m = std::make_shared<DNS_Mapping>(f);
     for ( ; ! m->NoMapping() && ! m->InitFailed(); m = std::make_shared<DNS_Mapping>(f) ) {
         if ( m->ReqHost() )
-            all_mappings.insert_or_assign(std::make_pair(m->ReqType(), m->ReqHost()), m);
+            CacheMapping(std::make_pair(m->ReqType(), m->ReqHost()), m);
         else
-            all_mappings.insert_or_assign(m->ReqAddr(), m);
+            CacheMapping(m->ReqAddr(), m);
     }
 
     if ( ! m->NoMapping() )
@@ -1086,8 +1084,10 @@ TableValPtr DNS_Mgr::LookupNameInCache(const std::string& name, bool cleanup_exp
     if ( ! d || d->names.empty() )
         return nullptr;
 
+    TouchMapping(d.get());
+
     if ( cleanup_expired && (d && d->Expired()) ) {
-        all_mappings.erase(it);
+        UncacheMapping(it);
 
         // If the TTL is zero, we're immediately expiring the response. We don't want
         // to return though because the response was valid for a brief moment in time.
@@ -1109,9 +1109,10 @@ StringValPtr DNS_Mgr::LookupAddrInCache(const IPAddr& addr, bool cleanup_expired
         return nullptr;
 
     auto d = it->second;
+    TouchMapping(d.get());
 
     if ( cleanup_expired && d->Expired() ) {
-        all_mappings.erase(it);
+        UncacheMapping(it);
 
         // If the TTL is zero, we're immediately expiring the response. We don't want
         // to return though because the response was valid for a brief moment in time.
@@ -1136,9 +1137,10 @@ StringValPtr DNS_Mgr::LookupOtherInCache(const std::string& name, int request_ty
         return nullptr;
 
     auto d = it->second;
+    TouchMapping(d.get());
 
     if ( cleanup_expired && d->Expired() ) {
-        all_mappings.erase(it);
+        UncacheMapping(it);
 
         // If the TTL is zero, we're immediately expiring the response. We don't want
         // to return though because the response was valid for a brief moment in time.
@@ -1153,7 +1155,7 @@ StringValPtr DNS_Mgr::LookupOtherInCache(const std::string& name, int request_ty
 }
 
 void DNS_Mgr::IssueAsyncRequests() {
-    while ( ! asyncs_queued.empty() && asyncs_pending < MAX_PENDING_REQUESTS ) {
+    while ( ! asyncs_queued.empty() && asyncs_pending < max_pending_requests ) {
         DNS_Request* dns_req = nullptr;
         AsyncRequest* req = asyncs_queued.front();
         asyncs_queued.pop_front();
@@ -1170,12 +1172,100 @@ void DNS_Mgr::IssueAsyncRequests() {
         else
             dns_req = new DNS_Request(req->host.c_str(), req->type, true);
 
-        dns_req->MakeRequest(channel, this);
-
         ++asyncs_pending;
+
+        if ( ! dns_req->MakeRequest(channel, this) ) {
+            // Fail the request right away rather than having it hang around.
+            dns_req->ProcessAsyncResult(true, this);
+            delete dns_req;
+        }
+    }
+}
+
+void DNS_Mgr::QueueSyncRequest(DNS_Request* dr) {
+    // When priming, scripts may well ask for the same name repeatedly.
+    if ( ! syncs_active.insert(RequestKey(dr)).second ) {
+        delete dr;
+        return;
+    }
+
+    syncs_queued.push_back(dr);
+}
+
+void DNS_Mgr::IssueSyncRequests() {
+    while ( ! syncs_queued.empty() && syncs_pending < max_pending_requests ) {
+        auto dr = syncs_queued.front();
+        syncs_queued.pop_front();
+        ++syncs_pending;
+
+        if ( ! dr->MakeRequest(channel, this) ) {
+            // Insert a failure so that lookups waiting for the result find one.
+            AddResult(dr, nullptr, DNS_TIMEOUT);
+            FinishSyncRequest(dr);
+            delete dr;
+        }
+    }
+}
+
+void DNS_Mgr::FinishSyncRequest(const DNS_Request* dr) {
+    syncs_active.erase(RequestKey(dr));
+    --syncs_pending;
+}
+
+DNS_Mgr::MappingKey DNS_Mgr::RequestKey(const DNS_Request* dr) {
+    if ( dr->RequestType() == T_PTR )
+        return dr->Addr();
+
+    return std::make_pair(dr->RequestType(), dr->Host());
+}
+
+void DNS_Mgr::CacheMapping(const MappingKey& key, DNS_MappingPtr mapping) {
+    auto [it, inserted] = all_mappings.try_emplace(key, nullptr);
+
+    if ( ! inserted && it->second ) {
+        mapping_lru.erase(it->second->lru_pos);
+        it->second->cached = false;
+    }
+
+    mapping_lru.push_front(mapping.get());
+    mapping->lru_pos = mapping_lru.begin();
+    mapping->cached = true;
+    it->second = std::move(mapping);
+
+    while ( max_cache_entries > 0 && all_mappings.size() > max_cache_entries ) {
+        auto victim = mapping_lru.back();
+        MappingKey victim_key = victim->ReqAddr();
+
+        if ( victim->ReqType() != T_PTR )
+            victim_key = std::make_pair(victim->ReqType(), victim->req_host);
+
+        if ( auto i = all_mappings.find(victim_key); i != all_mappings.end() && i->second.get() == victim )
+            UncacheMapping(i);
+        else {
+            // Shouldn't happen, but don't loop forever if it does.
+            mapping_lru.pop_back();
+            victim->cached = false;
+            break;
+        }
+
+        ++evicted;
     }
 }
 
+DNS_Mgr::MappingMap::iterator DNS_Mgr::UncacheMapping(MappingMap::iterator it) {
+    if ( auto& m = it->second ) {
+        mapping_lru.erase(m->lru_pos);
+        m->cached = false;
+    }
+
+    return all_mappings.erase(it);
+}
+
+void DNS_Mgr::TouchMapping(DNS_Mapping* mapping) {
+    if ( mapping->cached )
+        mapping_lru.splice(mapping_lru.begin(), mapping_lru, mapping->lru_pos);
+}
+
 void DNS_Mgr::CheckAsyncHostRequest(const std::string& host, bool timeout) {
     // Note that this code is a mirror of that for CheckAsyncAddrRequest.
     auto i = asyncs.find(std::make_pair(T_A, host));
@@ -1247,7 +1337,14 @@ void DNS_Mgr::CheckAsyncOtherRequest(const std::string& host, bool timeout, int
 
 void DNS_Mgr::Flush() {
     Resolve();
+
+    for ( auto& [key, mapping] : all_mappings ) {
+        if ( mapping )
+            mapping->cached = false;
+    }
+
     all_mappings.clear();
+    mapping_lru.clear();
 }
 
 double DNS_Mgr::GetNextTimeout() {
@@ -1304,6 +1401,7 @@ void DNS_Mgr::GetStats(Stats* stats) {
     stats->cached_addresses = 0;
     stats->cached_texts = 0;
     stats->cached_total = all_mappings.size();
+    stats->cache_evictions = evicted;
 
     for ( const auto& [key, mapping] : all_mappings ) {
         if ( mapping->ReqType() == T_PTR )
@@ -1415,6 +1513,15 @@ class TestDNS_Mgr final : public DNS_Mgr {
 public:
     explicit TestDNS_Mgr(DNS_MgrMode mode) : DNS_Mgr(mode) {}
     void Process() override;
+
+    void SetLimits(int max_pending, size_t max_entries) {
+        max_pending_requests = max_pending;
+        max_cache_entries = max_entries;
+    }
+
+    void SetNegativeCacheTTL(uint32_t ttl) { negative_cache_ttl = ttl; }
+
+    void IssueAsyncRequests() { DNS_Mgr::IssueAsyncRequests(); }
 };
 
 void TestDNS_Mgr::Process() {
@@ -1669,4 +1776,249 @@ TEST_CASE("dns_mgr async timeouts" * doctest::skip(true)) {
         unsetenv("ZEEK_DNS_RESOLVER");
 }
 
+/**
+ * A minimal DNS server on the loopback interface for tests that shouldn't depend on
+ * the network. It answers A queries for stub.zeek.test and responds with NXDOMAIN
+ * to everything else, counting the queries it receives per name.
+ */
+class StubResolver {
+public:
+    StubResolver() {
+        fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+        struct sockaddr_in sa = {};
+        sa.sin_family = AF_INET;
+        sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        socklen_t len = sizeof(sa);
+        bind(fd, reinterpret_cast<struct sockaddr*>(&sa), len);
+        getsockname(fd, reinterpret_cast<struct sockaddr*>(&sa), &len);
+        port = ntohs(sa.sin_port);
+
+        thread = std::thread(&StubResolver::Run, this);
+    }
+
+    ~StubResolver() {
+        done = true;
+        thread.join();
+        close(fd);
+    }
+
+    // Points a manager's channel at this server.
+    void Use(DNS_Mgr* mgr) {
+        auto server = util::fmt("127.0.0.1:%d", port);
+        ares_set_servers_ports_csv(mgr->GetChannel(), server);
+    }
+
+    // Returns how often the server has seen queries of a type for a name.
+    int Queries(const std::string& name, int type) {
+        std::lock_guard<std::mutex> lock(mtx);
+        return queries[std::make_pair(name, type)];
+    }
+
+private:
+    void Run() {
+        while ( ! done ) {
+            struct pollfd pfd = {fd, POLLIN, 0};
+            if ( poll(&pfd, 1, 50) <= 0 )
+                continue;
+
+            unsigned char buf[512];
+            struct sockaddr_in from = {};
+            socklen_t from_len = sizeof(from);
+            auto n = recvfrom(fd, buf, sizeof(buf), 0, reinterpret_cast<struct sockaddr*>(&from), &from_len);
+
+            if ( n < HFIXEDSZ )
+                continue;
+
+            // Parse the question's name.
+            std::string name;
+            ssize_t pos = HFIXEDSZ;
+            while ( pos < n && buf[pos] != 0 ) {
+                int label_len = buf[pos++];
+                if ( pos + label_len > n )
+                    break;
+
+                if ( ! name.empty() )
+                    name += '.';
+
+                name.append(reinterpret_cast<char*>(buf + pos), label_len);
+                pos += label_len;
+            }
+
+            if ( pos + 1 + QFIXEDSZ > n )
+                continue;
+
+            pos += 1 + QFIXEDSZ;
+            int type = DNS_QUESTION_TYPE(buf + pos - QFIXEDSZ);
+
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                ++queries[std::make_pair(name, type)];
+            }
+
+            // Reply with the question, dropping anything after it like EDNS options.
+            std::vector<unsigned char> reply(buf, buf + pos);
+            DNS_HEADER_SET_QR(reply.data(), 1);
+            DNS_HEADER_SET_RA(reply.data(), 1);
+            DNS_HEADER_SET_ARCOUNT(reply.data(), 0);
+
+            if ( name != "stub.zeek.test" )
+                DNS_HEADER_SET_RCODE(reply.data(), NXDOMAIN);
+
+            else if ( type == T_A ) {
+                DNS_HEADER_SET_ANCOUNT(reply.data(), 1);
+
+                // Name pointer to the question, type A, class IN, TTL 300,
+                // and 10.0.0.1.
+                const unsigned char answer[] = {0xc0, HFIXEDSZ, 0, T_A, 0, C_IN, 0, 0, 1, 0x2c, 0, 4, 10, 0, 0, 1};
+                reply.insert(reply.end(), answer, answer + sizeof(answer));
+            }
+
+            sendto(fd, reply.data(), reply.size(), 0, reinterpret_cast<struct sockaddr*>(&from), from_len);
+        }
+    }
+
+    int fd = -1;
+    int port = 0;
+    std::atomic<bool> done = false;
+    std::thread thread;
+    std::mutex mtx;
+    std::map<std::pair<std::string, int>, int> queries;
+};
+
+// Runs the manager until the callbacks are done, bounded in case of failures.
+static void process_until_done(TestDNS_Mgr& mgr, const std::vector<TestCallback*>& cbs) {
+    for ( int i = 0; i < 100; ++i ) {
+        if ( std::all_of(cbs.begin(), cbs.end(), [](auto cb) { return cb->done; }) )
+            return;
+
+        mgr.Process();
+        usleep(10000);
+    }
+}
+
+TEST_CASE("dns_mgr stub resolver coalescing") {
+    StubResolver stub;
+    TestDNS_Mgr mgr(DNS_DEFAULT);
+    mgr.InitPostScript();
+    stub.Use(&mgr);
+
+    TestCallback cb1{};
+    TestCallback cb2{};
+    mgr.LookupHost("stub.zeek.test", &cb1);
+    mgr.LookupHost("stub.zeek.test", &cb2);
+    process_until_done(mgr, {&cb1, &cb2});
+
+    REQUIRE(cb1.done);
+    REQUIRE(cb2.done);
+    CHECK_FALSE(cb1.timeout);
+    REQUIRE(cb1.addr_results.size() == 1);
+    CHECK(cb1.addr_results[0] == IPAddr("10.0.0.1"));
+    CHECK(cb2.addr_results == cb1.addr_results);
+
+    // Both lookups shared a single query.
+    CHECK(stub.Queries("stub.zeek.test", T_A) == 1);
+
+    // Later lookups get answered from the cache.
+    auto result = mgr.LookupHost("stub.zeek.test");
+    REQUIRE(result != nullptr);
+    CHECK(get_result_addresses(result).size() == 1);
+    CHECK(stub.Queries("stub.zeek.test", T_A) == 1);
+
+    mgr.Flush();
+}
+
+TEST_CASE("dns_mgr stub resolver negative cache") {
+    StubResolver stub;
+    TestDNS_Mgr mgr(DNS_DEFAULT);
+    mgr.InitPostScript();
+    stub.Use(&mgr);
+
+    IPAddr addr("10.0.0.2");
+    auto result = mgr.LookupAddr(addr);
+    REQUIRE(result != nullptr);
+    CHECK(strcmp(result->CheckString(), "10.0.0.2") == 0);
+    CHECK(stub.Queries(addr.PtrName(), T_PTR) == 1);
+
+    // The failure is remembered rather than asked for again.
+    result = mgr.LookupAddr(addr);
+    REQUIRE(result != nullptr);
+    CHECK(strcmp(result->CheckString(), "10.0.0.2") == 0);
+    CHECK(stub.Queries(addr.PtrName(), T_PTR) == 1);
+
+    mgr.Flush();
+}
+
+TEST_CASE("dns_mgr stub resolver negative cache expiration") {
+    StubResolver stub;
+    TestDNS_Mgr mgr(DNS_DEFAULT);
+    mgr.InitPostScript();
+    stub.Use(&mgr);
+
+    // Shorter than DNS_TIMEOUT, which other failures get cached for, so
+    // that this only passes if the negative TTL applies.
+    mgr.SetNegativeCacheTTL(1);
+
+    IPAddr addr("10.0.0.3");
+
+    TestCallback cb1{};
+    mgr.LookupAddr(addr, &cb1);
+    process_until_done(mgr, {&cb1});
+    REQUIRE(cb1.done);
+    CHECK_FALSE(cb1.timeout);
+    CHECK(stub.Queries(addr.PtrName(), T_PTR) == 1);
+
+    TestCallback cb2{};
+    mgr.LookupAddr(addr, &cb2);
+    process_until_done(mgr, {&cb2});
+    REQUIRE(cb2.done);
+    CHECK(stub.Queries(addr.PtrName(), T_PTR) == 1);
+
+    // Once the negative TTL has passed, the next lookup asks again.
+    usleep(1500000);
+
+    TestCallback cb3{};
+    mgr.LookupAddr(addr, &cb3);
+    process_until_done(mgr, {&cb3});
+    REQUIRE(cb3.done);
+    CHECK_FALSE(cb3.timeout);
+    CHECK(stub.Queries(addr.PtrName(), T_PTR) == 2);
+
+    mgr.Flush();
+}
+
+TEST_CASE("dns_mgr stub resolver limits") {
+    StubResolver stub;
+    TestDNS_Mgr mgr(DNS_DEFAULT);
+    mgr.InitPostScript();
+    mgr.SetLimits(1, 2);
+    stub.Use(&mgr);
+
+    std::vector<TestCallback> cbs(3);
+    std::vector<TestCallback*> cb_ptrs;
+
+    for ( int i = 0; i < 3; ++i ) {
+        mgr.LookupAddr(IPAddr(util::fmt("10.0.1.%d", i)), &cbs[i]);
+        cb_ptrs.push_back(&cbs[i]);
+    }
+
+    // Only one request goes out at a time.
+    DNS_Mgr::Stats stats;
+    mgr.GetStats(&stats);
+    CHECK(stats.pending == 1);
+
+    process_until_done(mgr, cb_ptrs);
+
+    for ( const auto& cb : cbs )
+        CHECK(cb.done);
+
+    // The cache keeps only the two most recent results.
+    mgr.GetStats(&stats);
+    CHECK(stats.cached_total == 2);
+    CHECK(stats.cache_evictions == 1);
+
+    mgr.Flush();
+}
+
 } // namespace zeek::detail
@@ -6,6 +6,7 @@
 #include <list>
 #include <map>
 #include <queue>
+#include <set>
 #include <utility>
 #include <variant>
 
@@ -207,6 +208,7 @@ public:
         unsigned long cached_addresses;
         unsigned long cached_texts;
         unsigned long cached_total;
+        unsigned long cache_evictions;
     };
 
     /**
@@ -247,6 +249,12 @@ public:
 
     ares_channel& GetChannel() { return channel; }
 
+    /**
+     * Returns the TTL to cache a lookup for when the name or address turns
+     * out not to exist, or to have no records of the requested type.
+     */
+    uint32_t NegativeCacheTTL() const { return negative_cache_ttl; }
+
 protected:
     friend class LookupCallback;
     friend class DNS_Request;
@@ -275,9 +283,29 @@ protected:
     void LoadCache(const std::string& path);
     void Save(FILE* f, const MappingMap& m);
 
+    static MappingKey RequestKey(const DNS_Request* dr);
+
+    // Adds a mapping to the cache, replacing any previous one for the same
+    // key. If the cache grows beyond its limit, this evicts the least
+    // recently used mappings.
+    void CacheMapping(const MappingKey& key, DNS_MappingPtr mapping);
+
+    // Removes a mapping from the cache, returning the next one.
+    MappingMap::iterator UncacheMapping(MappingMap::iterator it);
+
+    // Marks a cached mapping as most recently used.
+    void TouchMapping(DNS_Mapping* mapping);
+
     // Issue as many queued async requests as slots are available.
     void IssueAsyncRequests();
 
+    // Queues a request made from one of the synchronous lookup methods,
+    // unless one for the same name or address is already underway. Resolve()
+    // issues queued requests as slots become available.
+    void QueueSyncRequest(DNS_Request* dr);
+    void IssueSyncRequests();
+    void FinishSyncRequest(const DNS_Request* dr);
+
     // IOSource interface.
     void Process() override;
     void ProcessFd(int fd, int flags) override;
@@ -327,9 +355,24 @@ protected:
     using QueuedList = std::list<AsyncRequest*>;
     QueuedList asyncs_queued;
 
+    using SyncRequestList = std::list<DNS_Request*>;
+    SyncRequestList syncs_queued;
+    std::set<MappingKey> syncs_active; // Both queued and pending ones.
+    int syncs_pending = 0;
+
+    // Cached mappings, most recently used first.
+    std::list<DNS_Mapping*> mapping_lru;
+
+    // Limits, configurable through script-level options once those
+    // are available.
+    int max_pending_requests = 20;
+    size_t max_cache_entries = 100000;
+    uint32_t negative_cache_ttl = 5;
+
     unsigned long num_requests = 0;
     unsigned long successful = 0;
     unsigned long failed = 0;
+    unsigned long evicted = 0;
 
     std::set<int> socket_fds;
     std::set<int> write_socket_fds;
@@ -7,6 +7,7 @@
 #include "zeek/Desc.h"
 #include "zeek/Func.h"
 #include "zeek/NetVar.h"
+#include "zeek/SubsystemStats.h"
 #include "zeek/Trigger.h"
 #include "zeek/Val.h"
 #include "zeek/iosource/Manager.h"
@@ -51,6 +52,8 @@ void Event::Dispatch(bool no_remote) {
     if ( handler->ErrorHandler() )
         reporter->BeginErrorHandler();
 
+    detail::SubsystemScope scope(detail::Subsystem::Event, handler->Name());
+
     try {
         handler->Call(&args, no_remote, ts);
     }
@@ -1,5 +1,7 @@
 #include "zeek/EventHandler.h"
 
+#include <chrono>
+
 #include "zeek/Desc.h"
 #include "zeek/Event.h"
 #include "zeek/Func.h"
@@ -91,9 +93,63 @@ void EventHandler::Call(Args* vl, bool no_remote, double ts) {
         }
     }
 
-    if ( local )
+    if ( ! local )
+        return;
+
+    if ( ! detail::event_handler_timing && detail::slow_event_handler_threshold <= 0.0 ) {
         // No try/catch here; we pass exceptions upstream.
         local->Invoke(vl);
+        return;
+    }
+
+    // Invocations aborted by an exception don't get timed.
+    auto start = std::chrono::steady_clock::now();
+    local->Invoke(vl);
+    RecordTime(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+}
+
+void EventHandler::RecordTime(double t) {
+    bool new_max = t > max_time;
+    auto prev_max = max_time;
+
+    if ( new_max )
+        max_time = t;
+
+    if ( detail::event_handler_timing ) {
+        if ( ! timing_metrics ) {
+            static auto total_family =
+                telemetry_mgr->CounterFamily<double>("zeek", "event-handler-time", {"name"},
+                                                     "Total time spent in the given event handler", "seconds", true);
+            static auto max_family = telemetry_mgr->GaugeFamily<double>(
+                "zeek", "event-handler-max-time", {"name"}, "Longest single invocation of the given event handler",
+                "seconds");
+
+            static const double latency_bounds[] = {0.00001, 0.0001, 0.001, 0.01, 0.1, 1.0};
+            static auto latency_family = telemetry_mgr->HistogramFamily<double>(
+                "zeek", "event-handler-latency", {"name"}, latency_bounds,
+                "Time spent in individual invocations of the given event handler", "seconds");
+
+            timing_metrics.emplace(TimingMetrics{total_family.GetOrAdd({{"name", name}}),
+                                                 max_family.GetOrAdd({{"name", name}}),
+                                                 latency_family.GetOrAdd({{"name", name}})});
+
+            // The gauge starts out at zero.
+            prev_max = 0.0;
+            new_max = true;
+        }
+
+        timing_metrics->total.Inc(t);
+        timing_metrics->latency.Observe(t);
+
+        if ( new_max )
+            timing_metrics->max.Inc(max_time - prev_max);
+    }
+
+    // To not flood the reporter with a handler that's consistently slow,
+    // we only warn when it sets a new record.
+    if ( detail::slow_event_handler_threshold > 0.0 && t >= detail::slow_event_handler_threshold && new_max )
+        reporter->Warning("event handler for %s took %.6f seconds, exceeding slow_event_handler_threshold", Name(),
+                          t);
 }
 
 void EventHandler::NewEvent(Args* vl) {
@@ -10,6 +10,8 @@
 #include "zeek/ZeekArgs.h"
 #include "zeek/ZeekList.h"
 #include "zeek/telemetry/Counter.h"
+#include "zeek/telemetry/Gauge.h"
+#include "zeek/telemetry/Histogram.h"
 
 namespace zeek {
 
@@ -62,9 +64,17 @@ public:
 
     uint64_t CallCount() const { return call_count ? call_count->Value() : 0; }
 
+    // Returns the longest time a single invocation of the handler took
+    // so far. Only tracked if event_handler_timing or
+    // slow_event_handler_threshold is set.
+    double MaxTime() const { return max_time; }
+
 private:
     void NewEvent(zeek::Args* vl); // Raise new_event() meta event.
 
+    // Accounts for an invocation that took the given number of seconds.
+    void RecordTime(double t);
+
     std::string name;
     FuncPtr local;
     FuncTypePtr type;
@@ -76,6 +86,15 @@ private:
     // Initialize this lazy, so we don't expose metrics for 0 values.
     std::optional<zeek::telemetry::IntCounter> call_count;
 
+    struct TimingMetrics {
+        zeek::telemetry::DblCounter total;
+        zeek::telemetry::DblGauge max;
+        zeek::telemetry::DblHistogram latency;
+    };
+
+    std::optional<TimingMetrics> timing_metrics;
+    double max_time = 0.0;
+
     std::unordered_set<std::string> auto_publish;
 };
 
@@ -2,6 +2,8 @@
 
 #include "zeek/Frag.h"
 
+#include <algorithm>
+
 #include "zeek/zeek-config.h"
 
 #include "zeek/Hash.h"
@@ -14,6 +16,13 @@
 constexpr uint32_t MIN_ACCEPTABLE_FRAG_SIZE = 64;
 constexpr uint32_t MAX_ACCEPTABLE_FRAG_SIZE = 64000;
 
+// Size of the buffer for an IPv4 header, see FragReassembler's constructor.
+constexpr uint32_t IP4_HDR_BUFFER_SIZE = 64;
+
+// Approximate bookkeeping cost of a block in the block list: the map
+// node's value plus its color, parent, and child pointers.
+constexpr uint64_t BLOCK_OVERHEAD = sizeof(zeek::DataBlockMap::value_type) + 4 * sizeof(void*);
+
 namespace zeek::detail {
 
 FragTimer::~FragTimer() {
@@ -37,7 +46,7 @@ FragReassembler::FragReassembler(session::Manager* arg_s, const std::shared_ptr<
     const struct ip* ip4 = ip->IP4_Hdr();
     if ( ip4 ) {
         proto_hdr_len = ip->HdrLen();
-        proto_hdr = new u_char[64]; // max IP header + slop
+        proto_hdr = new u_char[IP4_HDR_BUFFER_SIZE]; // max IP header + slop
         // Don't do a structure copy - need to pick up options, too.
         memcpy((void*)proto_hdr, (const void*)ip4, proto_hdr_len);
     }
@@ -63,6 +72,7 @@ FragReassembler::FragReassembler(session::Manager* arg_s, const std::shared_ptr<
 
 FragReassembler::~FragReassembler() {
     DeleteTimer();
+    ReleaseFirstFragment();
     delete[] proto_hdr;
 }
 
@@ -98,6 +108,14 @@ void FragReassembler::AddFragment(double t, const std::shared_ptr<IP_Hdr>& ip, c
 
     uint64_t upper_seq = offset + len - hdr_len;
 
+    if ( completed_pkt ) {
+        // Check against what we've reassembled already, before anything
+        // below adjusts frag_size: the completed packet holds only that
+        // much data.
+        CheckCompleted(offset, len - hdr_len, pkt + hdr_len, ! ip->MF());
+        return;
+    }
+
     if ( ! offset )
         // Make sure to use the first fragment header's next field.
         next_proto = ip->NextProto();
@@ -138,9 +156,120 @@ void FragReassembler::AddFragment(double t, const std::shared_ptr<IP_Hdr>& ip, c
     pkt += hdr_len;
     len -= hdr_len;
 
+    if ( fast_path && FastPathFragment(offset, len, pkt) )
+        return;
+
     NewBlock(run_state::network_time, offset, len, pkt);
 }
 
+bool FragReassembler::FastPathFragment(uint64_t seq, uint64_t len, const u_char* data) {
+    if ( ! first_frag ) {
+        if ( frag_size && seq == 0 && len == frag_size ) {
+            // All in one, e.g. an IPv6 atomic fragment.
+            uint64_t n = proto_hdr_len + len;
+            u_char* pkt = new u_char[n];
+            memcpy(pkt, proto_hdr, proto_hdr_len);
+            memcpy(pkt + proto_hdr_len, data, len);
+            fast_path = false;
+            FinishPacket(pkt, n);
+            completed_pkt = reassembled_pkt;
+            completed_len = len;
+            return true;
+        }
+
+        first_frag = fragment_mgr->GetBuffer(len);
+        memcpy(first_frag, data, len);
+        first_frag_seq = seq;
+        first_frag_len = len;
+        return true;
+    }
+
+    // This is the second fragment. The common case is that the two of
+    // them make up the whole datagram, without overlap.
+    const u_char* lower = first_frag;
+    uint64_t lower_len = first_frag_len;
+    const u_char* upper = data;
+    uint64_t upper_seq = seq;
+    uint64_t upper_len = len;
+
+    if ( seq < first_frag_seq ) {
+        std::swap(lower, upper);
+        std::swap(lower_len, upper_len);
+        upper_seq = first_frag_seq;
+    }
+
+    if ( ! frag_size || (seq < first_frag_seq ? seq : first_frag_seq) != 0 || lower_len != upper_seq ||
+         upper_seq + upper_len != frag_size ) {
+        LeaveFastPath();
+        return false;
+    }
+
+    uint64_t n = proto_hdr_len + frag_size;
+    u_char* pkt = new u_char[n];
+    memcpy(pkt, proto_hdr, proto_hdr_len);
+    memcpy(pkt + proto_hdr_len, lower, lower_len);
+    memcpy(pkt + proto_hdr_len + upper_seq, upper, upper_len);
+
+    fast_path = false;
+    ReleaseFirstFragment();
+    FinishPacket(pkt, n);
+    completed_pkt = reassembled_pkt;
+    completed_len = frag_size;
+    return true;
+}
+
+void FragReassembler::CheckCompleted(uint64_t seq, uint64_t len, const u_char* data, bool last) {
+    // Like the generic path, report data that differs from or repeats
+    // what we've reassembled already.
+    if ( seq < completed_len ) {
+        auto hdr = completed_pkt->IP4_Hdr() ? reinterpret_cast<const u_char*>(completed_pkt->IP4_Hdr()) :
+                                              reinterpret_cast<const u_char*>(completed_pkt->IP6_Hdr());
+        auto n = std::min(seq + len, completed_len) - seq;
+        Overlap(hdr + proto_hdr_len + seq, data, n);
+    }
+
+    if ( seq + len > completed_len || (last && seq + len != completed_len) )
+        Weird("fragment_size_inconsistency");
+}
+
+void FragReassembler::LeaveFastPath() {
+    fast_path = false;
+
+    if ( ! first_frag )
+        return;
+
+    // Release the buffer only afterwards, as this may already complete the
+    // datagram.
+    NewBlock(run_state::network_time, first_frag_seq, first_frag_len, first_frag);
+    ReleaseFirstFragment();
+}
+
+uint64_t FragReassembler::MemoryUsage() const {
+    uint64_t usage = sizeof(*this) + block_list.DataSize() + block_list.NumBlocks() * BLOCK_OVERHEAD;
+
+    usage += ((const struct ip*)proto_hdr)->ip_v == 4 ? IP4_HDR_BUFFER_SIZE : proto_hdr_len;
+
+    if ( expire_timer )
+        usage += sizeof(FragTimer);
+
+    if ( first_frag )
+        usage += FragmentManager::BufferSize(first_frag_len);
+
+    if ( completed_pkt )
+        usage += sizeof(IP_Hdr) + proto_hdr_len + completed_len;
+
+    return usage;
+}
+
+void FragReassembler::ReleaseFirstFragment() {
+    if ( ! first_frag )
+        return;
+
+    fragment_mgr->ReleaseBuffer(first_frag, first_frag_len);
+    first_frag = nullptr;
+    first_frag_len = 0;
+}
+
 void FragReassembler::Weird(const char* name) const {
     unsigned int version = ((const ip*)proto_hdr)->ip_v;
 
@@ -257,7 +386,12 @@ void FragReassembler::BlockInserted(DataBlockMap::const_iterator /* it */) {
         memcpy(&pkt[b.seq], b.block, b.upper - b.seq);
     }
 
+    FinishPacket(pkt_start, n);
+}
+
+void FragReassembler::FinishPacket(u_char* pkt_start, uint64_t n) {
     reassembled_pkt.reset();
+    completed = true;
 
     unsigned int version = ((const struct ip*)pkt_start)->ip_v;
 
@@ -298,7 +432,12 @@ void FragReassembler::DeleteTimer() {
     }
 }
 
-FragmentManager::~FragmentManager() { Clear(); }
+FragmentManager::~FragmentManager() {
+    Clear();
+
+    for ( auto buf : buffer_pool )
+        delete[] buf;
+}
 
 FragReassembler* FragmentManager::NextFragment(double t, const std::shared_ptr<IP_Hdr>& ip, const u_char* pkt) {
     uint32_t frag_id = ip->ID();
@@ -312,20 +451,50 @@ FragReassembler* FragmentManager::NextFragment(double t, const std::shared_ptr<I
     if ( ! f ) {
         f = new FragReassembler(session_mgr, ip, pkt, key, t);
         fragments[key] = f;
+        f->lru_pos = lru.insert(lru.end(), f);
         if ( fragments.size() > max_fragments )
             max_fragments = fragments.size();
-        return f;
     }
+    else
+        f->AddFragment(t, ip, pkt);
 
-    f->AddFragment(t, ip, pkt);
+    auto usage = f->MemoryUsage();
+    total_bytes = total_bytes - f->accounted_bytes + usage;
+    f->accounted_bytes = usage;
+
+    Evict(f);
     return f;
 }
 
+void FragmentManager::Evict(FragReassembler* keep) {
+    if ( ! frag_memory_limit )
+        return;
+
+    while ( total_bytes > frag_memory_limit ) {
+        auto it = lru.begin();
+
+        if ( it != lru.end() && *it == keep )
+            ++it;
+
+        if ( it == lru.end() )
+            break;
+
+        // Datagrams that got reassembled already don't count, they're
+        // just waiting for their removal.
+        if ( ! (*it)->completed )
+            ++evictions;
+
+        Remove(*it);
+    }
+}
+
 void FragmentManager::Clear() {
     for ( const auto& entry : fragments )
         Unref(entry.second);
 
     fragments.clear();
+    lru.clear();
+    total_bytes = 0;
 }
 
 void FragmentManager::Remove(detail::FragReassembler* f) {
@@ -334,8 +503,31 @@ void FragmentManager::Remove(detail::FragReassembler* f) {
 
     if ( fragments.erase(f->Key()) == 0 )
         reporter->InternalWarning("fragment reassembler not in dict");
+    else {
+        lru.erase(f->lru_pos);
+        total_bytes -= f->accounted_bytes;
+    }
 
     Unref(f);
 }
 
+u_char* FragmentManager::GetBuffer(size_t len) {
+    if ( len > POOL_BUFFER_SIZE )
+        return new u_char[len];
+
+    if ( buffer_pool.empty() )
+        return new u_char[POOL_BUFFER_SIZE];
+
+    auto buf = buffer_pool.back();
+    buffer_pool.pop_back();
+    return buf;
+}
+
+void FragmentManager::ReleaseBuffer(u_char* buf, size_t len) {
+    if ( len <= POOL_BUFFER_SIZE && buffer_pool.size() < MAX_POOLED_BUFFERS )
+        buffer_pool.push_back(buf);
+    else
+        delete[] buf;
+}
+
 } // namespace zeek::detail
@@ -3,7 +3,9 @@
 #pragma once
 
 #include <sys/types.h> // for u_char
+#include <list>
 #include <tuple>
+#include <vector>
 
 #include "zeek/IPAddr.h"
 #include "zeek/Reassem.h"
@@ -40,11 +42,38 @@ public:
     std::shared_ptr<IP_Hdr> ReassembledPkt() { return std::move(reassembled_pkt); }
     const FragReassemblerKey& Key() const { return key; }
 
+    // Returns the number of bytes of memory held, including the fragment
+    // data's buffers and the bookkeeping around them.
+    uint64_t MemoryUsage() const;
+
 protected:
+    friend class FragmentManager;
+
     void BlockInserted(DataBlockMap::const_iterator it) override;
     void Overlap(const u_char* b1, const u_char* b2, uint64_t n) override;
     void Weird(const char* name) const;
 
+    // Handles a fragment without going through the block list, as long as
+    // we've seen at most two. Returns false if the generic path needs to
+    // take over.
+    bool FastPathFragment(uint64_t seq, uint64_t len, const u_char* data);
+
+    // Moves the first fragment from the fast path into the block list.
+    void LeaveFastPath();
+
+    // Returns the first fragment's buffer to the pool.
+    void ReleaseFirstFragment();
+
+    // Checks a fragment arriving after the fast path completed the
+    // datagram against the reassembled data. "last" is true if the
+    // fragment claims to end the datagram.
+    void CheckCompleted(uint64_t seq, uint64_t len, const u_char* data, bool last);
+
+    // Turns a buffer of n bytes holding the reassembled datagram, starting
+    // with the copied header, into the reassembled packet. Takes ownership
+    // of the buffer.
+    void FinishPacket(u_char* pkt, uint64_t n);
+
     u_char* proto_hdr;
     std::shared_ptr<IP_Hdr> reassembled_pkt;
     session::Manager* s;
@@ -54,6 +83,25 @@ protected:
     uint16_t proto_hdr_len;
 
     FragTimer* expire_timer;
+
+    // The fast path holds the first fragment here rather than in the block
+    // list, in a buffer from the FragmentManager's pool.
+    bool fast_path = true;
+    u_char* first_frag = nullptr;
+    uint64_t first_frag_seq = 0;
+    uint64_t first_frag_len = 0;
+
+    // Once the fast path completed the datagram, the reassembled packet
+    // stands in for the block list in detecting overlapping fragments.
+    std::shared_ptr<IP_Hdr> completed_pkt;
+    uint64_t completed_len = 0; // payload bytes in completed_pkt
+
+    // Whether the datagram got reassembled.
+    bool completed = false;
+
+    // State maintained by the FragmentManager.
+    std::list<FragReassembler*>::iterator lru_pos;
+    uint64_t accounted_bytes = 0;
 };
 
 class FragTimer final : public Timer {
@@ -72,6 +120,12 @@ protected:
 
 class FragmentManager {
 public:
+    // Fragments up to this size get buffered in pooled memory.
+    static constexpr size_t POOL_BUFFER_SIZE = 2048;
+
+    // The max number of unused buffers to keep in the pool.
+    static constexpr size_t MAX_POOLED_BUFFERS = 1024;
+
     FragmentManager() = default;
     ~FragmentManager();
 
@@ -82,10 +136,38 @@ public:
     size_t Size() const { return fragments.size(); }
     size_t MaxFragments() const { return max_fragments; }
 
+    // Returns the number of bytes held for reassembly across all
+    // datagrams.
+    uint64_t MemoryUsage() const { return total_bytes; }
+
+    // Returns the number of incomplete datagrams discarded to stay within
+    // frag_memory_limit.
+    uint64_t Evictions() const { return evictions; }
+
+    // Returns the size of the buffer that GetBuffer() returns for the
+    // given length.
+    static size_t BufferSize(size_t len) { return len > POOL_BUFFER_SIZE ? len : POOL_BUFFER_SIZE; }
+
+    // Returns a buffer of at least len bytes, to be released through
+    // ReleaseBuffer() with the same length.
+    u_char* GetBuffer(size_t len);
+    void ReleaseBuffer(u_char* buf, size_t len);
+
 private:
+    // Discards the oldest datagrams other than the given one while over
+    // the memory limit.
+    void Evict(FragReassembler* keep);
+
     using FragmentMap = std::map<detail::FragReassemblerKey, detail::FragReassembler*>;
     FragmentMap fragments;
     size_t max_fragments = 0;
+
+    // All reassemblers, oldest first.
+    std::list<FragReassembler*> lru;
+
+    uint64_t total_bytes = 0;
+    uint64_t evictions = 0;
+    std::vector<u_char*> buffer_pool;
 };
 
 extern FragmentManager* fragment_mgr;
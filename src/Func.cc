@@ -335,6 +335,8 @@ ValPtr ScriptFunc::Invoke(zeek::Args* args, Frame* parent) const {
         f->SetTriggerAssoc(parent->GetTriggerAssoc());
     }
 
+    ScriptSampler::Checkpoint();
+
     g_frame_stack.push_back(f.get()); // used for backtracing
     const CallExpr* call_expr = parent ? parent->GetCall() : nullptr;
     call_stack.emplace_back(CallInfo{call_expr, this, *args});
@@ -423,6 +425,7 @@ ValPtr ScriptFunc::Invoke(zeek::Args* args, Frame* parent) const {
         }
     }
 
+    ScriptSampler::Checkpoint();
     call_stack.pop_back();
 
     if ( Flavor() == FUNC_FLAVOR_HOOK ) {
@@ -741,6 +744,7 @@ ValPtr BuiltinFunc::Invoke(Args* args, Frame* parent) const {
     const CallExpr* call_expr = parent ? parent->GetCall() : nullptr;
     call_stack.emplace_back(CallInfo{call_expr, this, *args});
     auto result = std::move(func(parent, args).rval);
+    ScriptSampler::Checkpoint();
     call_stack.pop_back();
 
     if ( result && g_trace_state.DoTrace() ) {
@@ -6,6 +6,7 @@
 
 #include "zeek/EventHandler.h"
 #include "zeek/ID.h"
+#include "zeek/PrefixTable.h"
 #include "zeek/Val.h"
 #include "zeek/Var.h"
 
@@ -117,6 +118,7 @@ int tcp_SYN_ack_ok;
 int tcp_match_undelivered;
 
 double frag_timeout;
+zeek_uint_t frag_memory_limit;
 
 double tcp_SYN_timeout;
 double tcp_session_timer;
@@ -130,6 +132,12 @@ int tcp_max_initial_window;
 int tcp_max_above_hole_without_any_acks;
 int tcp_excessive_data_without_further_acks;
 int tcp_max_old_segments;
+int tcp_coalesce_max_size;
+double tcp_coalesce_window;
+int bypass_unneeded_payload;
+int shunt_bypassed_flows;
+int event_handler_timing;
+double slow_event_handler_threshold;
 
 double non_analyzed_lifetime;
 double tcp_inactivity_timeout;
@@ -230,6 +238,7 @@ void init_general_global_var() {
     table_expire_interval = id::find_val("table_expire_interval")->AsInterval();
     table_expire_delay = id::find_val("table_expire_delay")->AsInterval();
     table_incremental_step = id::find_val("table_incremental_step")->AsCount();
+    PrefixTable::use_trie = id::find_val("table_subnet_trie")->AsBool();
     packet_filter_default = id::find_val("packet_filter_default")->AsBool();
     sig_max_group_size = id::find_val("sig_max_group_size")->AsCount();
     check_for_unused_event_handlers = id::find_val("check_for_unused_event_handlers")->AsBool();
@@ -251,6 +260,7 @@ void init_net_var() {
     tcp_match_undelivered = id::find_val("tcp_match_undelivered")->AsBool();
 
     frag_timeout = id::find_val("frag_timeout")->AsInterval();
+    frag_memory_limit = id::find_val("frag_memory_limit")->AsCount();
 
     tcp_SYN_timeout = id::find_val("tcp_SYN_timeout")->AsInterval();
     tcp_session_timer = id::find_val("tcp_session_timer")->AsInterval();
@@ -264,6 +274,12 @@ void init_net_var() {
     tcp_max_above_hole_without_any_acks = id::find_val("tcp_max_above_hole_without_any_acks")->AsCount();
     tcp_excessive_data_without_further_acks = id::find_val("tcp_excessive_data_without_further_acks")->AsCount();
     tcp_max_old_segments = id::find_val("tcp_max_old_segments")->AsCount();
+    tcp_coalesce_max_size = id::find_val("tcp_coalesce_max_size")->AsCount();
+    tcp_coalesce_window = id::find_val("tcp_coalesce_window")->AsInterval();
+    bypass_unneeded_payload = id::find_val("bypass_unneeded_payload")->AsBool();
+    shunt_bypassed_flows = id::find_val("shunt_bypassed_flows")->AsBool();
+    event_handler_timing = id::find_val("event_handler_timing")->AsBool();
+    slow_event_handler_threshold = id::find_val("slow_event_handler_threshold")->AsInterval();
 
     non_analyzed_lifetime = id::find_val("non_analyzed_lifetime")->AsInterval();
     tcp_inactivity_timeout = id::find_val("tcp_inactivity_timeout")->AsInterval();
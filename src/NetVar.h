@@ -18,6 +18,7 @@ extern int tcp_SYN_ack_ok;
 extern int tcp_match_undelivered;
 
 extern double frag_timeout;
+extern zeek_uint_t frag_memory_limit;
 
 extern double tcp_SYN_timeout;
 extern double tcp_session_timer;
@@ -31,6 +32,12 @@ extern int tcp_max_initial_window;
 extern int tcp_max_above_hole_without_any_acks;
 extern int tcp_excessive_data_without_further_acks;
 extern int tcp_max_old_segments;
+extern int tcp_coalesce_max_size;
+extern double tcp_coalesce_window;
+extern int bypass_unneeded_payload;
+extern int shunt_bypassed_flows;
+extern int event_handler_timing;
+extern double slow_event_handler_threshold;
 
 extern double non_analyzed_lifetime;
 extern double tcp_inactivity_timeout;
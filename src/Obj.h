@@ -6,6 +6,10 @@
 
 #include <climits>
 
+#ifdef ENABLE_SLAB_ALLOC
+#include "zeek/SlabAlloc.h"
+#endif
+
 namespace zeek {
 
 class ODesc;
@@ -78,6 +82,19 @@ public:
     Obj(const Obj&) = delete;
     Obj& operator=(const Obj&) = delete;
 
+#ifdef ENABLE_SLAB_ALLOC
+    // Route allocations of all script-level objects through the
+    // per-thread slabs.  Since the destructor is virtual, the size
+    // passed to operator delete is that of the dynamic type.
+    static void* operator new(size_t size) { return detail::slab_alloc(size); }
+    static void operator delete(void* p, size_t size) { detail::slab_free(p, size); }
+
+    // Class-specific allocation functions hide the global placement
+    // form, so bring it back.
+    static void* operator new(size_t, void* where) noexcept { return where; }
+    static void operator delete(void*, void*) noexcept {}
+#endif
+
     // Report user warnings/errors.  If obj2 is given, then it's
     // included in the message, though if pinpoint_only is non-zero,
     // then obj2 is only used to pinpoint the location.
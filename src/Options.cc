@@ -141,6 +141,12 @@ void usage(const char* prog, int code) {
     fprintf(stderr,
             "    --profile-script-call-stacks    | add call stacks to profile output (requires "
             "--profile-scripts)\n");
+    fprintf(stderr,
+            "    --profile-scripts-sampled[=file]| sample script call stacks into flamegraph input "
+            "file (default stdout)\n");
+    fprintf(stderr,
+            "    --profile-scripts-sample-rate=<hz> | samples per second of CPU time for "
+            "--profile-scripts-sampled (default 99)\n");
     fprintf(stderr,
             "    --pseudo-realtime[=<speedup>]   | enable pseudo-realtime for performance "
             "evaluation (default 1)\n");
@@ -180,6 +186,7 @@ void usage(const char* prog, int code) {
 static void print_analysis_help() {
     fprintf(stderr, "--optimize options when using ZAM:\n");
     fprintf(stderr, "    ZAM	execute scripts using ZAM and all optimizations\n");
+    fprintf(stderr, "    cache-ZAM	reuse ZAM code compiled by previous runs; implies gen-ZAM-code\n");
     fprintf(stderr, "    help	print this list\n");
     fprintf(stderr, "    report-uncompilable	print names of functions that can't be compiled\n");
     fprintf(stderr, "\n  primarily for developers:\n");
@@ -226,6 +233,8 @@ static void set_analysis_option(const char* opt, Options& opts) {
         a_o.activate = a_o.dump_xform = true;
     else if ( util::streq(opt, "dump-ZAM") )
         a_o.activate = a_o.dump_ZAM = true;
+    else if ( util::streq(opt, "cache-ZAM") )
+        a_o.activate = a_o.gen_ZAM_code = a_o.cache_ZAM = true;
     else if ( util::streq(opt, "allow-cond") )
         a_o.allow_cond = true;
     else if ( util::streq(opt, "gen-C++") )
@@ -344,11 +353,16 @@ Options parse_cmdline(int argc, char** argv) {
 
     int profile_scripts = 0;
     int profile_script_call_stacks = 0;
+    int profile_scripts_sampled = 0;
+    int profile_scripts_sample_rate = 0;
     std::string profile_filename;
+    std::string sample_filename;
+    int sample_hz = 99;
     int no_unused_warnings = 0;
 
     bool enable_script_profile = false;
     bool enable_script_profile_call_stacks = false;
+    bool enable_script_sampling = false;
 
     struct option long_opts[] = {
         {"parse-only", no_argument, nullptr, 'a'},
@@ -394,6 +408,8 @@ Options parse_cmdline(int argc, char** argv) {
 
         {"profile-scripts", optional_argument, &profile_scripts, 1},
         {"profile-script-call-stacks", optional_argument, &profile_script_call_stacks, 1},
+        {"profile-scripts-sampled", optional_argument, &profile_scripts_sampled, 1},
+        {"profile-scripts-sample-rate", required_argument, &profile_scripts_sample_rate, 1},
         {"no-unused-warnings", no_argument, &no_unused_warnings, 1},
         {"pseudo-realtime", optional_argument, nullptr, '~'},
         {"jobs", optional_argument, nullptr, 'j'},
@@ -534,6 +550,22 @@ Options parse_cmdline(int argc, char** argv) {
                     profile_script_call_stacks = 0;
                 }
 
+                if ( profile_scripts_sampled ) {
+                    sample_filename = optarg ? optarg : "";
+                    enable_script_sampling = true;
+                    profile_scripts_sampled = 0;
+                }
+
+                if ( profile_scripts_sample_rate ) {
+                    sample_hz = atoi(optarg);
+                    profile_scripts_sample_rate = 0;
+
+                    if ( sample_hz <= 0 ) {
+                        fprintf(stderr, "ERROR: --profile-scripts-sample-rate requires a positive rate.\n");
+                        usage(zargs[0], 1);
+                    }
+                }
+
                 if ( no_unused_warnings )
                     rval.no_unused_warnings = true;
                 break;
@@ -550,6 +582,9 @@ Options parse_cmdline(int argc, char** argv) {
                                   enable_script_profile_call_stacks);
     }
 
+    if ( enable_script_sampling )
+        activate_script_sampling(sample_filename.empty() ? nullptr : sample_filename.c_str(), sample_hz);
+
     // Process remaining arguments. X=Y arguments indicate script
     // variable/parameter assignments. X::Y arguments indicate plugins to
     // activate/query. The remainder are treated as scripts to load.
@@ -1,10 +1,189 @@
 #include "zeek/PrefixTable.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "zeek/Reporter.h"
 #include "zeek/Val.h"
+#include "zeek/net_util.h"
+
+#include "zeek/3rdparty/doctest.h"
 
 namespace zeek::detail {
 
+namespace {
+
+// Splits 16 bytes in network order into two words in host order.
+void load_addr(const uint8_t* bytes, uint64_t* hi, uint64_t* lo) {
+    memcpy(hi, bytes, sizeof(*hi));
+    memcpy(lo, bytes + 8, sizeof(*lo));
+    *hi = ntohll(*hi);
+    *lo = ntohll(*lo);
+}
+
+// Returns the 6 bits of a 128-bit value starting at bit offset depth, with
+// bits past the end reading as zero.
+inline unsigned chunk(uint64_t hi, uint64_t lo, int depth) {
+    uint64_t w;
+
+    if ( depth == 0 )
+        w = hi;
+    else if ( depth < 64 )
+        w = (hi << depth) | (lo >> (64 - depth));
+    else
+        w = lo << (depth - 64);
+
+    return w >> 58;
+}
+
+} // namespace
+
+void Poptrie::Build(std::vector<Entry>& entries) {
+    nodes.clear();
+    leaves.clear();
+
+    void* def = nullptr;
+    std::vector<const Entry*> top;
+    top.reserve(entries.size());
+
+    for ( auto& e : entries ) {
+        // Clear the bits past the prefix length, which chunk() relies on.
+        if ( e.len < 64 ) {
+            e.hi &= e.len ? ~uint64_t(0) << (64 - e.len) : 0;
+            e.lo = 0;
+        }
+        else if ( e.len < 128 )
+            e.lo &= e.len > 64 ? ~uint64_t(0) << (128 - e.len) : 0;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return std::tie(a.hi, a.lo, a.len) < std::tie(b.hi, b.lo, b.len);
+    });
+
+    for ( const auto& e : entries ) {
+        if ( e.len == 0 )
+            def = e.data;
+        else
+            top.push_back(&e);
+    }
+
+    nodes.resize(1);
+    BuildNode(0, 0, top, def);
+
+    // Find where IPv4 lookups start, following ::ffff:0:0/96.
+    uint64_t hi = 0;
+    uint64_t lo = 0x0000ffff00000000;
+    uint32_t idx = 0;
+    int depth = 0;
+
+    while ( depth < 96 ) {
+        const auto& n = nodes[idx];
+        uint64_t bit = uint64_t(1) << chunk(hi, lo, depth);
+
+        if ( ! (n.vector & bit) )
+            break;
+
+        idx = n.base1 + __builtin_popcountll(n.vector & (bit - 1));
+        depth += STRIDE;
+    }
+
+    v4_node = idx;
+    v4_depth = depth;
+    v4_leaf = depth < 96 ? LookupFrom(idx, depth, hi, lo) : nullptr;
+}
+
+void Poptrie::BuildNode(uint32_t idx, int depth, std::vector<const Entry*>& entries, void* def) {
+    void* slot_leaves[64];
+    std::vector<const Entry*> children[64];
+    std::vector<const Entry*> covering;
+
+    std::fill(std::begin(slot_leaves), std::end(slot_leaves), def);
+
+    // Entries ending within this node cover a range of its slots, the
+    // others continue in the child of their slot.
+    for ( auto e : entries ) {
+        if ( e->len <= depth + STRIDE )
+            covering.push_back(e);
+        else
+            children[chunk(e->hi, e->lo, depth)].push_back(e);
+    }
+
+    // Longer prefixes take precedence over shorter ones.
+    std::stable_sort(covering.begin(), covering.end(), [](const Entry* a, const Entry* b) { return a->len < b->len; });
+
+    for ( auto e : covering ) {
+        unsigned first = chunk(e->hi, e->lo, depth);
+        unsigned num = 1u << (depth + STRIDE - e->len);
+        std::fill(slot_leaves + first, slot_leaves + first + num, e->data);
+    }
+
+    // Store the node's leaves, merging runs of identical ones. Slots with
+    // children don't interrupt a run.
+    Node n = {0, 0, static_cast<uint32_t>(leaves.size()), 0};
+    bool have_leaf = false;
+    void* prev = nullptr;
+
+    for ( int i = 0; i < 64; ++i ) {
+        if ( ! children[i].empty() ) {
+            n.vector |= uint64_t(1) << i;
+            continue;
+        }
+
+        if ( ! have_leaf || slot_leaves[i] != prev ) {
+            n.leafvec |= uint64_t(1) << i;
+            leaves.push_back(slot_leaves[i]);
+            prev = slot_leaves[i];
+            have_leaf = true;
+        }
+    }
+
+    // A node's children are contiguous, so allocate them all before
+    // descending.
+    n.base1 = nodes.size();
+    nodes.resize(nodes.size() + __builtin_popcountll(n.vector));
+    nodes[idx] = n;
+
+    uint32_t child = n.base1;
+
+    for ( int i = 0; i < 64; ++i ) {
+        if ( ! children[i].empty() )
+            BuildNode(child++, depth + STRIDE, children[i], slot_leaves[i]);
+    }
+}
+
+void* Poptrie::LookupFrom(uint32_t idx, int depth, uint64_t hi, uint64_t lo) const {
+    while ( true ) {
+        const auto& n = nodes[idx];
+        uint64_t bit = uint64_t(1) << chunk(hi, lo, depth);
+
+        if ( n.vector & bit ) {
+            idx = n.base1 + __builtin_popcountll(n.vector & (bit - 1));
+            depth += STRIDE;
+            continue;
+        }
+
+        return leaves[n.base0 + __builtin_popcountll(n.leafvec & ((bit << 1) - 1)) - 1];
+    }
+}
+
+void* Poptrie::Lookup(const IPAddr& addr) const {
+    if ( nodes.empty() )
+        return nullptr;
+
+    in6_addr a;
+    addr.CopyIPv6(&a);
+
+    uint64_t hi, lo;
+    load_addr(a.s6_addr, &hi, &lo);
+
+    if ( addr.GetFamily() == IPv4 )
+        return v4_depth == 96 ? LookupFrom(v4_node, 96, hi, lo) : v4_leaf;
+
+    return LookupFrom(0, 0, hi, lo);
+}
+
+bool PrefixTable::use_trie = true;
+
 prefix_t* PrefixTable::MakePrefix(const IPAddr& addr, int width) {
     prefix_t* prefix = (prefix_t*)util::safe_malloc(sizeof(prefix_t));
 
@@ -37,6 +216,7 @@ void* PrefixTable::Insert(const IPAddr& addr, int width, void* data) {
     // node itself.
     node->data = data ? data : node;
 
+    Invalidate();
     return old;
 }
 
@@ -76,6 +256,16 @@ std::list<std::tuple<IPPrefix, void*>> PrefixTable::FindAll(const SubNetVal* val
 }
 
 void* PrefixTable::Lookup(const IPAddr& addr, int width, bool exact) const {
+    if ( ! exact && width == 128 && use_trie ) {
+        if ( trie_valid )
+            return trie.Lookup(addr);
+
+        if ( ++lookups_since_change >= std::max<uint64_t>(MIN_LOOKUPS_FOR_TRIE, tree->num_active_node) ) {
+            BuildTrie();
+            return trie.Lookup(addr);
+        }
+    }
+
     prefix_t* prefix = MakePrefix(addr, width);
     patricia_node_t* node = exact ? patricia_search_exact(tree, prefix) : patricia_search_best(tree, prefix);
 
@@ -113,6 +303,7 @@ void* PrefixTable::Remove(const IPAddr& addr, int width) {
     void* old = node->data;
     patricia_remove(tree, node);
 
+    Invalidate();
     return old;
 }
 
@@ -130,6 +321,37 @@ void* PrefixTable::Remove(const Val* value) {
     }
 }
 
+void PrefixTable::BuildTrie() const {
+    std::vector<Poptrie::Entry> entries;
+    std::vector<patricia_node_t*> stack;
+
+    if ( tree->head )
+        stack.push_back(tree->head);
+
+    while ( ! stack.empty() ) {
+        auto node = stack.back();
+        stack.pop_back();
+
+        if ( node->l )
+            stack.push_back(node->l);
+
+        if ( node->r )
+            stack.push_back(node->r);
+
+        if ( ! node->prefix )
+            continue;
+
+        Poptrie::Entry e;
+        load_addr(reinterpret_cast<const uint8_t*>(&node->prefix->add.sin6), &e.hi, &e.lo);
+        e.len = node->prefix->bitlen;
+        e.data = node->data;
+        entries.push_back(e);
+    }
+
+    trie.Build(entries);
+    trie_valid = true;
+}
+
 PrefixTable::iterator PrefixTable::InitIterator() {
     iterator i;
     i.Xsp = i.Xstack;
@@ -167,4 +389,60 @@ void* PrefixTable::GetNext(iterator* i) {
     // Not reached.
 }
 
+TEST_SUITE_BEGIN("PrefixTable");
+
+TEST_CASE("poptrie matches patricia") {
+    PrefixTable pt;
+    std::vector<IPAddr> probes;
+
+    // Nested and adjacent prefixes of both families, including ones that
+    // don't end on a node boundary.
+    const std::pair<const char*, int> prefixes[] = {
+        {"10.0.0.0", 8},       {"10.1.0.0", 16},    {"10.1.2.0", 24},  {"10.1.2.3", 32},       {"10.1.2.128", 25},
+        {"192.168.0.0", 13},   {"192.168.5.0", 27}, {"172.16.0.0", 12}, {"2001:db8::", 32},     {"2001:db8:1::", 48},
+        {"2001:db8:1::1", 128}, {"fe80::", 10},      {"::", 1},          {"2001:db8:1:2::", 63},
+    };
+
+    int i = 0;
+    for ( const auto& [addr, width] : prefixes ) {
+        IPPrefix p(IPAddr(addr), width);
+        pt.Insert(p.Prefix(), p.LengthIPv6(), reinterpret_cast<void*>(static_cast<intptr_t>(++i)));
+        probes.emplace_back(addr);
+    }
+
+    for ( const char* a : {"10.1.2.4", "10.1.2.200", "10.2.0.1", "11.0.0.1", "192.168.5.31", "192.168.5.32",
+                           "192.175.0.1", "172.31.255.255", "2001:db8:1::2", "2001:db8:1:3::", "2001:db9::",
+                           "fe80::1", "febf::1", "ffff::1", "1.1.1.1"} )
+        probes.emplace_back(a);
+
+    auto check = [&]() {
+        // Patricia's results, with the trie disabled.
+        PrefixTable::use_trie = false;
+        std::vector<void*> expected;
+        for ( const auto& a : probes )
+            expected.push_back(pt.Lookup(a, 128));
+
+        PrefixTable::use_trie = true;
+
+        // Enough lookups to get the trie built.
+        for ( uint64_t n = 0; n < PrefixTable::MIN_LOOKUPS_FOR_TRIE; ++n )
+            pt.Lookup(probes[0], 128);
+
+        for ( size_t j = 0; j < probes.size(); ++j )
+            CHECK(pt.Lookup(probes[j], 128) == expected[j]);
+    };
+
+    check();
+
+    // Modifications must be reflected.
+    pt.Remove(IPAddr("10.1.2.0"), 120);
+    pt.Insert(IPAddr("::"), 0, reinterpret_cast<void*>(static_cast<intptr_t>(100)));
+    check();
+
+    pt.Clear();
+    check();
+}
+
+TEST_SUITE_END();
+
 } // namespace zeek::detail
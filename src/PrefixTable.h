@@ -4,8 +4,10 @@ extern "C" {
 #include "zeek/3rdparty/patricia.h"
 }
 
+#include <cstdint>
 #include <list>
 #include <tuple>
+#include <vector>
 
 #include "zeek/IPAddr.h"
 
@@ -16,6 +18,64 @@ class SubNetVal;
 
 namespace detail {
 
+// A read-only, compressed multibit trie for longest-prefix matching of
+// addresses, along the lines of Poptrie (Asai & Ohara, "Poptrie: A Compressed
+// Trie with Population Count for Fast and Scalable Software IP Routing Table
+// Lookup", SIGCOMM 2015). Each node consumes 6 bits of the address and keeps
+// two 64-bit vectors: one marking which of its slots lead to child nodes, and
+// one marking where runs of identical leaves start. A population count over
+// these yields the offset into the node's contiguous blocks of children and
+// leaves, so a lookup touches one small node per level rather than walking
+// pointer-linked patricia nodes bit by bit.
+class Poptrie {
+public:
+    struct Entry {
+        uint64_t hi, lo; // The prefix, in host order.
+        int len;
+        void* data;
+    };
+
+    /**
+     * Builds the trie from scratch, replacing any previous content.
+     *
+     * @param entries The prefixes to index. Gets sorted in place.
+     */
+    void Build(std::vector<Entry>& entries);
+
+    /**
+     * Returns the data of the longest prefix containing an address, or
+     * null if none does.
+     */
+    void* Lookup(const IPAddr& addr) const;
+
+    size_t NumNodes() const { return nodes.size(); }
+    size_t NumLeaves() const { return leaves.size(); }
+
+private:
+    // The number of address bits each node consumes.
+    static constexpr int STRIDE = 6;
+
+    struct Node {
+        uint64_t vector;  // Slots with a child node.
+        uint64_t leafvec; // Slots starting a new run of leaves.
+        uint32_t base0;   // Index of the first leaf.
+        uint32_t base1;   // Index of the first child.
+    };
+
+    void BuildNode(uint32_t idx, int depth, std::vector<const Entry*>& entries, void* def);
+    void* LookupFrom(uint32_t idx, int depth, uint64_t hi, uint64_t lo) const;
+
+    std::vector<Node> nodes;
+    std::vector<void*> leaves;
+
+    // IPv4 addresses all share the first 96 bits, so their lookups start
+    // further down the trie: at node v4_node if v4_depth is 96, or else
+    // directly with the result v4_leaf.
+    uint32_t v4_node = 0;
+    int v4_depth = 0;
+    void* v4_leaf = nullptr;
+};
+
 class PrefixTable {
 private:
     struct iterator {
@@ -54,7 +114,10 @@ public:
     void* Remove(const IPAddr& addr, int width);
     void* Remove(const Val* value);
 
-    void Clear() { Clear_Patricia(tree, delete_function); }
+    void Clear() {
+        Clear_Patricia(tree, delete_function);
+        Invalidate();
+    }
 
     // Sets a function to call for each node when table is cleared/destroyed.
     void SetDeleteFunction(data_fn_t del_fn) { delete_function = del_fn; }
@@ -62,12 +125,36 @@ public:
     iterator InitIterator();
     void* GetNext(iterator* i);
 
+    // Whether longest-prefix matches of addresses may use a Poptrie built
+    // from the table's content.
+    static bool use_trie;
+
+    // The minimum number of lookups between modifications of the table
+    // before building a trie pays off.
+    static constexpr uint64_t MIN_LOOKUPS_FOR_TRIE = 1024;
+
 private:
     static prefix_t* MakePrefix(const IPAddr& addr, int width);
     static IPPrefix PrefixToIPPrefix(prefix_t* p);
 
+    // Discards the trie after a modification of the table.
+    void Invalidate() {
+        trie_valid = false;
+        lookups_since_change = 0;
+    }
+
+    // Rebuilds the trie from the patricia tree.
+    void BuildTrie() const;
+
     patricia_tree_t* tree;
     data_fn_t delete_function;
+
+    // The patricia tree remains authoritative. The trie gets rebuilt once
+    // the number of lookups since the last modification exceeds the
+    // number of prefixes, which amortizes the cost of building it.
+    mutable Poptrie trie;
+    mutable bool trie_valid = false;
+    mutable uint64_t lookups_since_change = 0;
 };
 
 } // namespace detail
@@ -30,6 +30,7 @@ extern "C" {
 #include "zeek/NetVar.h"
 #include "zeek/Reporter.h"
 #include "zeek/Scope.h"
+#include "zeek/ScriptProfile.h"
 #include "zeek/Timer.h"
 #include "zeek/broker/Manager.h"
 #include "zeek/iosource/Manager.h"
@@ -284,6 +285,8 @@ void run_loop() {
     ready.reserve(iosource_mgr->TotalSize());
 
     while ( iosource_mgr->Size() || (BifConst::exit_only_after_terminate && ! terminating) ) {
+        zeek::detail::ScriptSampler::Checkpoint();
+
         time_updated = false;
         iosource_mgr->FindReadySources(&ready);
 
@@ -2,6 +2,18 @@
 
 #include "zeek/ScriptProfile.h"
 
+#include "zeek/zeek-config.h"
+
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <csignal>
+#include <ctime>
+#include <vector>
+
+#include "zeek/Frame.h"
+
 namespace zeek {
 
 namespace detail {
@@ -198,6 +210,119 @@ void ScriptProfileMgr::EndInvocation() {
 
 std::unique_ptr<ScriptProfileMgr> spm;
 
+std::atomic<int> ScriptSampler::pending = 0;
+
+ScriptSampler::ScriptSampler(FILE* arg_f, int hz) : f(arg_f), hz(hz) {
+    struct sigaction sa = {};
+    sa.sa_handler = SignalHandler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGPROF, &sa, nullptr);
+}
+
+void ScriptSampler::Start() {
+    if ( started )
+        return;
+
+    started = true;
+
+    struct itimerspec its = {};
+    its.it_interval.tv_nsec = std::max(1000000000L / std::max(hz, 1), 1L);
+    its.it_value = its.it_interval;
+
+#if defined(HAVE_TIMER_CREATE) && defined(SIGEV_THREAD_ID)
+    // Count only the CPU time of the main thread, which is the one running
+    // scripts, and deliver the signal to it. Otherwise, busy writer and
+    // other threads would inflate whatever the main thread happens to do.
+    struct sigevent sev = {};
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo = SIGPROF;
+#ifdef sigev_notify_thread_id
+    sev.sigev_notify_thread_id = static_cast<pid_t>(syscall(SYS_gettid));
+#else
+    sev._sigev_un._tid = static_cast<pid_t>(syscall(SYS_gettid));
+#endif
+
+    if ( timer_create(CLOCK_THREAD_CPUTIME_ID, &sev, &timer) == 0 ) {
+        have_timer = true;
+        timer_settime(timer, 0, &its, nullptr);
+        return;
+    }
+#endif
+
+    // Fallback: ITIMER_PROF counts the CPU time of the whole process, so
+    // time that other threads spend gets charged to the main thread's
+    // current stack, too. Either way, an idle process doesn't collect
+    // any samples.
+    struct itimerval it = {};
+    it.it_interval.tv_usec = its.it_interval.tv_nsec / 1000;
+    it.it_value = it.it_interval;
+    setitimer(ITIMER_PROF, &it, nullptr);
+}
+
+ScriptSampler::~ScriptSampler() {
+    bool use_itimer = started;
+
+#if defined(HAVE_TIMER_CREATE) && defined(SIGEV_THREAD_ID)
+    if ( have_timer ) {
+        timer_delete(timer);
+        use_itimer = false;
+    }
+#endif
+
+    if ( use_itimer ) {
+        struct itimerval it = {};
+        setitimer(ITIMER_PROF, &it, nullptr);
+    }
+
+    signal(SIGPROF, SIG_IGN);
+
+    // Sorting isn't needed by the tools, but makes the output stable.
+    std::vector<std::pair<std::string, uint64_t>> sorted(stacks.begin(), stacks.end());
+    std::sort(sorted.begin(), sorted.end());
+
+    for ( const auto& [stack, count] : sorted )
+        fprintf(f, "%s %" PRIu64 "\n", stack.c_str(), count);
+
+    if ( f != stdout )
+        fclose(f);
+}
+
+void ScriptSampler::SignalHandler(int) { pending.fetch_add(1, std::memory_order_relaxed); }
+
+void ScriptSampler::Sample() {
+    auto ticks = pending.exchange(0, std::memory_order_relaxed);
+
+    if ( ticks <= 0 || ! script_sampler )
+        return;
+
+    std::string stack;
+
+    for ( const auto& ci : call_stack ) {
+        if ( ! stack.empty() )
+            stack += ';';
+
+        stack += ci.func->Name();
+    }
+
+    if ( stack.empty() )
+        stack = "<non-script>";
+
+    // For script functions, add the statement in progress as a final
+    // frame of its own, so that hot lines show up within their function.
+    else if ( call_stack.back().func->GetKind() == Func::SCRIPT_FUNC && ! g_frame_stack.empty() &&
+              g_frame_stack.back()->GetNextStmt() ) {
+        auto loc = g_frame_stack.back()->GetNextStmt()->GetLocationInfo();
+
+        if ( loc->filename )
+            stack += util::fmt(";%s:%d", loc->filename, loc->first_line);
+    }
+
+    script_sampler->stacks[stack] += ticks;
+}
+
+std::unique_ptr<ScriptSampler> script_sampler;
+
 } // namespace detail
 
 void activate_script_profiling(const char* fn, bool with_traces) {
@@ -219,4 +344,20 @@ void activate_script_profiling(const char* fn, bool with_traces) {
         detail::spm->EnableTraces();
 }
 
+void activate_script_sampling(const char* fn, int hz) {
+    FILE* f;
+
+    if ( fn ) {
+        f = fopen(fn, "w");
+        if ( ! f ) {
+            fprintf(stderr, "ERROR: Can't open %s to record script samples\n", fn);
+            exit(1);
+        }
+    }
+    else
+        f = stdout;
+
+    detail::script_sampler = std::make_unique<detail::ScriptSampler>(f, hz);
+}
+
 } // namespace zeek
@@ -4,6 +4,12 @@
 
 #pragma once
 
+#include "zeek/zeek-config.h"
+
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <ctime>
 #include <string>
 
 #include "zeek/Func.h"
@@ -180,10 +186,61 @@ private:
 // If non-nil, script profiling is active.
 extern std::unique_ptr<ScriptProfileMgr> spm;
 
+// A low-overhead alternative to ScriptProfileMgr, suitable for production
+// use. Rather than instrumenting every call, a timer on the main thread's
+// CPU time (or the process's, where per-thread timers aren't available)
+// periodically flags that a sample is due, and the next checkpoint the
+// interpreter reaches records the current script call stack along with the
+// location of the statement being executed. Checkpoints sit between statements, at
+// function entry and exit, and in the main loop, so that time spent
+// outside of scripts gets recorded as such. The samples get written in the
+// "folded stacks" format that flamegraph.pl and similar tools take.
+class ScriptSampler {
+public:
+    // Samples at the given frequency, writing the result to the given
+    // file on destruction. Sampling begins with Start().
+    ScriptSampler(FILE* f, int hz);
+    ~ScriptSampler();
+
+    // Arms the timer. Must be called from the main thread.
+    void Start();
+
+    // Records a sample if one is due.
+    static void Checkpoint() {
+        if ( pending.load(std::memory_order_relaxed) )
+            Sample();
+    }
+
+private:
+    static void Sample();
+    static void SignalHandler(int);
+
+    // Timer ticks not yet recorded. Updated from the signal handler.
+    static std::atomic<int> pending;
+
+    FILE* f;
+    int hz;
+    bool started = false;
+
+#if defined(HAVE_TIMER_CREATE) && defined(SIGEV_THREAD_ID)
+    bool have_timer = false; // True if using a per-thread timer.
+    timer_t timer = {};
+#endif
+
+    std::unordered_map<std::string, uint64_t> stacks;
+};
+
+// If non-nil, sampled script profiling is active.
+extern std::unique_ptr<ScriptSampler> script_sampler;
+
 } // namespace detail
 
 // Called to turn on script profiling to the given file.  If nil, writes
 // the profile to stdout.
 extern void activate_script_profiling(const char* fn, bool with_traces);
 
+// Called to turn on sampled script profiling to the given file at the given
+// frequency.  If nil, writes the samples to stdout.
+extern void activate_script_sampling(const char* fn, int hz);
+
 } // namespace zeek
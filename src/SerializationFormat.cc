@@ -25,15 +25,15 @@ void SerializationFormat::StartRead(const char* data, uint32_t arg_len) {
 
 void SerializationFormat::EndRead() { input = nullptr; }
 
-void SerializationFormat::StartWrite() {
-    if ( output && output_size > INITIAL_SIZE ) {
+void SerializationFormat::StartWrite(uint32_t initial_size) {
+    if ( output && output_size > initial_size ) {
         free(output);
         output = nullptr;
     }
 
     if ( ! output ) {
-        output = (char*)util::safe_malloc(INITIAL_SIZE);
-        output_size = INITIAL_SIZE;
+        output = (char*)util::safe_malloc(initial_size);
+        output_size = initial_size;
     }
 
     output_pos = 0;
@@ -47,8 +47,9 @@ public:
     // Passes ownership of string.
     virtual bool Read(char** str, int* len, const char* tag) = 0;
 
-    // Serialization.
-    virtual void StartWrite();
+    // Serialization.  The initial buffer size may be lowered for
+    // callers that expect to write only a little.
+    virtual void StartWrite(uint32_t initial_size = INITIAL_SIZE);
 
     /**
      * Retrieves serialized data.
@@ -0,0 +1,222 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/SlabAlloc.h"
+
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "zeek/RunState.h"
+#include "zeek/Timer.h"
+#include "zeek/telemetry/Manager.h"
+
+#include "zeek/3rdparty/doctest.h"
+
+namespace zeek::detail {
+
+namespace {
+
+// How much memory to carve up at a time.
+constexpr size_t SLAB_SIZE = 64 * 1024;
+
+// How often (in seconds of network time) to update the telemetry.
+constexpr double SLAB_STATS_INTERVAL = 10.0;
+
+struct FreeObj {
+    FreeObj* next;
+};
+
+// The state of a single thread.  The counters are only ever modified
+// by the owning thread, so they don't need atomic read-modify-write
+// operations; they're atomic just so that other threads can read them.
+struct ThreadSlabs {
+    FreeObj* free_lists[SLAB_ALLOC_NUM_CLASSES] = {};
+    std::atomic<int64_t> live[SLAB_ALLOC_NUM_CLASSES] = {};
+    std::atomic<int64_t> slab_objs[SLAB_ALLOC_NUM_CLASSES] = {};
+};
+
+inline void bump(std::atomic<int64_t>& c, int64_t delta) {
+    c.store(c.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+// All threads that have used the allocator, for gathering statistics.
+// ThreadSlabs are never deleted, since objects allocated by a thread
+// can outlive it.
+std::mutex registry_mtx;
+
+std::vector<ThreadSlabs*>& registry() {
+    static auto r = new std::vector<ThreadSlabs*>;
+    return *r;
+}
+
+thread_local ThreadSlabs* thread_slabs = nullptr;
+
+ThreadSlabs* get_thread_slabs() {
+    if ( ! thread_slabs ) {
+        thread_slabs = new ThreadSlabs;
+
+        std::lock_guard<std::mutex> lock(registry_mtx);
+        registry().push_back(thread_slabs);
+    }
+
+    return thread_slabs;
+}
+
+inline int size_class(size_t size) {
+    return size == 0 ? 0 : static_cast<int>((size - 1) / SLAB_ALLOC_GRANULARITY);
+}
+
+void refill(ThreadSlabs* ts, int c) {
+    auto obj_size = (c + 1) * SLAB_ALLOC_GRANULARITY;
+    auto n = SLAB_SIZE / obj_size;
+
+    auto slab = static_cast<char*>(::operator new(SLAB_SIZE));
+
+    FreeObj* head = nullptr;
+    for ( auto i = n; i > 0; --i ) {
+        auto o = reinterpret_cast<FreeObj*>(slab + (i - 1) * obj_size);
+        o->next = head;
+        head = o;
+    }
+
+    ts->free_lists[c] = head;
+    bump(ts->slab_objs[c], n);
+}
+
+} // namespace
+
+void* slab_alloc(size_t size) {
+    if ( size > SLAB_ALLOC_MAX_SIZE )
+        return ::operator new(size);
+
+    auto c = size_class(size);
+    auto ts = get_thread_slabs();
+
+    if ( ! ts->free_lists[c] )
+        refill(ts, c);
+
+    auto o = ts->free_lists[c];
+    ts->free_lists[c] = o->next;
+    bump(ts->live[c], 1);
+
+    return o;
+}
+
+void slab_free(void* p, size_t size) {
+    if ( ! p )
+        return;
+
+    if ( size > SLAB_ALLOC_MAX_SIZE ) {
+        ::operator delete(p);
+        return;
+    }
+
+    auto c = size_class(size);
+    auto ts = get_thread_slabs();
+
+    auto o = static_cast<FreeObj*>(p);
+    o->next = ts->free_lists[c];
+    ts->free_lists[c] = o;
+    bump(ts->live[c], -1);
+}
+
+SlabAllocClassStats slab_alloc_class_stats(int c) {
+    SlabAllocClassStats s;
+    s.obj_size = (c + 1) * SLAB_ALLOC_GRANULARITY;
+
+    std::lock_guard<std::mutex> lock(registry_mtx);
+
+    for ( auto ts : registry() ) {
+        s.live += ts->live[c].load(std::memory_order_relaxed);
+        s.slab_objs += ts->slab_objs[c].load(std::memory_order_relaxed);
+    }
+
+    return s;
+}
+
+namespace {
+
+// The gauges for a single size class.
+struct SlabClassGauges {
+    telemetry::IntGauge live;
+    telemetry::IntGauge slab_objs;
+};
+
+std::vector<SlabClassGauges> slab_gauges;
+
+void update_gauge(telemetry::IntGauge& g, int64_t v) { g.Inc(v - g.Value()); }
+
+void update_slab_alloc_telemetry() {
+    for ( auto c = 0; c < SLAB_ALLOC_NUM_CLASSES; ++c ) {
+        auto s = slab_alloc_class_stats(c);
+        update_gauge(slab_gauges[c].live, s.live);
+        update_gauge(slab_gauges[c].slab_objs, s.slab_objs);
+    }
+}
+
+class SlabStatsTimer final : public Timer {
+public:
+    SlabStatsTimer(double t) : Timer(t, TIMER_PROFILE) {}
+
+    void Dispatch(double t, bool is_expire) override {
+        update_slab_alloc_telemetry();
+
+        if ( ! is_expire )
+            timer_mgr->Add(new SlabStatsTimer(run_state::network_time + SLAB_STATS_INTERVAL));
+    }
+};
+
+} // namespace
+
+void init_slab_alloc_telemetry() {
+    auto live_family = telemetry_mgr->GaugeFamily("zeek", "slab-alloc-live-objects", {"size_class"},
+                                                  "Objects currently allocated from slabs, by size class");
+    auto slab_objs_family = telemetry_mgr->GaugeFamily("zeek", "slab-alloc-capacity-objects", {"size_class"},
+                                                       "Objects that slabs have been carved into, by size class");
+
+    for ( auto c = 0; c < SLAB_ALLOC_NUM_CLASSES; ++c ) {
+        auto sc = std::to_string((c + 1) * SLAB_ALLOC_GRANULARITY);
+        auto live = live_family.GetOrAdd({{"size_class", sc}});
+        auto slab_objs = slab_objs_family.GetOrAdd({{"size_class", sc}});
+        slab_gauges.push_back({live, slab_objs});
+    }
+
+    timer_mgr->Add(new SlabStatsTimer(1));
+}
+
+TEST_SUITE_BEGIN("SlabAlloc");
+
+TEST_CASE("slab alloc reuse") {
+    auto before = slab_alloc_class_stats(size_class(40));
+
+    auto p1 = slab_alloc(40);
+    auto p2 = slab_alloc(33);
+    CHECK(p1 != p2);
+
+    auto during = slab_alloc_class_stats(size_class(40));
+    CHECK(during.obj_size == 48);
+    CHECK(during.live == before.live + 2);
+
+    slab_free(p2, 33);
+    auto p3 = slab_alloc(48);
+    CHECK(p3 == p2);
+
+    slab_free(p1, 40);
+    slab_free(p3, 48);
+
+    auto after = slab_alloc_class_stats(size_class(40));
+    CHECK(after.live == before.live);
+    CHECK(after.slab_objs >= during.slab_objs);
+}
+
+TEST_CASE("slab alloc large objects") {
+    auto p = slab_alloc(SLAB_ALLOC_MAX_SIZE + 1);
+    CHECK(p != nullptr);
+    slab_free(p, SLAB_ALLOC_MAX_SIZE + 1);
+}
+
+TEST_SUITE_END();
+
+} // namespace zeek::detail
@@ -0,0 +1,46 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+// A simple per-thread slab allocator for small objects.  Requests are
+// rounded up to a size class; each thread keeps a free list per class
+// that it refills by carving up larger slabs.  Memory handed back goes
+// onto the free list of the releasing thread and is never returned to
+// the system, which avoids most of the malloc/free traffic (and heap
+// fragmentation) for the many short-lived script-level objects.
+//
+// When Zeek is configured with --enable-slab-alloc, Obj (and thus every
+// Val, Expr, Stmt, Type, ...) routes its allocations through here.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace zeek::detail {
+
+// Granularity of the size classes, and the largest object size handled
+// by the slabs.  Larger requests are passed along to operator new.
+constexpr size_t SLAB_ALLOC_GRANULARITY = 16;
+constexpr size_t SLAB_ALLOC_MAX_SIZE = 512;
+constexpr int SLAB_ALLOC_NUM_CLASSES = SLAB_ALLOC_MAX_SIZE / SLAB_ALLOC_GRANULARITY;
+
+// Returns memory for an object of the given size.
+extern void* slab_alloc(size_t size);
+
+// Releases memory obtained from slab_alloc().  "size" must be the same
+// as used for the allocation.
+extern void slab_free(void* p, size_t size);
+
+// Statistics for a single size class, summed across all threads.
+struct SlabAllocClassStats {
+    size_t obj_size = 0;   // size of objects in this class
+    int64_t live = 0;      // objects currently allocated
+    int64_t slab_objs = 0; // objects that slabs have been carved into
+};
+
+// Returns the current statistics for the given size class.
+extern SlabAllocClassStats slab_alloc_class_stats(int size_class);
+
+// Starts periodically exporting the allocator statistics via telemetry.
+extern void init_slab_alloc_telemetry();
+
+} // namespace zeek::detail
@@ -10,6 +10,7 @@
 #include "zeek/RuleMatcher.h"
 #include "zeek/RunState.h"
 #include "zeek/Scope.h"
+#include "zeek/SubsystemStats.h"
 #include "zeek/Trigger.h"
 #include "zeek/broker/Manager.h"
 #include "zeek/input.h"
@@ -113,6 +114,11 @@ void ProfileLogger::Log() {
                           (utime + stime) - (first_utime + first_stime), utime - first_utime, stime - first_stime,
                           rtime - first_rtime));
 
+    file->Write(util::fmt("%.06f Subsystems: packet-analysis=%.1f analyzer=%.1f event=%.1f log=%.1f\n",
+                          run_state::network_time, SubsystemScope::TotalTime(Subsystem::PacketAnalysis),
+                          SubsystemScope::TotalTime(Subsystem::Analyzer), SubsystemScope::TotalTime(Subsystem::Event),
+                          SubsystemScope::TotalTime(Subsystem::Log)));
+
     // TODO: This previously output the number of connections, but now that we're storing
     // sessions as well as connections, this might need to be renamed.
     file->Write(util::fmt("%.06f Conns: total=%" PRIu64 " current=%" PRIu64 "/%u\n", run_state::network_time,
@@ -16,6 +16,7 @@
 #include "zeek/NetVar.h"
 #include "zeek/Reporter.h"
 #include "zeek/Scope.h"
+#include "zeek/ScriptProfile.h"
 #include "zeek/Traverse.h"
 #include "zeek/Trigger.h"
 #include "zeek/Var.h"
@@ -1468,6 +1469,10 @@ ValPtr StmtList::Exec(Frame* f, StmtFlowType& flow) {
     for ( const auto& stmt_ptr : stmts ) {
         auto stmt = stmt_ptr.get();
 
+        // Before moving on, so that a sample gets charged to the
+        // statement that just ran.
+        ScriptSampler::Checkpoint();
+
         f->SetNextStmt(stmt);
 
         if ( ! pre_execute_stmt(stmt, f) ) { // ### Abort or something
@@ -0,0 +1,170 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/SubsystemStats.h"
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "zeek/ID.h"
+#include "zeek/Val.h"
+#include "zeek/telemetry/Manager.h"
+
+namespace zeek::detail {
+
+int SubsystemScope::depth = 0;
+int64_t SubsystemScope::countdown = 0;
+int64_t SubsystemScope::sample_rate = 0;
+SubsystemScope* SubsystemScope::current = nullptr;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Where available, we measure in TSC ticks, which are cheaper to read
+// than the clock. Modern CPUs tick at a constant rate independent of
+// frequency scaling, which we determine by comparing against the clock
+// over the first second of measurements.
+#if defined(__x86_64__) || defined(__i386__)
+inline uint64_t read_ticks() { return __rdtsc(); }
+#else
+inline uint64_t read_ticks() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+#endif
+
+struct Calibration {
+    uint64_t start_ticks = 0;
+    Clock::time_point start_time;
+    double seconds_per_tick = 1e-9;
+    bool done = false;
+};
+
+Calibration calibration;
+
+double ticks_to_seconds(uint64_t ticks) {
+#if defined(__x86_64__) || defined(__i386__)
+    if ( ! calibration.done ) {
+        auto elapsed = std::chrono::duration<double>(Clock::now() - calibration.start_time).count();
+        auto elapsed_ticks = read_ticks() - calibration.start_ticks;
+
+        if ( elapsed <= 0.0 || elapsed_ticks == 0 )
+            return 0.0;
+
+        calibration.seconds_per_tick = elapsed / elapsed_ticks;
+        calibration.done = elapsed >= 1.0;
+    }
+#endif
+
+    return ticks * calibration.seconds_per_tick;
+}
+
+struct ComponentMetrics {
+    telemetry::DblCounter time;
+    telemetry::IntCounter samples;
+};
+
+struct SubsystemMetrics {
+    std::unordered_map<std::string, ComponentMetrics> components;
+    std::optional<telemetry::DblHistogram> sample_time;
+    double total_time = 0.0;
+};
+
+SubsystemMetrics subsystem_metrics[static_cast<int>(Subsystem::NUM_SUBSYSTEMS)];
+std::optional<telemetry::DblCounterFamily> time_family;
+std::optional<telemetry::IntCounterFamily> samples_family;
+std::optional<telemetry::DblHistogramFamily> sample_time_family;
+
+ComponentMetrics& get_component_metrics(Subsystem subsystem, const char* component) {
+    auto& components = subsystem_metrics[static_cast<int>(subsystem)].components;
+
+    if ( auto i = components.find(component); i != components.end() )
+        return i->second;
+
+    std::initializer_list<telemetry::LabelView> labels{{"subsystem", SubsystemScope::Name(subsystem)},
+                                                       {"component", component}};
+
+    auto [i, _] = components.emplace(component, ComponentMetrics{time_family->GetOrAdd(labels),
+                                                                 samples_family->GetOrAdd(labels)});
+    return i->second;
+}
+
+} // namespace
+
+void SubsystemScope::Init() {
+    sample_rate = id::find_val("subsystem_stats_sample_rate")->AsCount();
+    countdown = sample_rate;
+
+    if ( ! sample_rate )
+        return;
+
+    calibration.start_ticks = read_ticks();
+    calibration.start_time = Clock::now();
+
+    time_family = telemetry_mgr->CounterFamily<double>(
+        "zeek", "subsystem-time", {"subsystem", "component"},
+        "Estimated main-thread time spent in a component itself, excluding nested components", "seconds", true);
+
+    samples_family =
+        telemetry_mgr->CounterFamily("zeek", "subsystem-samples", {"subsystem", "component"},
+                                     "Number of invocations of a component that got measured", "1", true);
+
+    static const double sample_time_bounds[] = {0.000001, 0.00001, 0.0001, 0.001, 0.01, 0.1};
+
+    sample_time_family =
+        telemetry_mgr->HistogramFamily<double>("zeek", "subsystem-sample-time", {"subsystem"}, sample_time_bounds,
+                                               "Time spent in a single measured invocation", "seconds");
+
+    for ( int i = 0; i < static_cast<int>(Subsystem::NUM_SUBSYSTEMS); ++i )
+        subsystem_metrics[i].sample_time = sample_time_family->GetOrAdd({{"subsystem", Name(Subsystem(i))}});
+}
+
+double SubsystemScope::TotalTime(Subsystem subsystem) {
+    return subsystem_metrics[static_cast<int>(subsystem)].total_time;
+}
+
+const char* SubsystemScope::Name(Subsystem subsystem) {
+    switch ( subsystem ) {
+        case Subsystem::PacketAnalysis: return "packet-analysis";
+        case Subsystem::Analyzer: return "analyzer";
+        case Subsystem::Event: return "event";
+        case Subsystem::Log: return "log";
+        default: return "unknown";
+    }
+}
+
+void SubsystemScope::Start(Subsystem arg_subsystem, const char* arg_component) {
+    subsystem = arg_subsystem;
+    component = arg_component;
+    parent = current;
+    sampled = true;
+    current = this;
+    start = read_ticks();
+}
+
+void SubsystemScope::Finish() {
+    auto elapsed = read_ticks() - start;
+    auto self = elapsed > children ? elapsed - children : 0;
+    auto secs = ticks_to_seconds(self);
+
+    auto& metrics = subsystem_metrics[static_cast<int>(subsystem)];
+    metrics.total_time += secs * sample_rate;
+    metrics.sample_time->Observe(secs);
+
+    auto& cm = get_component_metrics(subsystem, component);
+    cm.time.Inc(secs * sample_rate);
+    cm.samples.Inc();
+
+    current = parent;
+
+    // Charge our own bookkeeping to nobody, rather than the parent.
+    if ( parent )
+        parent->children += read_ticks() - start;
+}
+
+} // namespace zeek::detail
@@ -0,0 +1,115 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+// Always-on, sampled accounting of where the main thread spends its time,
+// broken down by subsystem (packet analysis, protocol analyzers, event
+// handlers, log writes) and, within each, by component (analyzer name,
+// event name, log stream). Scopes mark the code regions to account for.
+// Only one in every subsystem_stats_sample_rate outermost scopes gets
+// measured, along with the scopes nested inside it, so that the common
+// case costs no more than a counter update. Time of nested scopes gets
+// subtracted from their parent's, which means each component is charged
+// only for the work it does itself.
+
+#pragma once
+
+#include <cstdint>
+
+namespace zeek::detail {
+
+enum class Subsystem : uint8_t {
+    PacketAnalysis,
+    Analyzer,
+    Event,
+    Log,
+    NUM_SUBSYSTEMS,
+};
+
+class [[nodiscard]] SubsystemScope {
+public:
+    /**
+     * Starts accounting for a code region.
+     *
+     * @param subsystem The subsystem to charge.
+     *
+     * @param component The name of the component to charge within the
+     * subsystem. The pointer must remain valid for the scope's lifetime.
+     */
+    SubsystemScope(Subsystem subsystem, const char* component) : SubsystemScope(subsystem, component, nullptr) {}
+
+    /**
+     * Starts accounting for an analyzer's work. As looking up an analyzer's
+     * name isn't free, that happens only if the scope gets measured.
+     *
+     * @param subsystem The subsystem to charge.
+     *
+     * @param analyzer The analyzer to charge within the subsystem, by the
+     * name its GetAnalyzerName() returns.
+     */
+    template<typename T>
+    SubsystemScope(Subsystem subsystem, const T* analyzer)
+        : SubsystemScope(subsystem, analyzer,
+                         [](const void* a) -> const char* { return static_cast<const T*>(a)->GetAnalyzerName(); }) {}
+
+    ~SubsystemScope() {
+        --depth;
+
+        if ( sampled )
+            Finish();
+    }
+
+    SubsystemScope(const SubsystemScope&) = delete;
+    SubsystemScope& operator=(const SubsystemScope&) = delete;
+
+    /**
+     * Enables accounting according to the subsystem_stats_sample_rate
+     * script-level option. Must be called after telemetry is set up.
+     */
+    static void Init();
+
+    /**
+     * Returns the estimated total time, in seconds, that the given
+     * subsystem has consumed so far.
+     */
+    static double TotalTime(Subsystem subsystem);
+
+    /**
+     * Returns the name of a subsystem as used for telemetry.
+     */
+    static const char* Name(Subsystem subsystem);
+
+private:
+    // Resolves the name of the component an object stands for.
+    using NameFunc = const char* (*)(const void*);
+
+    // If name_func is null, the object is the component's name itself.
+    SubsystemScope(Subsystem subsystem, const void* obj, NameFunc name_func) {
+        if ( depth++ == 0 ) {
+            if ( ! sample_rate || --countdown > 0 )
+                return;
+
+            countdown = sample_rate;
+        }
+
+        else if ( ! current )
+            return;
+
+        Start(subsystem, name_func ? name_func(obj) : static_cast<const char*>(obj));
+    }
+
+    void Start(Subsystem subsystem, const char* component);
+    void Finish();
+
+    static int depth;
+    static int64_t countdown;
+    static int64_t sample_rate; // 0 disables accounting
+    static SubsystemScope* current;
+
+    SubsystemScope* parent = nullptr;
+    const char* component = nullptr;
+    uint64_t start = 0;
+    uint64_t children = 0; // ticks spent in nested scopes
+    Subsystem subsystem = Subsystem::NUM_SUBSYSTEMS;
+    bool sampled = false;
+};
+
+} // namespace zeek::detail
@@ -40,6 +40,7 @@
 #include "zeek/broker/Data.h"
 #include "zeek/broker/Manager.h"
 #include "zeek/broker/Store.h"
+#include "zeek/telemetry/Manager.h"
 #include "zeek/threading/formatters/detail/json.h"
 
 using namespace std;
@@ -3883,8 +3884,45 @@ unsigned int Val::Footprint(std::unordered_set<const Val*>* analyzed_vals) const
     return fp;
 }
 
+namespace {
+
+// The strings that InternedString() shares. Analyzers see these values
+// over and over, but they may also see arbitrary other values from the
+// network, which is why the table doesn't grow beyond this set.
+constexpr std::string_view interned_vocabulary[] = {
+    // HTTP request methods, RFC 9110 and WebDAV.
+    "GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH", "PROPFIND", "PROPPATCH", "MKCOL",
+    "COPY", "MOVE", "LOCK", "UNLOCK",
+
+    // HTTP versions and the HTTP analyzer's placeholder for missing
+    // reason phrases.
+    "0.9", "1.0", "1.1", "2.0", "<empty>",
+
+    // DNS ECS address families.
+    "v4", "v6",
+
+    // Upper-cased MIME types and subtypes as reported by the MIME analyzer.
+    "TEXT", "IMAGE", "AUDIO", "VIDEO", "APPLICATION", "MULTIPART", "MESSAGE", "FONT", "PLAIN", "HTML", "CSS", "XML",
+    "JSON", "JAVASCRIPT", "CALENDAR", "MIXED", "ALTERNATIVE", "RELATED", "REPORT", "SIGNED", "FORM-DATA", "RFC822",
+    "DELIVERY-STATUS", "OCTET-STREAM", "PDF", "ZIP", "X-WWW-FORM-URLENCODED", "MSWORD", "PKCS7-SIGNATURE",
+    "PKCS7-MIME", "MS-TNEF", "JPEG", "PNG", "GIF", "WEBP",
+
+    // Common file MIME types.
+    "text/plain", "text/html", "text/css", "text/javascript", "text/json", "text/xml", "application/octet-stream",
+    "application/json", "application/xml", "application/javascript", "application/pdf", "application/zip",
+    "application/x-dosexec", "application/x-gzip", "application/pkix-cert", "application/ocsp-request",
+    "application/ocsp-response", "image/jpeg", "image/png", "image/gif", "image/webp", "image/x-icon"};
+
+} // namespace
+
 ValManager::ValManager() {
     empty_string = make_intrusive<StringVal>("");
+
+    for ( auto s : interned_vocabulary ) {
+        auto sv = make_intrusive<StringVal>(s);
+        interned_strings.emplace(sv->ToStdStringView(), std::move(sv));
+    }
+
     b_false = Val::MakeBool(false);
     b_true = Val::MakeBool(true);
 
@@ -3905,6 +3943,45 @@ ValManager::ValManager() {
 #endif
 }
 
+namespace {
+
+// Created on first use, as the ValManager comes into existence before
+// the telemetry manager.
+std::optional<telemetry::IntCounter> interned_string_hits;
+std::optional<telemetry::IntCounter> interned_string_misses;
+
+void count_interned_string_lookup(bool hit) {
+    if ( ! interned_string_hits ) {
+        if ( ! telemetry_mgr )
+            return;
+
+        auto family = telemetry_mgr->CounterFamily("zeek", "interned-string-lookups", {"result"},
+                                                   "Number of lookups in the interned string table", "1", true);
+        interned_string_hits = family.GetOrAdd({{"result", "hit"}});
+        interned_string_misses = family.GetOrAdd({{"result", "miss"}});
+    }
+
+    if ( hit )
+        interned_string_hits->Inc();
+    else
+        interned_string_misses->Inc();
+}
+
+} // namespace
+
+StringValPtr ValManager::InternedString(std::string_view s) {
+    if ( s.empty() )
+        return empty_string;
+
+    if ( auto it = interned_strings.find(s); it != interned_strings.end() ) {
+        count_interned_string_lookup(true);
+        return it->second;
+    }
+
+    count_interned_string_lookup(false);
+    return make_intrusive<StringVal>(s);
+}
+
 const PortValPtr& ValManager::Port(uint32_t port_num, TransportProto port_type) {
     if ( port_num >= 65536 ) {
         reporter->Warning("bad port number %d", port_num);
@@ -329,6 +329,15 @@ public:
 
     inline const StringValPtr& EmptyString() const { return empty_string; }
 
+    // Returns a StringVal holding the given string.  Values that
+    // analyzers produce over and over (request methods, MIME types,
+    // ...) are shared through an intern table with a fixed vocabulary,
+    // so they don't need a new StringVal for each occurrence.  Other
+    // strings are simply allocated as usual, which keeps input from the
+    // network from growing the table.  The returned value must not be
+    // modified.
+    StringValPtr InternedString(std::string_view s);
+
     // Port number given in host order.
     const PortValPtr& Port(uint32_t port_num, TransportProto port_type);
 
@@ -345,6 +354,10 @@ private:
     std::array<ValPtr, PREALLOCATED_COUNTS> counts;
     std::array<ValPtr, PREALLOCATED_INTS> ints;
     StringValPtr empty_string;
+
+    // Keyed by views of the interned values' own bytes.
+    std::unordered_map<std::string_view, StringValPtr> interned_strings;
+
     ValPtr b_true;
     ValPtr b_false;
 };
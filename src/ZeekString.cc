@@ -35,6 +35,7 @@ String::String(bool arg_final_NUL, byte_vec str, int arg_n) {
     n = arg_n;
     final_NUL = arg_final_NUL;
     use_free_to_delete = false;
+    is_inline = false;
 }
 
 String::String(const u_char* str, int arg_n, bool add_NUL) : String() { Set(str, arg_n, add_NUL); }
@@ -48,18 +49,22 @@ String::String() {
     n = 0;
     final_NUL = false;
     use_free_to_delete = false;
+    is_inline = false;
 }
 
 void String::Reset() {
-    if ( use_free_to_delete )
-        free(b);
-    else
-        delete[] b;
+    if ( ! IsInline() ) {
+        if ( use_free_to_delete )
+            free(b);
+        else
+            delete[] b;
+    }
 
     b = nullptr;
     n = 0;
     final_NUL = false;
     use_free_to_delete = false;
+    is_inline = false;
 }
 
 const String& String::operator=(const String& bs) {
@@ -68,10 +73,10 @@ const String& String::operator=(const String& bs) {
 
     Reset();
     n = bs.n;
-    b = new u_char[n + 1];
+    auto bytes = Alloc(n + 1);
 
-    memcpy(b, bs.b, n);
-    b[n] = '\0';
+    memcpy(bytes, bs.Bytes(), n);
+    bytes[n] = '\0';
 
     final_NUL = true;
     use_free_to_delete = false;
@@ -86,11 +91,11 @@ bool String::operator==(std::string_view s) const {
     if ( static_cast<size_t>(n) != s.size() )
         return false;
 
-    if ( b == nullptr ) {
+    if ( Bytes() == nullptr ) {
         return s.size() == 0;
     }
 
-    return (memcmp(b, s.data(), n) == 0);
+    return (memcmp(Bytes(), s.data(), n) == 0);
 }
 
 bool String::operator!=(std::string_view s) const { return ! (*this == s); }
@@ -110,12 +115,12 @@ void String::Set(const u_char* str, int len, bool add_NUL) {
     Reset();
 
     n = len;
-    b = new u_char[add_NUL ? n + 1 : n];
-    memcpy(b, str, n);
+    auto bytes = Alloc(add_NUL ? n + 1 : n);
+    memcpy(bytes, str, n);
     final_NUL = add_NUL;
 
     if ( add_NUL )
-        b[n] = 0;
+        bytes[n] = 0;
 
     use_free_to_delete = false;
 }
@@ -125,9 +130,9 @@ void String::Set(std::string_view str) {
 
     if ( ! str.empty() ) {
         n = str.size();
-        b = new u_char[n + 1];
-        memcpy(b, str.data(), n);
-        b[n] = 0;
+        auto bytes = Alloc(n + 1);
+        memcpy(bytes, str.data(), n);
+        bytes[n] = 0;
         final_NUL = true;
         use_free_to_delete = false;
     }
@@ -140,8 +145,9 @@ std::pair<const char*, size_t> String::CheckStringWithSize() const {
     if ( n == 0 )
         return {"", 0};
 
-    nulTerm = memchr(b, '\0', n + final_NUL);
-    if ( nulTerm != &b[n] ) {
+    auto bytes = Bytes();
+    nulTerm = memchr(bytes, '\0', n + final_NUL);
+    if ( nulTerm != &bytes[n] ) {
         // Either an embedded NUL, or no final NUL.
         char* exp_s = Render();
 
@@ -155,7 +161,7 @@ std::pair<const char*, size_t> String::CheckStringWithSize() const {
         return {result, std::size(result) - 1};
     }
 
-    return {(const char*)b, n};
+    return {(const char*)bytes, n};
 }
 
 const char* String::CheckString() const { return CheckStringWithSize().first; }
@@ -165,34 +171,35 @@ char* String::Render(int format, int* len) const {
     char* s = new char[n * 4 + 1]; // +1 is for final '\0'
     char* sp = s;
     int tmp_len;
+    auto bytes = Bytes();
 
     for ( int i = 0; i < n; ++i ) {
-        if ( b[i] == '\\' && (format & ESC_ESC) ) {
+        if ( bytes[i] == '\\' && (format & ESC_ESC) ) {
             *sp++ = '\\';
             *sp++ = '\\';
         }
 
-        else if ( (b[i] == '\'' || b[i] == '"') && (format & ESC_QUOT) ) {
+        else if ( (bytes[i] == '\'' || bytes[i] == '"') && (format & ESC_QUOT) ) {
             *sp++ = '\\';
-            *sp++ = b[i];
+            *sp++ = bytes[i];
         }
 
-        else if ( (b[i] < ' ' || b[i] > 126) && (format & ESC_HEX) ) {
+        else if ( (bytes[i] < ' ' || bytes[i] > 126) && (format & ESC_HEX) ) {
             char hex_fmt[16];
 
             *sp++ = '\\';
             *sp++ = 'x';
-            snprintf(hex_fmt, 16, "%02x", b[i]);
+            snprintf(hex_fmt, 16, "%02x", bytes[i]);
             *sp++ = hex_fmt[0];
             *sp++ = hex_fmt[1];
         }
 
-        else if ( (b[i] < ' ' || b[i] > 126) && (format & ESC_DOT) ) {
+        else if ( (bytes[i] < ' ' || bytes[i] > 126) && (format & ESC_DOT) ) {
             *sp++ = '.';
         }
 
         else {
-            *sp++ = b[i];
+            *sp++ = bytes[i];
         }
     }
 
@@ -245,9 +252,11 @@ std::istream& String::Read(std::istream& is, int format) {
 }
 
 void String::ToUpper() {
+    auto bytes = Bytes();
+
     for ( int i = 0; i < n; ++i )
-        if ( islower(b[i]) )
-            b[i] = toupper(b[i]);
+        if ( islower(bytes[i]) )
+            bytes[i] = toupper(bytes[i]);
 }
 
 String* String::GetSubstring(int start, int len) const {
@@ -258,10 +267,10 @@ String* String::GetSubstring(int start, int len) const {
     if ( len < 0 || len > n - start )
         len = n - start;
 
-    return new String(&b[start], len, true);
+    return new String(&Bytes()[start], len, true);
 }
 
-int String::FindSubstring(const String* s) const { return util::strstr_n(n, b, s->Len(), s->Bytes()); }
+int String::FindSubstring(const String* s) const { return util::strstr_n(n, Bytes(), s->Len(), s->Bytes()); }
 
 String::Vec* String::Split(const String::IdxVec& indices) const {
     size_t i;
@@ -527,6 +536,35 @@ TEST_CASE("set/assignment/comparison") {
     CHECK_FALSE(s < s5);
 }
 
+TEST_CASE("inline storage") {
+    zeek::String s{"GET"};
+    CHECK(s.IsInline());
+    CHECK_EQ(std::string(s.CheckString()), "GET");
+
+    zeek::String s2{s};
+    CHECK(s2.IsInline());
+    CHECK_NE(s2.Bytes(), s.Bytes());
+    CHECK_EQ(s2, s);
+
+    std::string long_str(zeek::String::INLINE_SIZE, 'x');
+    s.Set(long_str);
+    CHECK_FALSE(s.IsInline());
+    CHECK_EQ(s, long_str);
+
+    s2 = s;
+    CHECK_FALSE(s2.IsInline());
+    s2.Set("POST");
+    CHECK(s2.IsInline());
+    CHECK_EQ(s2, "POST");
+
+    s.Set(reinterpret_cast<const u_char*>("abcdefghijklmnop"), zeek::String::INLINE_SIZE, false);
+    CHECK(s.IsInline());
+    CHECK_EQ(s.Len(), zeek::String::INLINE_SIZE);
+
+    s.ToUpper();
+    CHECK_EQ(s, std::string_view("ABCDEFGHIJKLMNOP", zeek::String::INLINE_SIZE));
+}
+
 TEST_CASE("searching/modification") {
     zeek::String s{"this is a test"};
     auto* ss = s.GetSubstring(5, 4);
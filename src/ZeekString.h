@@ -56,7 +56,7 @@ public:
     bool operator==(std::string_view s) const;
     bool operator!=(std::string_view s) const;
 
-    byte_vec Bytes() const { return b; }
+    byte_vec Bytes() const { return is_inline ? const_cast<byte_vec>(inline_buf) : b; }
     int Len() const { return n; }
 
     // Releases the string's current contents, if any, and
@@ -156,13 +156,39 @@ public:
     static Vec* VecFromPolicy(VectorVal* vec);
     static char* VecToString(const Vec* vec);
 
+    // Size of the buffer for holding short strings directly inside the
+    // String rather than in a separate allocation.  This includes the
+    // final NUL, if any.  The buffer takes the place of the pointer to
+    // the allocation, so it doesn't make Strings any larger.
+    static constexpr int INLINE_SIZE = sizeof(byte_vec);
+
+    // Returns true if the bytes are stored inside the String itself.
+    bool IsInline() const { return is_inline; }
+
 protected:
     void Reset();
 
-    byte_vec b;
+    // Returns a buffer for holding the given number of bytes, which
+    // will be inline_buf if it's large enough.  Must only be called
+    // right after Reset().
+    byte_vec Alloc(int size) {
+        is_inline = size <= INLINE_SIZE;
+
+        if ( ! is_inline )
+            b = new u_char[size];
+
+        return Bytes();
+    }
+
+    union {
+        byte_vec b;                     // if ! is_inline
+        u_char inline_buf[INLINE_SIZE]; // if is_inline
+    };
+
     int n;
     bool final_NUL;          // whether we have added a final NUL
     bool use_free_to_delete; // free() vs. operator delete
+    bool is_inline;          // whether the bytes live in inline_buf
 };
 
 // A comparison class that sorts pointers to String's according to
@@ -7,9 +7,11 @@
 
 #include "zeek/3rdparty/doctest.h"
 #include "zeek/Event.h"
+#include "zeek/SubsystemStats.h"
 #include "zeek/ZeekString.h"
 #include "zeek/analyzer/Manager.h"
 #include "zeek/analyzer/protocol/pia/PIA.h"
+#include "zeek/packet_analysis/protocol/ip/SessionAdapter.h"
 
 namespace zeek::analyzer {
 
@@ -193,6 +195,8 @@ void Analyzer::NextPacket(int len, const u_char* data, bool is_orig, uint64_t se
         next_sibling->NextPacket(len, data, is_orig, seq, ip, caplen);
 
     else {
+        zeek::detail::SubsystemScope scope(zeek::detail::Subsystem::Analyzer, this);
+
         try {
             DeliverPacket(len, data, is_orig, seq, ip, caplen);
         } catch ( binpac::Exception const& e ) {
@@ -211,6 +215,8 @@ void Analyzer::NextStream(int len, const u_char* data, bool is_orig) {
         next_sibling->NextStream(len, data, is_orig);
 
     else {
+        zeek::detail::SubsystemScope scope(zeek::detail::Subsystem::Analyzer, this);
+
         try {
             DeliverStream(len, data, is_orig);
         } catch ( binpac::Exception const& e ) {
@@ -229,6 +235,8 @@ void Analyzer::NextUndelivered(uint64_t seq, int len, bool is_orig) {
         next_sibling->NextUndelivered(seq, len, is_orig);
 
     else {
+        zeek::detail::SubsystemScope scope(zeek::detail::Subsystem::Analyzer, this);
+
         try {
             Undelivered(seq, len, is_orig);
         } catch ( binpac::Exception const& e ) {
@@ -245,8 +253,10 @@ void Analyzer::NextEndOfData(bool is_orig) {
 
     if ( next_sibling )
         next_sibling->NextEndOfData(is_orig);
-    else
+    else {
+        zeek::detail::SubsystemScope scope(zeek::detail::Subsystem::Analyzer, this);
         EndOfData(is_orig);
+    }
 }
 
 void Analyzer::ForwardPacket(int len, const u_char* data, bool is_orig, uint64_t seq, const IP_Hdr* ip, int caplen) {
@@ -383,6 +393,10 @@ bool Analyzer::RemoveChild(const analyzer_list& children, ID id) {
         // something not true because of a violation that
         // triggered the removal in the first place.
         i->removing = true;
+
+        if ( auto adapter = conn ? conn->GetSessionAdapter() : nullptr )
+            adapter->PayloadNeedsChanged();
+
         return true;
     }
 
@@ -408,6 +422,36 @@ bool Analyzer::IsPreventedChildAnalyzer(const zeek::Tag& tag) const {
     return std::find(prevented.begin(), prevented.end(), tag) != prevented.end();
 }
 
+void Analyzer::SetPayloadDone() {
+    if ( payload_done )
+        return;
+
+    DBG_LOG(DBG_ANALYZER, "%s needs no further payload", fmt_analyzer(this).c_str());
+    payload_done = true;
+
+    if ( auto adapter = conn ? conn->GetSessionAdapter() : nullptr )
+        adapter->PayloadNeedsChanged();
+}
+
+bool Analyzer::NeedsPayload() const {
+    if ( skip || finished || removing )
+        return false;
+
+    return ! payload_done || ChildrenNeedPayload();
+}
+
+bool Analyzer::ChildrenNeedPayload() const {
+    LOOP_OVER_CHILDREN(i)
+    if ( (*i)->NeedsPayload() )
+        return true;
+
+    LOOP_OVER_GIVEN_CHILDREN(i, new_children)
+    if ( (*i)->NeedsPayload() )
+        return true;
+
+    return false;
+}
+
 bool Analyzer::HasChildAnalyzer(const zeek::Tag& tag) const { return GetChildAnalyzer(tag) != nullptr; }
 
 Analyzer* Analyzer::GetChildAnalyzer(const zeek::Tag& tag) const {
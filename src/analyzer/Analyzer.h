@@ -330,6 +330,22 @@ public:
      */
     bool Skipping() const { return skip; }
 
+    /**
+     * Signals that the analyzer doesn't need to see any further payload,
+     * for example because all that's left is encrypted. Unlike
+     * SetSkip(), the analyzer keeps receiving all other notifications.
+     * Once no analyzer of a connection needs payload anymore, the
+     * session adapter may stop reassembling and passing it on; see
+     * IP::SessionAdapter::CheckPayloadBypass().
+     */
+    void SetPayloadDone();
+
+    /**
+     * Returns true if the analyzer, or any of its children, still needs
+     * to see payload.
+     */
+    bool NeedsPayload() const;
+
     /**
      * Returns true if Done() has been called.
      */
@@ -639,6 +655,12 @@ protected:
      */
     void SetConnection(Connection* c) { conn = c; }
 
+    /**
+     * Returns true if any of the analyzer's children still needs to see
+     * payload.
+     */
+    bool ChildrenNeedPayload() const;
+
     /**
      * Instantiates a new timer associated with the analyzer.
      *
@@ -747,6 +769,7 @@ private:
     bool skip;
     bool finished;
     bool removing;
+    bool payload_done = false;
 
     uint64_t analyzer_violations = 0;
 
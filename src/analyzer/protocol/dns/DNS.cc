@@ -632,7 +632,7 @@ bool DNS_Interpreter::ParseRR_EDNS(detail::DNS_MsgInfo* msg, const u_char*& data
                         break;
                     }
 
-                    opt.ecs_family = make_intrusive<StringVal>("v4");
+                    opt.ecs_family = val_mgr->InternedString("v4");
                     uint32_t addr = 0;
                     uint16_t shift_factor = 3;
                     int bits_left = opt.ecs_src_pfx_len;
@@ -663,7 +663,7 @@ bool DNS_Interpreter::ParseRR_EDNS(detail::DNS_MsgInfo* msg, const u_char*& data
                         break;
                     }
 
-                    opt.ecs_family = make_intrusive<StringVal>("v6");
+                    opt.ecs_family = val_mgr->InternedString("v6");
                     uint32_t addr[4] = {0};
                     uint16_t shift_factor = 15;
                     int bits_left = opt.ecs_src_pfx_len;
@@ -688,10 +688,11 @@ bool MIME_Entity::ParseContentTypeField(MIME_Header* h) {
     data += offset;
     len -= offset;
 
-    content_type_str = make_intrusive<StringVal>(ty.length, ty.data);
-    content_type_str->ToUpper();
-    content_subtype_str = make_intrusive<StringVal>(subty.length, subty.data);
-    content_subtype_str->ToUpper();
+    // Types recur across messages, so share their values.
+    auto upper_ty = util::to_upper(std::string(ty.data, ty.length));
+    auto upper_subty = util::to_upper(std::string(subty.data, subty.length));
+    content_type_str = val_mgr->InternedString(upper_ty);
+    content_subtype_str = val_mgr->InternedString(upper_subty);
 
     ParseContentType(ty, subty);
 
@@ -244,6 +244,9 @@ void PIA_TCP::DeliverStream(int len, const u_char* data, bool is_orig) {
     DoMatch(data, len, is_orig, false, false, false, nullptr);
 
     stream_buffer.state = new_state;
+
+    if ( stream_buffer.state == SKIPPING )
+        SetPayloadDone();
 }
 
 void PIA_TCP::Undelivered(uint64_t seq, int len, bool is_orig) {
@@ -258,6 +261,9 @@ void PIA_TCP::Undelivered(uint64_t seq, int len, bool is_orig) {
     if ( ++stream_buffer.chunks > zeek::detail::dpd_max_packets ) {
         stream_buffer.state = zeek::detail::dpd_match_only_beginning ? SKIPPING : MATCHING_ONLY;
         DBG_LOG(DBG_ANALYZER, "PIA_TCP[%d] buffer chunks exceeded", GetID());
+
+        if ( stream_buffer.state == SKIPPING )
+            SetPayloadDone();
     }
 }
 
@@ -277,6 +283,10 @@ void PIA_TCP::ActivateAnalyzer(zeek::Tag tag, const zeek::detail::Rule* rule) {
         }
 
         stream_buffer.state = zeek::detail::dpd_late_match_stop ? SKIPPING : MATCHING_ONLY;
+
+        if ( stream_buffer.state == SKIPPING )
+            SetPayloadDone();
+
         return;
     }
 
@@ -78,6 +78,11 @@ void SSH_Analyzer::ProcessEncryptedSegment(int len, bool orig) {
 
     if ( ! auth_decision_made )
         ProcessEncrypted(len, orig);
+
+    // Without anybody interested in the individual encrypted packets,
+    // there's nothing left to look at.
+    else if ( ! ssh_encrypted_packet )
+        SetPayloadDone();
 }
 
 void SSH_Analyzer::ProcessEncrypted(int len, bool orig) {
@@ -92,6 +92,16 @@ void TCP_Endpoint::CheckEOF() {
         contents_processor->CheckEOF();
 }
 
+void TCP_Endpoint::FlushCoalesced() {
+    if ( contents_processor )
+        contents_processor->FlushCoalesced();
+}
+
+void TCP_Endpoint::StopDeliveries() {
+    if ( contents_processor )
+        contents_processor->StopDeliveries();
+}
+
 void TCP_Endpoint::SizeBufferedData(uint64_t& waiting_on_hole, uint64_t& waiting_on_ack) {
     if ( contents_processor )
         contents_processor->SizeBufferedData(waiting_on_hole, waiting_on_ack);
@@ -154,6 +154,14 @@ public:
     bool HasUndeliveredData() const;
     void CheckEOF();
 
+    // Passes on any payload the reassembler collected for a combined
+    // delivery.
+    void FlushCoalesced();
+
+    // Discards any payload the reassembler holds and ignores further
+    // payload, as the connection's analyzers don't need it anymore.
+    void StopDeliveries();
+
     // Returns the volume of data buffered in the reassembler.
     // First parameter returns data that is above a hole, and thus is
     // waiting on the hole being filled.  Second parameter returns
@@ -1,6 +1,7 @@
 #include "zeek/analyzer/protocol/tcp/TCP_Reassembler.h"
 
 #include <algorithm>
+#include <optional>
 
 #include "zeek/File.h"
 #include "zeek/Reporter.h"
@@ -11,6 +12,7 @@
 #include "zeek/analyzer/protocol/tcp/TCP_Endpoint.h"
 #include "zeek/analyzer/protocol/tcp/events.bif.h"
 #include "zeek/packet_analysis/protocol/tcp/TCPSessionAdapter.h"
+#include "zeek/telemetry/Manager.h"
 
 namespace zeek::analyzer::tcp {
 
@@ -20,6 +22,29 @@ constexpr bool DEBUG_tcp_contents = false;
 constexpr bool DEBUG_tcp_connection_close = false;
 constexpr bool DEBUG_tcp_match_undelivered = false;
 
+static std::optional<telemetry::IntCounter> stream_deliveries;
+static std::optional<telemetry::IntCounter> stream_delivered_bytes;
+
+static void count_stream_delivery(int len) {
+    if ( ! stream_deliveries ) {
+        if ( ! telemetry_mgr )
+            return;
+
+        stream_deliveries =
+            telemetry_mgr
+                ->CounterFamily("zeek", "tcp-stream-deliveries", {}, "Number of reassembled TCP payload deliveries",
+                                "1", true)
+                .GetOrAdd({});
+        stream_delivered_bytes =
+            telemetry_mgr
+                ->CounterFamily("zeek", "tcp-stream-delivered", {}, "Reassembled TCP payload delivered", "bytes", true)
+                .GetOrAdd({});
+    }
+
+    stream_deliveries->Inc();
+    stream_delivered_bytes->Inc(len);
+}
+
 TCP_Reassembler::TCP_Reassembler(analyzer::Analyzer* arg_dst_analyzer,
                                  packet_analysis::TCP::TCPSessionAdapter* arg_tcp_analyzer,
                                  TCP_Reassembler::Type arg_type, TCP_Endpoint* arg_endp)
@@ -34,6 +59,8 @@ TCP_Reassembler::TCP_Reassembler(analyzer::Analyzer* arg_dst_analyzer,
     did_EOF = false;
     seq_to_skip = 0;
     in_delivery = false;
+    coalesced_seq = 0;
+    coalesced_time = 0.0;
 
     if ( zeek::detail::tcp_max_old_segments )
         SetMaxOldBlocks(zeek::detail::tcp_max_old_segments);
@@ -52,6 +79,7 @@ TCP_Reassembler::TCP_Reassembler(analyzer::Analyzer* arg_dst_analyzer,
 }
 
 void TCP_Reassembler::Done() {
+    FlushCoalesced();
     MatchUndelivered(-1, true);
 
     if ( record_contents_file ) { // Record any undelivered data.
@@ -111,6 +139,10 @@ static inline bool report_gap(const TCP_Endpoint* a, const TCP_Endpoint* b) {
 }
 
 void TCP_Reassembler::Gap(uint64_t seq, uint64_t len) {
+    // Anything collected precedes the gap.
+    FlushCoalesced();
+    FlushPeer();
+
     // Only report on content gaps for connections that
     // are in a cleanly established or closing  state. In
     // other states, these can arise falsely due to things
@@ -403,6 +435,8 @@ void TCP_Reassembler::Overlap(const u_char* b1, const u_char* b2, uint64_t n) {
 }
 
 void TCP_Reassembler::Deliver(uint64_t seq, int len, const u_char* data) {
+    count_stream_delivery(len);
+
     if ( type == Direct )
         dst_analyzer->NextStream(len, data, IsOrig());
     else
@@ -422,6 +456,9 @@ bool TCP_Reassembler::DataSent(double t, uint64_t seq, int len, const u_char* da
     if ( skip_deliveries )
         return false;
 
+    if ( ! coalesced.empty() && run_state::network_time - coalesced_time >= zeek::detail::tcp_coalesce_window )
+        FlushCoalesced();
+
     if ( seq < ack && ! replaying ) {
         if ( upper_seq <= ack )
             // We've already delivered this and it's been acked.
@@ -510,6 +547,7 @@ void TCP_Reassembler::CheckEOF() {
         }
 
         did_EOF = true;
+        FlushCoalesced();
         tcp_analyzer->EndpointEOF(this);
     }
 }
@@ -542,6 +580,11 @@ void TCP_Reassembler::DeliverBlock(uint64_t seq, int len, const u_char* data) {
     if ( skip_deliveries )
         return;
 
+    if ( zeek::detail::tcp_coalesce_max_size > 0 ) {
+        Coalesce(seq, len, data);
+        return;
+    }
+
     in_delivery = true;
     Deliver(seq, len, data);
     in_delivery = false;
@@ -550,6 +593,78 @@ void TCP_Reassembler::DeliverBlock(uint64_t seq, int len, const u_char* data) {
         SkipToSeq(seq_to_skip);
 }
 
+void TCP_Reassembler::Coalesce(uint64_t seq, int len, const u_char* data) {
+    // Before delivering anything in this direction, deliver what the other
+    // direction still holds on to, so that analyzers see the data in the
+    // order it arrived.
+    FlushPeer();
+
+    if ( ! coalesced.empty() && seq != coalesced_seq + coalesced.size() )
+        FlushCoalesced();
+
+    auto max_size = static_cast<size_t>(zeek::detail::tcp_coalesce_max_size);
+
+    if ( coalesced.empty() ) {
+        if ( static_cast<size_t>(len) >= max_size ) {
+            // Large enough already, no need to copy it.
+            in_delivery = true;
+            Deliver(seq, len, data);
+            in_delivery = false;
+            return;
+        }
+
+        coalesced_seq = seq;
+        coalesced_time = run_state::network_time;
+
+        // Make sure the data goes out in time even if no further
+        // segments arrive.
+        tcp_analyzer->ScheduleCoalesceFlush(CoalescedDue());
+    }
+
+    coalesced.append(reinterpret_cast<const char*>(data), len);
+
+    if ( coalesced.size() >= max_size )
+        FlushCoalesced();
+}
+
+void TCP_Reassembler::FlushCoalesced() {
+    if ( coalesced.empty() )
+        return;
+
+    // Delivery may trigger further deliveries in this direction, which
+    // need to start out with an empty buffer. Taking the data also
+    // releases the buffer once delivered, rather than tying up memory
+    // for connections that may stay idle.
+    std::string data;
+    data.swap(coalesced);
+
+    // We may have decided to skip the rest while collecting.
+    if ( skip_deliveries )
+        return;
+
+    in_delivery = true;
+    Deliver(coalesced_seq, data.size(), reinterpret_cast<const u_char*>(data.data()));
+    in_delivery = false;
+}
+
+double TCP_Reassembler::CoalescedDue() const {
+    if ( coalesced.empty() )
+        return 0.0;
+
+    return coalesced_time + zeek::detail::tcp_coalesce_window;
+}
+
+void TCP_Reassembler::StopDeliveries() {
+    std::string().swap(coalesced);
+    ClearBlocks();
+    skip_deliveries = true;
+}
+
+void TCP_Reassembler::FlushPeer() {
+    if ( auto peer = endp->peer->contents_processor )
+        peer->FlushCoalesced();
+}
+
 void TCP_Reassembler::SkipToSeq(uint64_t seq) {
     if ( seq > seq_to_skip ) {
         seq_to_skip = seq;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+
 #include "zeek/File.h"
 #include "zeek/Reassem.h"
 #include "zeek/analyzer/protocol/tcp/TCP_Endpoint.h"
@@ -30,8 +32,15 @@ public:
 
     void Done();
 
-    void SetDstAnalyzer(analyzer::Analyzer* analyzer) { dst_analyzer = analyzer; }
-    void SetType(Type arg_type) { type = arg_type; }
+    void SetDstAnalyzer(analyzer::Analyzer* analyzer) {
+        FlushCoalesced();
+        dst_analyzer = analyzer;
+    }
+
+    void SetType(Type arg_type) {
+        FlushCoalesced();
+        type = arg_type;
+    }
 
     packet_analysis::TCP::TCPSessionAdapter* GetTCPAnalyzer() { return tcp_analyzer; }
 
@@ -78,6 +87,17 @@ public:
     void DeliverBlock(uint64_t seq, int len, const u_char* data);
     void Deliver(uint64_t seq, int len, const u_char* data);
 
+    // Passes on any data collected for a combined delivery, see
+    // tcp_coalesce_max_size.
+    void FlushCoalesced();
+
+    // Returns the network time at which data collected for a combined
+    // delivery is due per tcp_coalesce_window, or 0 if there's none.
+    double CoalescedDue() const;
+
+    // Discards all buffered data and skips any further deliveries.
+    void StopDeliveries();
+
     TCP_Endpoint* Endpoint() { return endp; }
     const TCP_Endpoint* Endpoint() const { return endp; }
 
@@ -96,6 +116,9 @@ private:
     void BlockInserted(DataBlockMap::const_iterator it) override;
     void Overlap(const u_char* b1, const u_char* b2, uint64_t n) override;
 
+    void Coalesce(uint64_t seq, int len, const u_char* data);
+    void FlushPeer();
+
     TCP_Endpoint* endp;
 
     bool deliver_tcp_contents;
@@ -110,6 +133,11 @@ private:
 
     FilePtr record_contents_file; // file on which to reassemble contents
 
+    // In-order data not yet delivered, starting at coalesced_seq.
+    std::string coalesced;
+    uint64_t coalesced_seq;
+    double coalesced_time; // when the data started collecting
+
     analyzer::Analyzer* dst_analyzer;
     packet_analysis::TCP::TCPSessionAdapter* tcp_analyzer;
 
@@ -0,0 +1,321 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/broker/LogBatch.h"
+
+#include <zlib.h>
+#include <cstdlib>
+
+#include "zeek/3rdparty/doctest.h"
+
+namespace zeek::Broker::detail {
+
+namespace {
+
+// Initial buffer size per column, which is much smaller than the
+// serialization default since we have many of these.
+constexpr uint32_t COLUMN_INITIAL_SIZE = 4096;
+
+// Upper bound for the size of a decompressed batch, to guard against
+// bogus input.
+constexpr uint32_t MAX_BATCH_SIZE = 256 * 1024 * 1024;
+
+// Upper bound for the number of rows in a batch. Senders flush well
+// before this, per Broker::log_batch_size.
+constexpr uint32_t MAX_BATCH_ROWS = 1024 * 1024;
+
+bool valid_column_type(int type) {
+    switch ( type ) {
+        case TYPE_BOOL:
+        case TYPE_INT:
+        case TYPE_COUNT:
+        case TYPE_PORT:
+        case TYPE_ADDR:
+        case TYPE_SUBNET:
+        case TYPE_DOUBLE:
+        case TYPE_TIME:
+        case TYPE_INTERVAL:
+        case TYPE_ENUM:
+        case TYPE_STRING:
+        case TYPE_FILE:
+        case TYPE_FUNC:
+        case TYPE_TABLE:
+        case TYPE_VECTOR: return true;
+
+        default: return false;
+    }
+}
+
+std::string take_output(zeek::detail::SerializationFormat* fmt) {
+    char* data;
+    auto len = fmt->EndWrite(&data);
+    std::string rval(data, len);
+    free(data);
+    return rval;
+}
+
+} // namespace
+
+LogBatchBuilder::LogBatchBuilder(int num_fields) {
+    columns.reserve(num_fields);
+
+    for ( int i = 0; i < num_fields; ++i )
+        columns.emplace_back(std::make_unique<Column>());
+
+    StartColumns();
+}
+
+void LogBatchBuilder::StartColumns() {
+    for ( auto& c : columns )
+        c->fmt.StartWrite(COLUMN_INITIAL_SIZE);
+
+    num_rows = 0;
+}
+
+bool LogBatchBuilder::Add(const threading::Value* const* vals) {
+    if ( num_rows == 0 ) {
+        for ( size_t i = 0; i < columns.size(); ++i ) {
+            columns[i]->type = vals[i]->type;
+            columns[i]->subtype = vals[i]->subtype;
+        }
+    }
+    else {
+        for ( size_t i = 0; i < columns.size(); ++i ) {
+            if ( vals[i]->type != columns[i]->type || vals[i]->subtype != columns[i]->subtype )
+                return false;
+        }
+    }
+
+    for ( size_t i = 0; i < columns.size(); ++i ) {
+        auto& fmt = columns[i]->fmt;
+        fmt.Write(vals[i]->present, "present");
+
+        if ( vals[i]->present )
+            vals[i]->WriteData(&fmt);
+    }
+
+    ++num_rows;
+    return true;
+}
+
+std::string LogBatchBuilder::Build(bool compress) {
+    zeek::detail::BinarySerializationFormat body;
+    body.StartWrite();
+    body.Write(static_cast<int>(num_rows), "num_rows");
+    body.Write(static_cast<int>(columns.size()), "num_fields");
+
+    for ( auto& c : columns ) {
+        auto column = take_output(&c->fmt);
+        body.Write(static_cast<int>(c->type), "type");
+        body.Write(static_cast<int>(c->subtype), "subtype");
+        body.Write(column.data(), column.size(), "column");
+    }
+
+    StartColumns();
+
+    auto raw = take_output(&body);
+
+    zeek::detail::BinarySerializationFormat fmt;
+    fmt.StartWrite();
+    fmt.Write(LOG_BATCH_MARKER, "num_fields");
+
+    if ( compress ) {
+        uLongf len = compressBound(raw.size());
+        std::string compressed(len, '\0');
+
+        if ( compress2(reinterpret_cast<Bytef*>(compressed.data()), &len,
+                       reinterpret_cast<const Bytef*>(raw.data()), raw.size(), Z_BEST_SPEED) == Z_OK ) {
+            fmt.Write(true, "compressed");
+            fmt.Write(static_cast<uint32_t>(raw.size()), "raw_len");
+            fmt.Write(compressed.data(), len, "rows");
+            return take_output(&fmt);
+        }
+
+        // Fall back to sending it as is.
+    }
+
+    fmt.Write(false, "compressed");
+    fmt.Write(raw.data(), raw.size(), "rows");
+    return take_output(&fmt);
+}
+
+bool decode_log_batch(zeek::detail::SerializationFormat* fmt, int* num_fields, std::vector<threading::Value**>* rows) {
+    bool compressed;
+    uint32_t raw_len = 0;
+
+    if ( ! fmt->Read(&compressed, "compressed") )
+        return false;
+
+    if ( compressed && (! fmt->Read(&raw_len, "raw_len") || raw_len > MAX_BATCH_SIZE) )
+        return false;
+
+    std::string data;
+
+    if ( ! fmt->Read(&data, "rows") )
+        return false;
+
+    if ( compressed ) {
+        std::string raw(raw_len, '\0');
+        uLongf len = raw_len;
+
+        if ( uncompress(reinterpret_cast<Bytef*>(raw.data()), &len, reinterpret_cast<const Bytef*>(data.data()),
+                        data.size()) != Z_OK ||
+             len != raw_len )
+            return false;
+
+        data = std::move(raw);
+    }
+
+    zeek::detail::BinarySerializationFormat body;
+    body.StartRead(data.data(), data.size());
+
+    int num_rows;
+
+    if ( ! (body.Read(&num_rows, "num_rows") && body.Read(num_fields, "num_fields")) )
+        return false;
+
+    if ( num_rows < 0 || *num_fields < 0 || (num_rows > 0 && *num_fields == 0) )
+        return false;
+
+    // Each value takes at least a byte to encode, so a well-formed batch
+    // can't claim more of them than there's data. Checking this up front
+    // keeps a short message from making us allocate a lot of rows.
+    if ( static_cast<uint64_t>(num_rows) * static_cast<uint64_t>(*num_fields) > data.size() ||
+         static_cast<uint64_t>(num_rows) > MAX_BATCH_ROWS )
+        return false;
+
+    // Rows get allocated as the first column gets decoded.
+    std::vector<threading::Value**> decoded;
+
+    auto cleanup = [&]() {
+        for ( auto vals : decoded )
+            threading::Value::delete_value_ptr_array(vals, *num_fields);
+    };
+
+    for ( int i = 0; i < *num_fields; ++i ) {
+        int type, subtype;
+        std::string column;
+
+        if ( ! (body.Read(&type, "type") && body.Read(&subtype, "subtype") && body.Read(&column, "column")) ||
+             ! valid_column_type(type) ) {
+            cleanup();
+            return false;
+        }
+
+        zeek::detail::BinarySerializationFormat col_fmt;
+        col_fmt.StartRead(column.data(), column.size());
+
+        for ( int r = 0; r < num_rows; ++r ) {
+            if ( i == 0 )
+                decoded.push_back(new threading::Value* [*num_fields] {});
+
+            auto vals = decoded[r];
+            bool present;
+
+            if ( ! col_fmt.Read(&present, "present") ) {
+                cleanup();
+                return false;
+            }
+
+            auto v = new threading::Value(static_cast<TypeTag>(type), static_cast<TypeTag>(subtype), present);
+            vals[i] = v;
+
+            if ( present && ! v->ReadData(&col_fmt) ) {
+                cleanup();
+                return false;
+            }
+        }
+
+        col_fmt.EndRead();
+    }
+
+    body.EndRead();
+
+    rows->insert(rows->end(), decoded.begin(), decoded.end());
+    return true;
+}
+
+TEST_SUITE_BEGIN("LogBatch");
+
+TEST_CASE("log batch round trip") {
+    for ( bool compress : {false, true} ) {
+        LogBatchBuilder builder(3);
+
+        for ( int r = 0; r < 10; ++r ) {
+            threading::Value v0(TYPE_COUNT);
+            v0.val.uint_val = r;
+
+            threading::Value v1(TYPE_STRING, r % 2 == 0);
+            std::string s = "row";
+            v1.val.string_val.data = s.data();
+            v1.val.string_val.length = s.size();
+
+            threading::Value v2(TYPE_DOUBLE);
+            v2.val.double_val = r * 0.5;
+
+            const threading::Value* vals[] = {&v0, &v1, &v2};
+            CHECK(builder.Add(vals));
+
+            // Value's destructor would free the string.
+            v1.present = false;
+        }
+
+        threading::Value bad0(TYPE_INT);
+        threading::Value bad1(TYPE_STRING, false);
+        threading::Value bad2(TYPE_DOUBLE);
+        const threading::Value* bad_vals[] = {&bad0, &bad1, &bad2};
+        CHECK_FALSE(builder.Add(bad_vals));
+        CHECK(builder.NumRows() == 10);
+
+        auto batch = builder.Build(compress);
+        CHECK(builder.NumRows() == 0);
+
+        zeek::detail::BinarySerializationFormat fmt;
+        fmt.StartRead(batch.data(), batch.size());
+
+        int marker;
+        REQUIRE(fmt.Read(&marker, "num_fields"));
+        CHECK(marker == LOG_BATCH_MARKER);
+
+        int num_fields;
+        std::vector<threading::Value**> rows;
+        REQUIRE(decode_log_batch(&fmt, &num_fields, &rows));
+        CHECK(num_fields == 3);
+        REQUIRE(rows.size() == 10);
+
+        for ( int r = 0; r < 10; ++r ) {
+            auto vals = rows[r];
+            CHECK(vals[0]->val.uint_val == static_cast<zeek_uint_t>(r));
+            CHECK(vals[1]->present == (r % 2 == 0));
+
+            if ( vals[1]->present )
+                CHECK(std::string(vals[1]->val.string_val.data, vals[1]->val.string_val.length) == "row");
+
+            CHECK(vals[2]->val.double_val == r * 0.5);
+            threading::Value::delete_value_ptr_array(vals, num_fields);
+        }
+    }
+}
+
+TEST_CASE("log batch rejects bogus sizes") {
+    zeek::detail::BinarySerializationFormat body;
+    body.StartWrite();
+    body.Write(1000000, "num_rows");
+    body.Write(1000000, "num_fields");
+    auto data = take_output(&body);
+
+    zeek::detail::BinarySerializationFormat fmt;
+    fmt.StartWrite();
+    fmt.Write(false, "compressed");
+    fmt.Write(data, "rows");
+    auto msg = take_output(&fmt);
+
+    fmt.StartRead(msg.data(), msg.size());
+    int num_fields;
+    std::vector<threading::Value**> rows;
+    CHECK_FALSE(decode_log_batch(&fmt, &num_fields, &rows));
+    CHECK(rows.empty());
+}
+
+TEST_SUITE_END();
+
+} // namespace zeek::Broker::detail
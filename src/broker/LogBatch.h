@@ -0,0 +1,75 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+// Columnar encoding of log writes sent between cluster nodes.  Rather than
+// serializing each row separately, with every value carrying its own type
+// information, a batch collects the rows of one stream/writer/path and
+// lays them out column by column: each column's type is stated once,
+// followed by the column's values.  Batches can optionally be compressed.
+//
+// An encoded batch travels as the serial data of a regular LogWrite
+// message, distinguished from a single row by a field count of
+// LOG_BATCH_MARKER.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "zeek/SerializationFormat.h"
+#include "zeek/threading/SerialTypes.h"
+
+namespace zeek::Broker::detail {
+
+// Stands in for the number of fields at the start of the serial data.
+constexpr int LOG_BATCH_MARKER = -1;
+
+class LogBatchBuilder {
+public:
+    LogBatchBuilder(int num_fields);
+
+    int NumFields() const { return static_cast<int>(columns.size()); }
+    size_t NumRows() const { return num_rows; }
+
+    /**
+     * Appends a row to the batch.
+     *
+     * @return False if the row doesn't match the types of earlier rows,
+     * in which case the batch remains unchanged.
+     */
+    bool Add(const threading::Value* const* vals);
+
+    /**
+     * Returns the encoded batch, including the leading marker, and
+     * resets the builder for the next batch.
+     *
+     * @param compress Whether to compress the rows.
+     */
+    std::string Build(bool compress);
+
+private:
+    struct Column {
+        TypeTag type = TYPE_VOID;
+        TypeTag subtype = TYPE_VOID;
+        zeek::detail::BinarySerializationFormat fmt;
+    };
+
+    void StartColumns();
+
+    std::vector<std::unique_ptr<Column>> columns;
+    size_t num_rows = 0;
+};
+
+/**
+ * Decodes a batch produced by LogBatchBuilder, after the leading marker
+ * has been read from *fmt*.
+ *
+ * @param rows Receives the decoded rows, each an array of *num_fields*
+ * values that the caller takes ownership of.
+ *
+ * @return False if the batch is malformed.
+ */
+extern bool decode_log_batch(zeek::detail::SerializationFormat* fmt, int* num_fields,
+                             std::vector<threading::Value**>* rows);
+
+} // namespace zeek::Broker::detail
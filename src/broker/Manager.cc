@@ -14,6 +14,7 @@
 #include "zeek/Reporter.h"
 #include "zeek/RunState.h"
 #include "zeek/SerializationFormat.h"
+#include "zeek/Timer.h"
 #include "zeek/Var.h"
 #include "zeek/broker/Data.h"
 #include "zeek/broker/Store.h"
@@ -85,6 +86,15 @@ static inline Val* get_option(const char* option) {
     return id->GetVal().get();
 }
 
+// Sends out the pending event batches once Broker::event_batch_interval
+// has passed since the first of them was started.
+class EventBatchTimer final : public zeek::detail::Timer {
+public:
+    EventBatchTimer(double t) : zeek::detail::Timer(t, zeek::detail::TIMER_BROKER_EVENT_BATCH) {}
+
+    void Dispatch(double t, bool is_expire) override { broker_mgr->FlushEventBatches(); }
+};
+
 template<class T>
 static inline void set_option(const char* option, const T& value) {
     const auto& id = zeek::detail::global_scope()->Find(option);
@@ -211,6 +221,55 @@ void Manager::InitPostScript() {
     DBG_LOG(DBG_BROKER, "Initializing");
 
     log_batch_size = get_option("Broker::log_batch_size")->AsCount();
+    log_batch_columnar = get_option("Broker::log_batch_columnar")->AsBool();
+    log_batch_compression = get_option("Broker::log_batch_compression")->AsBool();
+
+    auto batches_family = telemetry_mgr->CounterFamily("zeek", "broker-log-batches", {"direction"},
+                                                       "Number of columnar log batches", "1", true);
+    auto rows_family = telemetry_mgr->CounterFamily("zeek", "broker-log-batch-rows", {"direction"},
+                                                    "Number of log rows in columnar batches", "1", true);
+    auto bytes_family = telemetry_mgr->CounterFamily("zeek", "broker-log-batch", {"direction"},
+                                                     "Encoded size of columnar log batches", "bytes", true);
+
+    auto make_log_batch_metrics = [&](const char* dir) {
+        return LogBatchMetrics{batches_family.GetOrAdd({{"direction", dir}}), rows_family.GetOrAdd({{"direction", dir}}),
+                               bytes_family.GetOrAdd({{"direction", dir}})};
+    };
+
+    log_batches_out = make_log_batch_metrics("out");
+    log_batches_in = make_log_batch_metrics("in");
+
+    event_batch_size = get_option("Broker::event_batch_size")->AsCount();
+    event_batch_interval = get_option("Broker::event_batch_interval")->AsInterval();
+
+    auto event_batch_topics = get_option("Broker::event_batch_topics")->AsTableVal()->ToPureListVal();
+
+    if ( event_batch_topics->Length() > 0 ) {
+        static const int64_t size_bounds[] = {1, 10, 100, 1000, 10000};
+        static const double latency_bounds[] = {0.001, 0.01, 0.1, 1.0, 10.0};
+
+        auto size_family = telemetry_mgr->HistogramFamily("zeek", "broker-event-batch-size", {"topic"}, size_bounds,
+                                                          "Number of events per published batch");
+        auto latency_family = telemetry_mgr->HistogramFamily<double>(
+            "zeek", "broker-event-batch-latency", {"topic"}, latency_bounds,
+            "Time from the first event of a batch being published until the batch is sent", "seconds");
+
+        for ( int i = 0; i < event_batch_topics->Length(); ++i ) {
+            std::string prefix = event_batch_topics->Idx(i)->AsString()->CheckString();
+            event_batch_metrics.emplace(prefix, EventBatchMetrics{size_family.GetOrAdd({{"topic", prefix}}),
+                                                                  latency_family.GetOrAdd({{"topic", prefix}})});
+        }
+    }
+
+    store_cache_size = get_option("Broker::store_cache_size")->AsCount();
+    store_cache_ttl = get_option("Broker::store_cache_ttl")->AsInterval();
+
+    if ( store_cache_size )
+        store_cache_family = telemetry_mgr->CounterFamily("zeek", "broker-store-cache-lookups", {"store", "result"},
+                                                          "Number of data store lookups served from the cache (hit) "
+                                                          "or sent to the store (miss)",
+                                                          "1", true);
+
     default_log_topic_prefix = get_option("Broker::default_log_topic_prefix")->AsString()->CheckString();
     log_topic_func = get_option("Broker::log_topic")->AsFunc();
     log_id_type = id::find_type("Log::ID")->AsEnumType();
@@ -403,6 +462,7 @@ void Manager::InitializeBrokerStoreForwarding() {
 }
 
 void Manager::Terminate() {
+    FlushEventBatches();
     FlushLogBuffers();
 
     iosource_mgr->UnregisterFd(bstate->subscriber.fd(), this);
@@ -530,6 +590,7 @@ void Manager::Unpeer(const string& addr, uint16_t port) {
 
     DBG_LOG(DBG_BROKER, "Stopping to peer with %s:%" PRIu16, addr.c_str(), port);
 
+    FlushEventBatches();
     FlushLogBuffers();
     bstate->endpoint.unpeer_nosync(addr, port);
 }
@@ -552,11 +613,76 @@ bool Manager::PublishEvent(string topic, std::string name, broker::vector args,
 
     DBG_LOG(DBG_BROKER, "Publishing event: %s", RenderEvent(topic, name, args).c_str());
     broker::zeek::Event ev(std::move(name), std::move(args), broker::to_timestamp(ts));
-    bstate->endpoint.publish(std::move(topic), ev.move_data());
     ++statistics.num_events_outgoing;
+
+    if ( ! event_batch_metrics.empty() ) {
+        if ( auto prefix = EventBatchPrefix(topic) ) {
+            auto& batch = event_batches[topic];
+
+            if ( ! batch.size ) {
+                batch.first_added = util::current_time();
+                batch.metrics = &event_batch_metrics.at(*prefix);
+            }
+
+            batch.msgs.add(std::move(ev));
+
+            if ( ++batch.size >= event_batch_size )
+                FlushEventBatch(topic, batch);
+
+            else if ( ! event_batch_timer_pending ) {
+                zeek::detail::timer_mgr->Add(new EventBatchTimer(run_state::network_time + event_batch_interval));
+                event_batch_timer_pending = true;
+            }
+
+            return true;
+        }
+    }
+
+    bstate->endpoint.publish(std::move(topic), ev.move_data());
     return true;
 }
 
+const std::string* Manager::EventBatchPrefix(const std::string& topic) const {
+    for ( const auto& [prefix, metrics] : event_batch_metrics ) {
+        if ( util::starts_with(topic, prefix) )
+            return &prefix;
+    }
+
+    return nullptr;
+}
+
+void Manager::FlushEventBatch(const std::string& topic, PendingEventBatch& batch) {
+    if ( ! batch.size )
+        return;
+
+    DBG_LOG(DBG_BROKER, "Publishing batch of %zu events to %s", batch.size, topic.c_str());
+
+    batch.metrics->size.Observe(batch.size);
+    batch.metrics->latency.Observe(util::current_time() - batch.first_added);
+
+    if ( ! bstate->endpoint.is_shutdown() )
+        bstate->endpoint.publish(topic, batch.msgs.build());
+
+    batch.size = 0;
+}
+
+size_t Manager::FlushEventBatches() {
+    // A timer that's still pending will find less or nothing to do, which
+    // is harmless.
+    event_batch_timer_pending = false;
+
+    size_t rval = 0;
+
+    for ( auto& [topic, batch] : event_batches ) {
+        rval += batch.size;
+        FlushEventBatch(topic, batch);
+    }
+
+    // Topics may come and go, so don't hold on to them.
+    event_batches.clear();
+    return rval;
+}
+
 bool Manager::PublishEvent(string topic, RecordVal* args) {
     if ( bstate->endpoint.is_shutdown() )
         return true;
@@ -691,6 +817,59 @@ bool Manager::PublishLogWrite(EnumVal* stream, EnumVal* writer, string path, int
         return false;
     }
 
+    auto v = log_topic_func->Invoke(IntrusivePtr{NewRef{}, stream}, make_intrusive<StringVal>(path));
+
+    if ( ! v ) {
+        reporter->Error(
+            "Failed to remotely log: log_topic func did not return"
+            " a value for stream %s at path %s",
+            stream_id, path.data());
+        return false;
+    }
+
+    std::string topic = v->AsString()->CheckString();
+
+    if ( log_buffers.size() <= (unsigned int)stream_id_num )
+        log_buffers.resize(stream_id_num + 1);
+
+    auto& lb = log_buffers[stream_id_num];
+
+    if ( log_batch_columnar ) {
+        std::tuple key{topic, writer_id, path};
+
+        // A batch only covers consecutive writes to the same path. Holding
+        // back rows for one path while sending those of another would change
+        // the order in which they arrive at the logger.
+        if ( ! lb.batches.empty() && lb.batches.find(key) == lb.batches.end() )
+            BuildLogBatches(lb);
+
+        auto& batch = lb.batches[std::move(key)];
+
+        if ( batch.builder && (batch.builder->NumFields() != num_fields || ! batch.builder->Add(vals)) ) {
+            // The writer's fields changed, start over with a new batch.
+            BuildLogBatch(lb, topic, path, batch);
+            batch.builder.reset();
+        }
+
+        if ( ! batch.builder ) {
+            batch.stream_id = stream_id;
+            batch.writer_id = writer_id;
+            batch.builder = std::make_unique<detail::LogBatchBuilder>(num_fields);
+            batch.builder->Add(vals);
+        }
+
+        DBG_LOG(DBG_BROKER, "Batching log record for %s at path %s", stream_id, path.c_str());
+
+        ++lb.message_count;
+
+        if ( lb.message_count >= log_batch_size ) {
+            BuildLogBatches(lb);
+            statistics.num_logs_outgoing += lb.Flush(bstate->endpoint, log_batch_size);
+        }
+
+        return true;
+    }
+
     zeek::detail::BinarySerializationFormat fmt;
     char* data;
     int len;
@@ -715,28 +894,12 @@ bool Manager::PublishLogWrite(EnumVal* stream, EnumVal* writer, string path, int
     std::string serial_data(data, len);
     free(data);
 
-    auto v = log_topic_func->Invoke(IntrusivePtr{NewRef{}, stream}, make_intrusive<StringVal>(path));
-
-    if ( ! v ) {
-        reporter->Error(
-            "Failed to remotely log: log_topic func did not return"
-            " a value for stream %s at path %s",
-            stream_id, path.data());
-        return false;
-    }
-
-    std::string topic = v->AsString()->CheckString();
-
     auto bstream_id = broker::enum_value(std::move(stream_id));
     auto bwriter_id = broker::enum_value(std::move(writer_id));
     broker::zeek::LogWrite msg(std::move(bstream_id), std::move(bwriter_id), std::move(path), std::move(serial_data));
 
     DBG_LOG(DBG_BROKER, "Buffering log record: %s", RenderMessage(topic, msg.as_data()).c_str());
 
-    if ( log_buffers.size() <= (unsigned int)stream_id_num )
-        log_buffers.resize(stream_id_num + 1);
-
-    auto& lb = log_buffers[stream_id_num];
     ++lb.message_count;
     lb.msgs[topic].add(std::move(msg));
 
@@ -746,6 +909,34 @@ bool Manager::PublishLogWrite(EnumVal* stream, EnumVal* writer, string path, int
     return true;
 }
 
+void Manager::BuildLogBatch(LogBuffer& lb, const std::string& topic, const std::string& path, PendingLogBatch& batch) {
+    auto num_rows = batch.builder->NumRows();
+
+    if ( ! num_rows )
+        return;
+
+    auto serial_data = batch.builder->Build(log_batch_compression);
+    log_batches_out->Record(num_rows, serial_data.size());
+
+    broker::zeek::LogWrite msg(broker::enum_value(batch.stream_id), broker::enum_value(batch.writer_id), path,
+                               std::move(serial_data));
+
+    DBG_LOG(DBG_BROKER, "Buffering batch of %zu log records for %s at path %s", num_rows, batch.stream_id.c_str(),
+            path.c_str());
+
+    lb.msgs[topic].add(std::move(msg));
+}
+
+void Manager::BuildLogBatches(LogBuffer& lb) {
+    for ( auto& [key, batch] : lb.batches ) {
+        if ( batch.builder )
+            BuildLogBatch(lb, std::get<0>(key), std::get<2>(key), batch);
+    }
+
+    // Paths may come and go, so don't hold on to their builders.
+    lb.batches.clear();
+}
+
 size_t Manager::LogBuffer::Flush(broker::endpoint& endpoint, size_t log_batch_size) {
     if ( endpoint.is_shutdown() )
         return 0;
@@ -768,8 +959,10 @@ size_t Manager::FlushLogBuffers() {
     DBG_LOG(DBG_BROKER, "Flushing all log buffers");
     auto rval = 0u;
 
-    for ( auto& lb : log_buffers )
+    for ( auto& lb : log_buffers ) {
+        BuildLogBatches(lb);
         rval += lb.Flush(bstate->endpoint, log_batch_size);
+    }
 
     statistics.num_logs_outgoing += rval;
     return rval;
@@ -1066,6 +1259,9 @@ void Manager::ProcessStoreEvent(broker::data msg) {
         if ( ! storehandle )
             return;
 
+        if ( storehandle->cache )
+            storehandle->cache->Insert(insert.key(), insert.value(), insert.expiry());
+
         const auto& table = storehandle->forward_to;
         if ( ! table )
             return;
@@ -1081,6 +1277,9 @@ void Manager::ProcessStoreEvent(broker::data msg) {
         if ( ! storehandle )
             return;
 
+        if ( storehandle->cache )
+            storehandle->cache->Insert(update.key(), update.new_value(), update.expiry());
+
         const auto& table = storehandle->forward_to;
         if ( ! table )
             return;
@@ -1097,6 +1296,9 @@ void Manager::ProcessStoreEvent(broker::data msg) {
         if ( ! storehandle )
             return;
 
+        if ( storehandle->cache )
+            storehandle->cache->Erase(erase.key());
+
         auto table = storehandle->forward_to;
         if ( ! table )
             return;
@@ -1127,8 +1329,11 @@ void Manager::ProcessStoreEvent(broker::data msg) {
         table->Remove(*zeek_key, false);
     }
     else if ( auto expire = broker::store_event::expire::make(msg) ) {
-        // We just ignore expiries - expiring information on the Zeek side is handled by Zeek
-        // itself.
+        // Apart from dropping the key from our cache, we ignore expiries -
+        // expiring information on the Zeek side is handled by Zeek itself.
+        if ( auto storehandle = broker_mgr->LookupStore(expire.store_id()); storehandle && storehandle->cache )
+            storehandle->cache->Erase(expire.key());
+
 #ifdef DEBUG
         // let's only debug log for stores that we know.
         auto storehandle = broker_mgr->LookupStore(expire.store_id());
@@ -1316,7 +1521,6 @@ bool Manager::ProcessMessage(std::string_view, broker::zeek::LogWrite& lw) {
         return false;
     }
 
-    ++statistics.num_logs_incoming;
     auto& stream_id_name = lw.stream_id().name;
 
     // Get stream ID.
@@ -1351,6 +1555,26 @@ bool Manager::ProcessMessage(std::string_view, broker::zeek::LogWrite& lw) {
         return false;
     }
 
+    if ( num_fields == detail::LOG_BATCH_MARKER ) {
+        std::vector<threading::Value**> rows;
+
+        if ( ! detail::decode_log_batch(&fmt, &num_fields, &rows) ) {
+            reporter->Warning("failed to unserialize remote log batch for stream: %s", stream_id_name.data());
+            return false;
+        }
+
+        log_batches_in->Record(rows.size(), serial_data.size());
+        statistics.num_logs_incoming += rows.size();
+
+        for ( auto vals : rows )
+            log_mgr->WriteFromRemote(stream_id->AsEnumVal(), writer_id->AsEnumVal(), path, num_fields, vals);
+
+        fmt.EndRead();
+        return true;
+    }
+
+    ++statistics.num_logs_incoming;
+
     auto vals = new threading::Value*[num_fields];
 
     for ( int i = 0; i < num_fields; ++i ) {
@@ -1524,6 +1748,9 @@ void Manager::ProcessStoreResponse(detail::StoreHandleVal* s, broker::store::res
     }
 
     if ( response.answer ) {
+        if ( s->cache && request->second->CacheKey() )
+            s->cache->Fill(*request->second->CacheKey(), *response.answer, request->second->CacheVersion());
+
         BrokerData tmp{std::move(*response.answer)};
         request->second->Result(detail::query_result(std::move(tmp).ToRecordVal()));
     }
@@ -1579,6 +1806,7 @@ detail::StoreHandleVal* Manager::MakeMaster(const string& name, broker::backend
 
     auto handle = new detail::StoreHandleVal{*result};
     Ref(handle);
+    InitStoreCache(name, handle);
 
     data_stores.emplace(name, handle);
     if ( ! iosource_mgr->RegisterFd(handle->proxy.mailbox().descriptor(), this) )
@@ -1596,6 +1824,15 @@ detail::StoreHandleVal* Manager::MakeMaster(const string& name, broker::backend
     return handle;
 }
 
+void Manager::InitStoreCache(const std::string& name, detail::StoreHandleVal* handle) {
+    if ( ! store_cache_size )
+        return;
+
+    auto hits = store_cache_family->GetOrAdd({{"store", name}, {"result", "hit"}});
+    auto misses = store_cache_family->GetOrAdd({{"store", name}, {"result", "miss"}});
+    handle->cache = std::make_unique<detail::StoreCache>(store_cache_size, store_cache_ttl, hits, misses);
+}
+
 void Manager::BrokerStoreToZeekTable(const std::string& name, const detail::StoreHandleVal* handle) {
     if ( ! handle->forward_to )
         return;
@@ -1678,6 +1915,7 @@ detail::StoreHandleVal* Manager::MakeClone(const string& name, double resync_int
 
     auto handle = new detail::StoreHandleVal{*result};
     Ref(handle);
+    InitStoreCache(name, handle);
 
     data_stores.emplace(name, handle);
     if ( ! iosource_mgr->RegisterFd(handle->proxy.mailbox().descriptor(), this) )
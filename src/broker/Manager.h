@@ -9,14 +9,20 @@
 #include <broker/error.hh>
 #include <broker/peer_info.hh>
 #include <broker/zeek.hh>
+#include <map>
 #include <memory>
+#include <optional>
 #include <string>
+#include <tuple>
 #include <unordered_map>
 
 #include "zeek/IntrusivePtr.h"
 #include "zeek/broker/Data.h"
+#include "zeek/broker/LogBatch.h"
 #include "zeek/iosource/IOSource.h"
 #include "zeek/logging/WriterBackend.h"
+#include "zeek/telemetry/Counter.h"
+#include "zeek/telemetry/Histogram.h"
 
 namespace zeek {
 
@@ -357,6 +363,12 @@ public:
      */
     size_t FlushLogBuffers();
 
+    /**
+     * Send all pending event batches, see Broker::event_batch_topics.
+     * @return the number of events sent.
+     */
+    size_t FlushEventBatches();
+
     /**
      * Flushes all pending data store queries and also clears all contents.
      */
@@ -436,6 +448,8 @@ private:
     // Send the content of a Broker store to the backing table. This is typically used
     // when a master/clone is created.
     void BrokerStoreToZeekTable(const std::string& name, const detail::StoreHandleVal* handle);
+    // Sets up the lookup cache of a new master/clone, if enabled.
+    void InitStoreCache(const std::string& name, detail::StoreHandleVal* handle);
 
     void Error(const char* format, ...) __attribute__((format(printf, 2, 3)));
 
@@ -444,14 +458,62 @@ private:
     const char* Tag() override { return "Broker::Manager"; }
     double GetNextTimeout() override { return -1; }
 
+    // Rows of a stream going to the same topic, writer, and path that
+    // are accumulated into a columnar batch.
+    struct PendingLogBatch {
+        std::string stream_id;
+        std::string writer_id;
+        std::unique_ptr<detail::LogBatchBuilder> builder;
+    };
+
     struct LogBuffer {
         // Indexed by topic string.
         std::unordered_map<std::string, broker::zeek::BatchBuilder> msgs;
+        // Indexed by topic, writer, and path. Holds at most one pending
+        // batch, so that rows go out in the order they were written.
+        std::map<std::tuple<std::string, std::string, std::string>, PendingLogBatch> batches;
         size_t message_count;
 
         size_t Flush(broker::endpoint& endpoint, size_t batch_size);
     };
 
+    // Moves the pending columnar batches of a buffer into its messages.
+    void BuildLogBatches(LogBuffer& lb);
+    void BuildLogBatch(LogBuffer& lb, const std::string& topic, const std::string& path, PendingLogBatch& batch);
+
+    // Counters for columnar log batches, for either direction.
+    struct LogBatchMetrics {
+        telemetry::IntCounter batches;
+        telemetry::IntCounter rows;
+        telemetry::IntCounter bytes;
+
+        void Record(size_t num_rows, size_t num_bytes) {
+            batches.Inc();
+            rows.Inc(num_rows);
+            bytes.Inc(num_bytes);
+        }
+    };
+
+    // Telemetry for the event batches of one of the configured topic
+    // prefixes.
+    struct EventBatchMetrics {
+        telemetry::IntHistogram size;
+        telemetry::DblHistogram latency;
+    };
+
+    // Events published to a topic that are waiting to go out together.
+    struct PendingEventBatch {
+        broker::zeek::BatchBuilder msgs;
+        size_t size = 0;
+        double first_added = 0.0; // Wall-clock time of the oldest event.
+        EventBatchMetrics* metrics = nullptr;
+    };
+
+    // Returns the configured prefix that a topic's events get batched
+    // under, or null if they're sent right away.
+    const std::string* EventBatchPrefix(const std::string& topic) const;
+    void FlushEventBatch(const std::string& topic, PendingEventBatch& batch);
+
     // Data stores
     using query_id = std::pair<broker::request_id, detail::StoreHandleVal*>;
 
@@ -479,12 +541,26 @@ private:
     int peer_count;
 
     size_t log_batch_size;
+    bool log_batch_columnar = false;
+    bool log_batch_compression = false;
+    std::optional<LogBatchMetrics> log_batches_out;
+    std::optional<LogBatchMetrics> log_batches_in;
+
+    // Batching of events, indexed by topic.
+    std::map<std::string, PendingEventBatch> event_batches;
+    std::map<std::string, EventBatchMetrics> event_batch_metrics; // Indexed by prefix.
+    size_t event_batch_size = 0;
+    double event_batch_interval = 0.0;
+    bool event_batch_timer_pending = false;
     Func* log_topic_func;
     VectorTypePtr vector_of_data_type;
     EnumType* log_id_type;
     EnumType* writer_id_type;
     bool zeek_table_manager = false;
     std::string zeek_table_db_directory;
+    size_t store_cache_size = 0;
+    double store_cache_ttl = 0.0;
+    std::optional<telemetry::IntCounterFamily> store_cache_family;
 
     static int script_scope;
 };
@@ -1,8 +1,11 @@
 #include "zeek/broker/Store.h"
 
+#include <algorithm>
+
 #include "zeek/Desc.h"
 #include "zeek/ID.h"
 #include "zeek/broker/Manager.h"
+#include "zeek/util.h"
 
 zeek::OpaqueTypePtr zeek::Broker::detail::opaque_of_store_handle;
 
@@ -23,11 +26,123 @@ EnumValPtr query_status(bool success) {
     return rval;
 }
 
+const broker::data* StoreCache::Lookup(const broker::data& key) {
+    auto i = entries.find(key);
+
+    if ( i == entries.end() ) {
+        misses.Inc();
+        return nullptr;
+    }
+
+    if ( i->second.expire_time && i->second.expire_time < util::current_time() ) {
+        lru.erase(i->second.lru_pos);
+        entries.erase(i);
+        misses.Inc();
+        return nullptr;
+    }
+
+    lru.splice(lru.begin(), lru, i->second.lru_pos);
+    hits.Inc();
+    return &i->second.value;
+}
+
+void StoreCache::Insert(const broker::data& key, const broker::data& value, std::optional<broker::timespan> expiry) {
+    Changed(key);
+
+    // Only refresh keys that we're caching already. Caching every write
+    // would let write traffic push out the keys that get looked up.
+    auto i = entries.find(key);
+
+    if ( i == entries.end() )
+        return;
+
+    auto now = util::current_time();
+    double expire_time = ttl > 0 ? now + ttl : 0;
+
+    if ( expiry ) {
+        auto e = now + std::chrono::duration<double>(*expiry).count();
+
+        if ( ! expire_time || e < expire_time )
+            expire_time = e;
+    }
+
+    i->second.value = value;
+    i->second.expire_time = expire_time;
+}
+
+void StoreCache::Fill(const broker::data& key, const broker::data& value, uint64_t version) {
+    if ( version < min_fill_version )
+        return;
+
+    if ( auto i = changes.find(key); i != changes.end() && i->second > version )
+        // The key changed while the query was in flight.
+        return;
+
+    // We don't learn about the key's expiry from a query, so rely on
+    // the store's expire event to drop it in time.
+    Set(key, value, ttl > 0 ? util::current_time() + ttl : 0);
+}
+
+void StoreCache::Set(const broker::data& key, const broker::data& value, double expire_time) {
+    if ( max_size == 0 )
+        return;
+
+    if ( auto i = entries.find(key); i != entries.end() ) {
+        i->second.value = value;
+        i->second.expire_time = expire_time;
+        lru.splice(lru.begin(), lru, i->second.lru_pos);
+        return;
+    }
+
+    if ( entries.size() >= max_size ) {
+        entries.erase(lru.back());
+        lru.pop_back();
+    }
+
+    lru.push_front(key);
+    entries.emplace(key, Entry{value, expire_time, lru.begin()});
+}
+
+void StoreCache::Erase(const broker::data& key) {
+    Changed(key);
+
+    if ( auto i = entries.find(key); i != entries.end() ) {
+        lru.erase(i->second.lru_pos);
+        entries.erase(i);
+    }
+}
+
+void StoreCache::Clear() {
+    ++version;
+    min_fill_version = version;
+    changes.clear();
+    entries.clear();
+    lru.clear();
+}
+
+void StoreCache::Changed(const broker::data& key) {
+    ++version;
+
+    if ( changes.size() >= std::max(max_size, MIN_CHANGES_SIZE) && changes.find(key) == changes.end() ) {
+        // Rather than tracking changes forever, forget about them and
+        // drop the results of all queries sent before now instead.
+        changes.clear();
+        min_fill_version = version;
+        return;
+    }
+
+    changes[key] = version;
+}
+
 void StoreHandleVal::Put(BrokerData&& key, BrokerData&& value, std::optional<BrokerTimespan> expiry) {
+    Invalidate(key.value_);
     store.put(std::move(key).value_, std::move(value).value_, expiry);
 }
 
-void StoreHandleVal::Erase(BrokerData&& key) { store.erase(std::move(key).value_); }
+void StoreHandleVal::Erase(BrokerData&& key) {
+    Invalidate(key.value_);
+    store.erase(std::move(key).value_);
+}
 
 void StoreHandleVal::ValDescribe(ODesc* d) const {
     d->Add("broker::store::");
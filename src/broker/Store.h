@@ -4,6 +4,8 @@
 #include <broker/backend_options.hh>
 #include <broker/store.hh>
 #include <broker/store_event.hh>
+#include <list>
+#include <unordered_map>
 
 #include "zeek/Expr.h"
 #include "zeek/OpaqueVal.h"
@@ -11,6 +13,7 @@
 #include "zeek/broker/Data.h"
 #include "zeek/broker/data.bif.h"
 #include "zeek/broker/store.bif.h"
+#include "zeek/telemetry/Counter.h"
 
 namespace zeek::Broker::detail {
 
@@ -73,6 +76,19 @@ public:
         Ref(trigger);
     }
 
+    /**
+     * Constructor for a lookup whose result may go into the store's cache.
+     *
+     * @param cache_version The cache's version at the time of the lookup,
+     * see StoreCache::Fill().
+     */
+    StoreQueryCallback(zeek::detail::trigger::Trigger* arg_trigger, const void* arg_assoc, broker::store store,
+                       broker::data cache_key, uint64_t cache_version)
+        : StoreQueryCallback(arg_trigger, arg_assoc, std::move(store)) {
+        this->cache_key = std::move(cache_key);
+        this->cache_version = cache_version;
+    }
+
     ~StoreQueryCallback() { Unref(trigger); }
 
     void Result(const RecordValPtr& result) {
@@ -90,10 +106,112 @@ public:
 
     const broker::store& Store() const { return store; }
 
+    const std::optional<broker::data>& CacheKey() const { return cache_key; }
+    uint64_t CacheVersion() const { return cache_version; }
+
 private:
     zeek::detail::trigger::Trigger* trigger;
     const void* assoc;
     broker::store store;
+    std::optional<broker::data> cache_key;
+    uint64_t cache_version = 0;
+};
+
+/**
+ * A bounded read-through cache of a data store's values, so that lookups of
+ * hot keys can be answered right away rather than through a round trip to
+ * the store. Entries are populated from query results and then kept current
+ * by the store's update events; they are dropped once their expiry passes,
+ * or after a maximum age in case an update got lost.
+ */
+class StoreCache {
+public:
+    /**
+     * Constructor.
+     *
+     * @param max_size The maximum number of entries. Once reached, the
+     * least recently used entry gets evicted.
+     *
+     * @param ttl The maximum age of an entry, or 0 for no limit.
+     *
+     * @param hits Counter to increment on lookups that find a value.
+     *
+     * @param misses Counter to increment on lookups that don't.
+     */
+    StoreCache(size_t max_size, double ttl, telemetry::IntCounter hits, telemetry::IntCounter misses)
+        : max_size(max_size), ttl(ttl), hits(std::move(hits)), misses(std::move(misses)) {}
+
+    /**
+     * Returns the cached value for a key, or null if there's none.
+     */
+    const broker::data* Lookup(const broker::data& key);
+
+    /**
+     * Refreshes a key's cached value, as reported by a store update. Keys
+     * not in the cache already don't get added; that's left to Fill(), so
+     * that only keys getting looked up take up space.
+     *
+     * @param expiry The time until the store expires the key, if any.
+     */
+    void Insert(const broker::data& key, const broker::data& value, std::optional<broker::timespan> expiry);
+
+    /**
+     * Caches a key's value as returned by a query, unless the key has
+     * changed since the query got sent. That way, a response overtaken
+     * by an update can't put an outdated value back into the cache.
+     *
+     * @param version The result of Version() when sending the query.
+     */
+    void Fill(const broker::data& key, const broker::data& value, uint64_t version);
+
+    /**
+     * Removes a key's value from the cache.
+     */
+    void Erase(const broker::data& key);
+
+    /**
+     * Removes all values from the cache.
+     */
+    void Clear();
+
+    /**
+     * Returns a number that changes with every update to the store, to
+     * pass to Fill() for a query sent now.
+     */
+    uint64_t Version() const { return version; }
+
+    size_t Size() const { return entries.size(); }
+
+private:
+    void Set(const broker::data& key, const broker::data& value, double expire_time);
+
+    // Records that a key's value changed in the store.
+    void Changed(const broker::data& key);
+
+    // Minimum number of changes to remember, see Changed().
+    static constexpr size_t MIN_CHANGES_SIZE = 1024;
+
+    struct Entry {
+        broker::data value;
+        double expire_time; // Wall-clock time after which not to use the value.
+        std::list<broker::data>::iterator lru_pos;
+    };
+
+    size_t max_size;
+    double ttl;
+    telemetry::IntCounter hits;
+    telemetry::IntCounter misses;
+
+    std::unordered_map<broker::data, Entry> entries;
+    std::list<broker::data> lru; // Most recently used first.
+    uint64_t version = 0;
+
+    // The version of each key's latest change. Queries sent before then
+    // may have returned an outdated value.
+    std::unordered_map<broker::data, uint64_t> changes;
+
+    // Results of queries sent before this version get ignored.
+    uint64_t min_fill_version = 0;
 };
 
 /**
@@ -115,6 +233,12 @@ public:
 
     void Erase(BrokerData&& key);
 
+    // Drops a key that's about to be modified from the cache, if any.
+    void Invalidate(const broker::data& key) {
+        if ( cache )
+            cache->Erase(key);
+    }
+
     void ValDescribe(ODesc* d) const override;
 
     broker::store store;
@@ -123,6 +247,8 @@ public:
     // Zeek table that events are forwarded to.
     TableValPtr forward_to;
     bool have_store = false;
+    // Cache for lookups, if enabled through Broker::store_cache_size.
+    std::unique_ptr<StoreCache> cache;
 
 protected:
     IntrusivePtr<Val> DoClone(CloneState* state) override { return {NewRef{}, this}; }
@@ -255,7 +255,7 @@ bool File::SetMime(const std::string& mime_type) {
         return false;
 
     auto meta = make_intrusive<RecordVal>(id::fa_metadata);
-    meta->Assign(meta_mime_type_idx, mime_type);
+    meta->Assign(meta_mime_type_idx, val_mgr->InternedString(mime_type));
     meta->Assign(meta_inferred_idx, false);
 
     FileEvent(file_sniff, {val, std::move(meta)});
@@ -288,7 +288,7 @@ void File::InferMetadata() {
     auto meta = make_intrusive<RecordVal>(id::fa_metadata);
 
     if ( ! matches.empty() ) {
-        meta->Assign(meta_mime_type_idx, *(matches.begin()->second.begin()));
+        meta->Assign(meta_mime_type_idx, val_mgr->InternedString(*(matches.begin()->second.begin())));
         meta->Assign(meta_mime_types_idx, file_analysis::GenMIMEMatchesVal(matches));
     }
 
@@ -18,6 +18,7 @@
 #include "zeek/input/ReaderFrontend.h"
 #include "zeek/input/input.bif.h"
 #include "zeek/module_util.h"
+#include "zeek/telemetry/Manager.h"
 #include "zeek/threading/SerialTypes.h"
 
 using namespace std;
@@ -96,6 +97,14 @@ public:
 
     EventHandlerPtr event;
 
+    // Counts entries received, for progress telemetry.
+    std::optional<telemetry::IntCounter> entries_counter;
+
+    // Entries received since the last EndCurrentSend(), and when the
+    // first of them arrived.
+    uint64_t load_entries = 0;
+    double load_start = 0.0;
+
     TableStream();
     ~TableStream() override;
 };
@@ -167,6 +176,10 @@ Manager::AnalysisStream::AnalysisStream() : Manager::Stream::Stream(ANALYSIS_STR
 
 Manager::Manager() : plugin::ComponentManager<input::Component>("Input", "Reader") {
     end_of_data = event_registry->Register("Input::end_of_data");
+    load_complete = event_registry->Register("Input::load_complete");
+    table_entries_family = telemetry_mgr->CounterFamily("zeek", "input-table-entries", {"stream"},
+                                                        "Number of entries received by input table streams.", "1",
+                                                        true);
 }
 
 Manager::~Manager() {
@@ -636,9 +649,13 @@ bool Manager::CreateTableStream(RecordVal* fval) {
     stream->lastDict = new PDict<InputHash>;
     stream->lastDict->SetDeleteFunc(input_hash_delete_func);
     stream->want_record = (want_record->InternalInt() == 1);
+    stream->entries_counter = table_entries_family->GetOrAdd({{"stream", stream->name}});
 
     assert(stream->reader);
-    stream->reader->Init(fieldsV.size(), fields);
+    // Without a predicate, there's nothing in the script layer to see
+    // unchanged entries, so the reader may skip them.
+    bool incremental = BifConst::Input::incremental_updates && ! stream->pred;
+    stream->reader->Init(fieldsV.size(), fields, idxfields, incremental);
 
     readers[stream->reader] = stream;
 
@@ -1025,7 +1042,33 @@ void Manager::SendEntry(ReaderFrontend* reader, Value** vals) {
     Value::delete_value_ptr_array(vals, readFields);
 }
 
-int Manager::SendEntryTable(Stream* i, const Value* const* vals) {
+void Manager::SendEntryBatch(ReaderFrontend* reader, std::vector<PreparedEntry>* entries) {
+    Stream* i = FindStream(reader);
+
+    if ( i == nullptr || i->stream_type != TABLE_STREAM ) {
+        if ( i == nullptr )
+            reporter->InternalWarning("Unknown reader %s in SendEntryBatch", reader->Name());
+
+        for ( auto& e : *entries ) {
+            delete e.idxhash;
+            e.idxhash = nullptr;
+
+            if ( i )
+                SendEntry(reader, e.vals);
+            else
+                Value::delete_value_ptr_array(e.vals, reader->NumFields());
+        }
+
+        return;
+    }
+
+    for ( auto& e : *entries ) {
+        int readFields = SendEntryTable(i, e.vals, &e);
+        Value::delete_value_ptr_array(e.vals, readFields);
+    }
+}
+
+int Manager::SendEntryTable(Stream* i, const Value* const* vals, PreparedEntry* prepared) {
     bool updated = false;
 
     assert(i);
@@ -1033,7 +1076,19 @@ int Manager::SendEntryTable(Stream* i, const Value* const* vals) {
     assert(i->stream_type == TABLE_STREAM);
     TableStream* stream = (TableStream*)i;
 
-    zeek::detail::HashKey* idxhash = HashValues(stream->num_idx_fields, vals);
+    if ( stream->load_entries++ == 0 )
+        stream->load_start = util::current_time(true);
+
+    stream->entries_counter->Inc();
+
+    zeek::detail::HashKey* idxhash = nullptr;
+
+    if ( prepared ) {
+        idxhash = prepared->idxhash;
+        prepared->idxhash = nullptr;
+    }
+    else
+        idxhash = HashValues(stream->num_idx_fields, vals);
 
     if ( idxhash == nullptr ) {
         Warning(i, "Could not hash line. Ignoring");
@@ -1041,7 +1096,10 @@ int Manager::SendEntryTable(Stream* i, const Value* const* vals) {
     }
 
     zeek::detail::hash_t valhash = 0;
-    if ( stream->num_val_fields > 0 ) {
+    if ( prepared )
+        valhash = prepared->valhash;
+
+    else if ( stream->num_val_fields > 0 ) {
         if ( zeek::detail::HashKey* valhashkey = HashValues(stream->num_val_fields, vals + stream->num_idx_fields) ) {
             valhash = valhashkey->Hash();
             delete (valhashkey);
@@ -1235,41 +1293,13 @@ void Manager::EndCurrentSend(ReaderFrontend* reader) {
         auto lastDictIdxKey = it->GetHashKey();
         InputHash* ih = it->value;
 
-        ValPtr val;
-        ValPtr predidx;
-        EnumValPtr ev;
-        int startpos = 0;
-
-        if ( stream->pred || stream->event ) {
-            auto idx = stream->tab->RecreateIndex(*ih->idxkey);
-            assert(idx != nullptr);
-            val = stream->tab->FindOrDefault(idx);
-            assert(val != nullptr);
-            predidx = {AdoptRef{}, ListValToRecordVal(idx.get(), stream->itype, &startpos)};
-            ev = BifType::Enum::Input::Event->GetEnumVal(BifEnum::Input::EVENT_REMOVED);
-        }
-
-        if ( stream->pred ) {
-            // ask predicate, if we want to expire this element...
-
-            bool result = CallPred(stream->pred, 3, ev->Ref(), predidx->Ref(), val->Ref());
-
-            if ( result == false ) {
-                // Keep it. Hence - we quit and simply go to the next entry of lastDict
-                // ah well - and we have to add the entry to currDict...
-                stream->currDict->Insert(lastDictIdxKey.get(), stream->lastDict->RemoveEntry(lastDictIdxKey.get()));
-                continue;
-            }
-        }
-
-        if ( stream->event ) {
-            if ( stream->num_val_fields == 0 )
-                SendEvent(stream->event, 3, stream->description->Ref(), ev->Ref(), predidx->Ref());
-            else
-                SendEvent(stream->event, 4, stream->description->Ref(), ev->Ref(), predidx->Ref(), val->Ref());
+        if ( ! ExpireEntry(stream, *ih->idxkey) ) {
+            // Keep it. Hence - we quit and simply go to the next entry of lastDict
+            // ah well - and we have to add the entry to currDict...
+            stream->currDict->Insert(lastDictIdxKey.get(), stream->lastDict->RemoveEntry(lastDictIdxKey.get()));
+            continue;
         }
 
-        stream->tab->Remove(*ih->idxkey);
         stream->lastDict->Remove(lastDictIdxKey.get()); // delete in next line
         delete ih;
     }
@@ -1285,7 +1315,103 @@ void Manager::EndCurrentSend(ReaderFrontend* reader) {
     DBG_LOG(DBG_INPUT, "EndCurrentSend complete for stream %s", i->name.c_str());
 #endif
 
-    SendEndOfData(i);
+    EndTableLoad(stream);
+}
+
+void Manager::EndCurrentSend(ReaderFrontend* reader, std::vector<zeek::detail::HashKey*>* removed) {
+    Stream* i = FindStream(reader);
+
+    if ( i == nullptr || i->stream_type != TABLE_STREAM ) {
+        for ( auto k : *removed )
+            delete k;
+
+        removed->clear();
+
+        if ( i == nullptr )
+            reporter->InternalWarning("Unknown reader %s in EndCurrentSend", reader->Name());
+        else
+            SendEndOfData(i);
+
+        return;
+    }
+
+#ifdef DEBUG
+    DBG_LOG(DBG_INPUT, "Got incremental EndCurrentSend stream %s, %zu removed", i->name.c_str(), removed->size());
+#endif
+
+    auto* stream = static_cast<TableStream*>(i);
+
+    // Unlike above, lastDict still holds all the unchanged entries, so we
+    // only touch what the reader told us about.
+    for ( auto k : *removed ) {
+        if ( InputHash* ih = stream->lastDict->Lookup(k); ih && ExpireEntry(stream, *ih->idxkey) )
+            delete stream->lastDict->RemoveEntry(k);
+
+        delete k;
+    }
+
+    removed->clear();
+
+    for ( auto it = stream->currDict->begin_robust(); it != stream->currDict->end_robust(); ++it ) {
+        auto key = it->GetHashKey();
+        delete stream->lastDict->Insert(key.get(), stream->currDict->RemoveEntry(key.get()));
+    }
+
+    stream->currDict->Clear();
+
+#ifdef DEBUG
+    DBG_LOG(DBG_INPUT, "EndCurrentSend complete for stream %s", i->name.c_str());
+#endif
+
+    EndTableLoad(stream);
+}
+
+bool Manager::ExpireEntry(TableStream* stream, const zeek::detail::HashKey& idxkey) {
+    ValPtr val;
+    ValPtr predidx;
+    EnumValPtr ev;
+    int startpos = 0;
+
+    if ( stream->pred || stream->event ) {
+        auto idx = stream->tab->RecreateIndex(idxkey);
+        assert(idx != nullptr);
+        val = stream->tab->FindOrDefault(idx);
+        assert(val != nullptr);
+        predidx = {AdoptRef{}, ListValToRecordVal(idx.get(), stream->itype, &startpos)};
+        ev = BifType::Enum::Input::Event->GetEnumVal(BifEnum::Input::EVENT_REMOVED);
+    }
+
+    if ( stream->pred ) {
+        // ask predicate, if we want to expire this element...
+        bool result = CallPred(stream->pred, 3, ev->Ref(), predidx->Ref(), val->Ref());
+
+        if ( result == false )
+            return false;
+    }
+
+    if ( stream->event ) {
+        if ( stream->num_val_fields == 0 )
+            SendEvent(stream->event, 3, stream->description->Ref(), ev->Ref(), predidx->Ref());
+        else
+            SendEvent(stream->event, 4, stream->description->Ref(), ev->Ref(), predidx->Ref(), val->Ref());
+    }
+
+    stream->tab->Remove(idxkey);
+    return true;
+}
+
+void Manager::EndTableLoad(TableStream* stream) {
+    if ( load_complete ) {
+        double elapsed = stream->load_entries ? util::current_time(true) - stream->load_start : 0.0;
+        auto name = make_intrusive<StringVal>(stream->name.c_str());
+        auto source = make_intrusive<StringVal>(stream->reader->Info().source);
+        SendEvent(load_complete, 4, name.release(), source.release(), val_mgr->Count(stream->load_entries).release(),
+                  make_intrusive<IntervalVal>(elapsed).release());
+    }
+
+    stream->load_entries = 0;
+
+    SendEndOfData(stream);
 }
 
 void Manager::SendEndOfData(ReaderFrontend* reader) {
@@ -1747,7 +1873,7 @@ RecordVal* Manager::ValueToRecordVal(const Stream* stream, const Value* const* v
 
 // Count the length of the values used to create a correct length buffer for
 // hashing later
-int Manager::GetValueLength(const Value* val) const {
+int Manager::GetValueLength(const Value* val) {
     assert(val->present); // presence has to be checked elsewhere
     int length = 0;
 
@@ -1818,7 +1944,7 @@ int Manager::GetValueLength(const Value* val) const {
 
 // Given a threading::value, copy the raw data bytes into *data and return how many bytes were
 // copied. Used for hashing the values for lookup in the Zeek table
-int Manager::CopyValue(char* data, const int startpos, const Value* val) const {
+int Manager::CopyValue(char* data, const int startpos, const Value* val) {
     assert(val->present); // presence has to be checked elsewhere
 
     switch ( val->type ) {
@@ -1931,7 +2057,7 @@ int Manager::CopyValue(char* data, const int startpos, const Value* val) const {
 
 // Hash num_elements threading values and return the HashKey for them. At least one of the vals has
 // to be ->present.
-zeek::detail::HashKey* Manager::HashValues(const int num_elements, const Value* const* vals) const {
+zeek::detail::HashKey* Manager::HashValues(const int num_elements, const Value* const* vals) {
     int length = 0;
 
     for ( int i = 0; i < num_elements; i++ ) {
@@ -5,11 +5,14 @@
 #pragma once
 
 #include <map>
+#include <optional>
+#include <vector>
 
 #include "zeek/EventHandler.h"
 #include "zeek/Tag.h"
 #include "zeek/input/Component.h"
 #include "zeek/plugin/ComponentManager.h"
+#include "zeek/telemetry/Counter.h"
 #include "zeek/threading/SerialTypes.h"
 
 namespace zeek {
@@ -20,6 +23,7 @@ namespace input {
 
 class ReaderFrontend;
 class ReaderBackend;
+struct PreparedEntry;
 
 /**
  * Singleton class for managing input streams.
@@ -115,12 +119,23 @@ public:
      */
     static bool IsCompatibleType(Type* t, bool atomic_only = false);
 
+    /**
+     * Computes the hash key identifying a set of values, as used to track
+     * the entries of table streams. This may be called from reader
+     * threads.
+     *
+     * @return The key, with ownership passed to the caller, or null if all
+     * of the values are unset.
+     */
+    static zeek::detail::HashKey* HashValues(const int num_elements, const threading::Value* const* vals);
+
 protected:
     friend class ReaderFrontend;
     friend class PutMessage;
     friend class DeleteMessage;
     friend class ClearMessage;
     friend class SendEntryMessage;
+    friend class SendEntryBatchMessage;
     friend class EndCurrentSendMessage;
     friend class ReaderClosedMessage;
     friend class DisableMessage;
@@ -143,6 +158,15 @@ protected:
     void SendEntry(ReaderFrontend* reader, threading::Value** vals);
     void EndCurrentSend(ReaderFrontend* reader);
 
+    // Like EndCurrentSend(), for a reader that sent only the entries that
+    // changed since its last round. All other entries remain, except for
+    // the ones with the given keys. Takes ownership of the keys.
+    void EndCurrentSend(ReaderFrontend* reader, std::vector<zeek::detail::HashKey*>* removed);
+
+    // Like SendEntry(), for a batch of table entries that the reader has
+    // hashed already. Takes ownership of the entries' content.
+    void SendEntryBatch(ReaderFrontend* reader, std::vector<PreparedEntry>* entries);
+
     // Instantiates a new ReaderBackend of the given type (note that
     // doing so creates a new thread!).
     ReaderBackend* CreateBackend(ReaderFrontend* frontend, EnumVal* tag);
@@ -189,8 +213,18 @@ private:
     // type.
     bool CheckErrorEventTypes(const std::string& stream_name, const Func* error_event, bool table) const;
 
-    // SendEntry implementation for Table stream.
-    int SendEntryTable(Stream* i, const threading::Value* const* vals);
+    // SendEntry implementation for Table stream. If the entry comes
+    // prepared by the reader, this takes ownership of its hash key.
+    int SendEntryTable(Stream* i, const threading::Value* const* vals, PreparedEntry* prepared = nullptr);
+
+    // Removes an entry that's no longer in a table stream's source,
+    // unless the stream's predicate wants to keep it. Returns true if
+    // removed.
+    bool ExpireEntry(TableStream* stream, const zeek::detail::HashKey& idxkey);
+
+    // Wraps up a round of EndCurrentSend() by raising the corresponding
+    // events.
+    void EndTableLoad(TableStream* stream);
 
     // Put implementation for Table stream.
     int PutTable(Stream* i, const threading::Value* const* vals);
@@ -214,15 +248,12 @@ private:
     // Call predicate function and return result.
     bool CallPred(Func* pred_func, const int numvals, ...) const;
 
-    // Get a hashkey for a set of threading::Values.
-    zeek::detail::HashKey* HashValues(const int num_elements, const threading::Value* const* vals) const;
-
     // Get the memory used by a specific value.
-    int GetValueLength(const threading::Value* val) const;
+    static int GetValueLength(const threading::Value* val);
 
     // Copies the raw data in a specific threading::Value to position
     // startpos.
-    int CopyValue(char* data, const int startpos, const threading::Value* val) const;
+    static int CopyValue(char* data, const int startpos, const threading::Value* val);
 
     // Convert Threading::Value to an internal Zeek Type (works with Records).
     Val* ValueToVal(const Stream* i, const threading::Value* val, Type* request_type, bool& have_error) const;
@@ -261,6 +292,9 @@ private:
     std::map<ReaderFrontend*, Stream*> readers;
 
     EventHandlerPtr end_of_data;
+    EventHandlerPtr load_complete;
+
+    std::optional<telemetry::IntCounterFamily> table_entries_family;
 };
 
 } // namespace input
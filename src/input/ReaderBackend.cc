@@ -2,9 +2,12 @@
 
 #include "zeek/input/ReaderBackend.h"
 
+#include <algorithm>
+
 #include "zeek/Desc.h"
 #include "zeek/input/Manager.h"
 #include "zeek/input/ReaderFrontend.h"
+#include "zeek/input/input.bif.h"
 
 using zeek::threading::Field;
 using zeek::threading::Value;
@@ -81,17 +84,54 @@ private:
     Value** val;
 };
 
+class SendEntryBatchMessage final : public threading::OutputMessage<ReaderFrontend> {
+public:
+    SendEntryBatchMessage(ReaderFrontend* reader, std::vector<PreparedEntry> entries)
+        : threading::OutputMessage<ReaderFrontend>("SendEntryBatch", reader), entries(std::move(entries)) {}
+
+    ~SendEntryBatchMessage() override {
+        // Only non-empty if never processed.
+        for ( auto& e : entries )
+            delete e.idxhash;
+    }
+
+    bool Process() override {
+        input_mgr->SendEntryBatch(Object(), &entries);
+        entries.clear();
+        return true;
+    }
+
+private:
+    std::vector<PreparedEntry> entries;
+};
+
 class EndCurrentSendMessage final : public threading::OutputMessage<ReaderFrontend> {
 public:
     EndCurrentSendMessage(ReaderFrontend* reader)
         : threading::OutputMessage<ReaderFrontend>("EndCurrentSend", reader) {}
 
+    EndCurrentSendMessage(ReaderFrontend* reader, std::vector<zeek::detail::HashKey*> removed)
+        : threading::OutputMessage<ReaderFrontend>("EndCurrentSend", reader),
+          incremental(true),
+          removed(std::move(removed)) {}
+
+    ~EndCurrentSendMessage() override {
+        for ( auto k : removed )
+            delete k;
+    }
+
     bool Process() override {
-        input_mgr->EndCurrentSend(Object());
+        if ( incremental )
+            input_mgr->EndCurrentSend(Object(), &removed);
+        else
+            input_mgr->EndCurrentSend(Object());
+
         return true;
     }
 
 private:
+    bool incremental = false;
+    std::vector<zeek::detail::HashKey*> removed;
 };
 
 class EndOfDataMessage final : public threading::OutputMessage<ReaderFrontend> {
@@ -154,25 +194,139 @@ ReaderBackend::ReaderBackend(ReaderFrontend* arg_frontend) : MsgThread() {
     info = new ReaderInfo(frontend->Info());
     num_fields = 0;
     fields = nullptr;
+    batch_size = BifConst::Input::bulk_batch_size;
 
     SetName(frontend->Name());
+
+    if ( BifConst::Input::max_process_time > 0 )
+        SetMaxProcessTime(BifConst::Input::max_process_time);
 }
 
-ReaderBackend::~ReaderBackend() { delete info; }
+ReaderBackend::~ReaderBackend() {
+    for ( auto& e : batch ) {
+        Value::delete_value_ptr_array(e.vals, num_fields);
+        delete e.idxhash;
+    }
 
-void ReaderBackend::Put(Value** val) { SendOut(new PutMessage(frontend, val)); }
+    delete info;
+}
 
-void ReaderBackend::Delete(Value** val) { SendOut(new DeleteMessage(frontend, val)); }
+void ReaderBackend::Put(Value** val) {
+    FlushEntries();
+    SendOut(new PutMessage(frontend, val));
+}
 
-void ReaderBackend::Clear() { SendOut(new ClearMessage(frontend)); }
+void ReaderBackend::Delete(Value** val) {
+    FlushEntries();
+    SendOut(new DeleteMessage(frontend, val));
+}
 
-void ReaderBackend::EndCurrentSend() { SendOut(new EndCurrentSendMessage(frontend)); }
+void ReaderBackend::Clear() {
+    FlushEntries();
+    tracked.clear();
+    SendOut(new ClearMessage(frontend));
+}
 
-void ReaderBackend::EndOfData() { SendOut(new EndOfDataMessage(frontend)); }
+void ReaderBackend::EndCurrentSend() {
+    FlushEntries();
 
-void ReaderBackend::SendEntry(Value** vals) { SendOut(new SendEntryMessage(frontend, vals)); }
+    if ( ! incremental ) {
+        SendOut(new EndCurrentSendMessage(frontend));
+        return;
+    }
+
+    // Whatever we didn't see this round is gone from the source. Report
+    // these in the order they first appeared, for deterministic events.
+    std::vector<std::pair<uint64_t, zeek::detail::HashKey*>> gone;
+
+    for ( auto it = tracked.begin(); it != tracked.end(); ) {
+        if ( it->second.round != round ) {
+            gone.emplace_back(it->second.seq,
+                              new zeek::detail::HashKey(it->first.data(), it->first.size(), it->second.keyhash));
+            it = tracked.erase(it);
+        }
+        else
+            ++it;
+    }
+
+    std::sort(gone.begin(), gone.end());
 
-bool ReaderBackend::Init(const int arg_num_fields, const threading::Field* const* arg_fields) {
+    std::vector<zeek::detail::HashKey*> removed;
+    removed.reserve(gone.size());
+
+    for ( auto& [seq, key] : gone )
+        removed.push_back(key);
+
+    ++round;
+    SendOut(new EndCurrentSendMessage(frontend, std::move(removed)));
+}
+
+void ReaderBackend::EndOfData() {
+    FlushEntries();
+    SendOut(new EndOfDataMessage(frontend));
+}
+
+void ReaderBackend::SendEntry(Value** vals) {
+    if ( num_idx_fields == 0 || (batch_size <= 1 && ! incremental) ) {
+        SendOut(new SendEntryMessage(frontend, vals));
+        return;
+    }
+
+    // Hash the entry here, rather than on the main thread.
+    PreparedEntry e;
+    e.vals = vals;
+    e.idxhash = Manager::HashValues(num_idx_fields, vals);
+
+    if ( e.idxhash && num_fields > static_cast<unsigned int>(num_idx_fields) ) {
+        if ( auto valhashkey = Manager::HashValues(num_fields - num_idx_fields, vals + num_idx_fields) ) {
+            e.valhash = valhashkey->Hash();
+            delete valhashkey;
+        }
+    }
+
+    if ( incremental && e.idxhash && Unchanged(e) ) {
+        Value::delete_value_ptr_array(vals, num_fields);
+        delete e.idxhash;
+        return;
+    }
+
+    if ( batch.empty() )
+        batch.reserve(std::max<size_t>(batch_size, 1));
+
+    batch.push_back(e);
+
+    if ( batch.size() >= batch_size )
+        FlushEntries();
+}
+
+bool ReaderBackend::Unchanged(const PreparedEntry& e) {
+    std::string key(static_cast<const char*>(e.idxhash->Key()), e.idxhash->Size());
+    auto [it, inserted] = tracked.try_emplace(std::move(key),
+                                              TrackedEntry{e.idxhash->Hash(), e.valhash, round, next_seq});
+
+    if ( inserted ) {
+        ++next_seq;
+        return false;
+    }
+
+    // The manager still has the entry from the previous round, unless
+    // we've passed on a different version already in this one.
+    bool unchanged = it->second.round != round && it->second.valhash == e.valhash;
+    it->second.valhash = e.valhash;
+    it->second.round = round;
+    return unchanged;
+}
+
+void ReaderBackend::FlushEntries() {
+    if ( batch.empty() )
+        return;
+
+    SendOut(new SendEntryBatchMessage(frontend, std::move(batch)));
+    batch.clear();
+}
+
+bool ReaderBackend::Init(const int arg_num_fields, const threading::Field* const* arg_fields,
+                         int arg_num_idx_fields, bool arg_incremental) {
     if ( Failed() )
         return true;
 
@@ -182,6 +336,8 @@ bool ReaderBackend::Init(const int arg_num_fields, const threading::Field* const
 
     num_fields = arg_num_fields;
     fields = arg_fields;
+    num_idx_fields = arg_num_idx_fields;
+    incremental = arg_incremental && num_idx_fields > 0;
 
     // disable if DoInit returns error.
     int success = DoInit(*info, arg_num_fields, arg_fields);
@@ -198,6 +354,8 @@ bool ReaderBackend::OnFinish(double network_time) {
     if ( ! Failed() )
         DoClose();
 
+    FlushEntries();
+
     disabled = true; // frontend disables itself when it gets the Close-message.
     SendOut(new ReaderClosedMessage(frontend));
 
@@ -220,6 +378,8 @@ bool ReaderBackend::Update() {
         return true;
 
     bool success = DoUpdate();
+    FlushEntries();
+
     if ( ! success )
         DisableFrontend();
 
@@ -232,6 +392,8 @@ void ReaderBackend::DisableFrontend() {
     if ( disabled )
         return;
 
+    FlushEntries();
+
     // We also set disabled here, because there still may be other
     // messages queued and we will dutifully ignore these from now.
     disabled = true;
@@ -242,10 +404,13 @@ bool ReaderBackend::OnHeartbeat(double network_time, double current_time) {
     if ( Failed() )
         return true;
 
-    return DoHeartbeat(network_time, current_time);
+    bool result = DoHeartbeat(network_time, current_time);
+    FlushEntries();
+    return result;
 }
 
 void ReaderBackend::Info(const char* msg) {
+    FlushEntries();
     SendOut(new ReaderErrorMessage(frontend, ReaderErrorMessage::INFO, msg));
     MsgThread::Info(msg);
 }
@@ -267,11 +432,13 @@ void ReaderBackend::Warning(const char* msg) {
     if ( suppress_warnings )
         return;
 
+    FlushEntries();
     SendOut(new ReaderErrorMessage(frontend, ReaderErrorMessage::WARNING, msg));
     MsgThread::Warning(msg);
 }
 
 void ReaderBackend::Error(const char* msg) {
+    FlushEntries();
     SendOut(new ReaderErrorMessage(frontend, ReaderErrorMessage::ERROR, msg));
     MsgThread::Error(msg);
 
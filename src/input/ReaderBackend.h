@@ -2,6 +2,11 @@
 
 #pragma once
 
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "zeek/Hash.h"
 #include "zeek/ZeekString.h"
 #include "zeek/input/Component.h"
 #include "zeek/threading/MsgThread.h"
@@ -15,6 +20,16 @@ namespace zeek::input {
 
 class ReaderFrontend;
 
+/**
+ * A table entry that a reader has prepared for the manager, with the
+ * hashing done on the reader's thread.
+ */
+struct PreparedEntry {
+    threading::Value** vals;          // The entry's values.
+    zeek::detail::HashKey* idxhash;   // Key of the index values, or null if unset.
+    zeek::detail::hash_t valhash = 0; // Hash of the remaining values.
+};
+
 /**
  * The modes a reader can be in.
  */
@@ -151,9 +166,19 @@ public:
      * @param config A string map containing additional configuration options
      * for the reader.
      *
+     * @param num_idx_fields For table streams, the number of leading
+     * fields forming the table's index; zero otherwise. If set, entries
+     * passed to SendEntry() get hashed right away and sent to the
+     * manager in batches.
+     *
+     * @param incremental For table streams, whether SendEntry() may skip
+     * entries that haven't changed since the previous EndCurrentSend().
+     * The manager then keeps the previous version of these.
+     *
      * @return False if an error occurred.
      */
-    bool Init(int num_fields, const threading::Field* const* fields);
+    bool Init(int num_fields, const threading::Field* const* fields, int num_idx_fields = 0,
+              bool incremental = false);
 
     /**
      * Force trigger an update of the input stream. The action that will
@@ -353,6 +378,14 @@ protected:
     void EndCurrentSend();
 
 private:
+    // Passes on any entries batched up by SendEntry(). Must be called
+    // before sending anything else, to retain ordering.
+    void FlushEntries();
+
+    // Records an entry for incremental updates. Returns true if the
+    // manager has it already, so that it doesn't need to be sent.
+    bool Unchanged(const PreparedEntry& e);
+
     // Frontend that instantiated us. This object must not be accessed
     // from this class, it's running in a different thread!
     ReaderFrontend* frontend;
@@ -365,6 +398,26 @@ private:
     // this is an internal indicator in case the read is currently in a failed state
     // it's used to suppress duplicate error messages.
     bool suppress_warnings = false;
+
+    int num_idx_fields = 0;
+    size_t batch_size = 0;
+    std::vector<PreparedEntry> batch;
+
+    // For incremental updates, the entries passed on to the manager,
+    // keyed by their index hash key. The round tells whether an entry
+    // has been seen since the last EndCurrentSend(); the sequence number
+    // orders entries by first appearance.
+    struct TrackedEntry {
+        zeek::detail::hash_t keyhash;
+        zeek::detail::hash_t valhash;
+        uint64_t round;
+        uint64_t seq;
+    };
+
+    bool incremental = false;
+    uint64_t round = 0;
+    uint64_t next_seq = 0;
+    std::unordered_map<std::string, TrackedEntry> tracked;
 };
 
 } // namespace zeek::input
@@ -9,13 +9,20 @@ namespace zeek::input {
 
 class InitMessage final : public threading::InputMessage<ReaderBackend> {
 public:
-    InitMessage(ReaderBackend* backend, const int num_fields, const threading::Field* const* fields)
-        : threading::InputMessage<ReaderBackend>("Init", backend), num_fields(num_fields), fields(fields) {}
+    InitMessage(ReaderBackend* backend, const int num_fields, const threading::Field* const* fields,
+                const int num_idx_fields, const bool incremental)
+        : threading::InputMessage<ReaderBackend>("Init", backend),
+          num_fields(num_fields),
+          num_idx_fields(num_idx_fields),
+          incremental(incremental),
+          fields(fields) {}
 
-    bool Process() override { return Object()->Init(num_fields, fields); }
+    bool Process() override { return Object()->Init(num_fields, fields, num_idx_fields, incremental); }
 
 private:
     const int num_fields;
+    const int num_idx_fields;
+    const bool incremental;
     const threading::Field* const* fields;
 };
 
@@ -50,7 +57,8 @@ ReaderFrontend::~ReaderFrontend() {
     delete info;
 }
 
-void ReaderFrontend::Init(const int arg_num_fields, const threading::Field* const* arg_fields) {
+void ReaderFrontend::Init(const int arg_num_fields, const threading::Field* const* arg_fields, int num_idx_fields,
+                          bool incremental) {
     if ( disabled )
         return;
 
@@ -61,7 +69,7 @@ void ReaderFrontend::Init(const int arg_num_fields, const threading::Field* cons
     fields = arg_fields;
     initialized = true;
 
-    backend->SendIn(new InitMessage(backend, num_fields, fields));
+    backend->SendIn(new InitMessage(backend, num_fields, fields, num_idx_fields, incremental));
 }
 
 void ReaderFrontend::Update() {
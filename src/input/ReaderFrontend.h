@@ -55,7 +55,8 @@ public:
      *
      * This method must only be called from the main thread.
      */
-    void Init(const int arg_num_fields, const threading::Field* const* fields);
+    void Init(const int arg_num_fields, const threading::Field* const* fields, int num_idx_fields = 0,
+              bool incremental = false);
 
     /**
      * Force an update of the current input source. Actual action depends
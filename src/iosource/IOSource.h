@@ -10,7 +10,15 @@ namespace zeek::iosource {
  */
 class IOSource {
 public:
-    enum ProcessFlags { READ = 0x01, WRITE = 0x02 };
+    enum ProcessFlags {
+        READ = 0x01,
+        WRITE = 0x02,
+
+        // Only for registering an fd: the source empties the fd entirely
+        // each time it gets processed, so the fd can be watched for
+        // changes in readiness only.
+        EDGE_TRIGGERED = 0x04,
+    };
 
     /**
      * Constructor.
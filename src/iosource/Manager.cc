@@ -2,12 +2,18 @@
 
 #include "zeek/iosource/Manager.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 // These two files have to remain in the same order or FreeBSD builds
 // stop working.
 // clang-format off
 #include <sys/types.h>
+#ifdef ZEEK_IOSOURCE_EPOLL
+#include <sys/epoll.h>
+#else
 #include <sys/event.h>
+#endif
 // clang-format on
 #include <sys/time.h>
 #include <unistd.h>
@@ -20,6 +26,7 @@
 #include "zeek/iosource/PktDumper.h"
 #include "zeek/iosource/PktSrc.h"
 #include "zeek/plugin/Manager.h"
+#include "zeek/telemetry/Manager.h"
 #include "zeek/util.h"
 
 #define DEFAULT_PREFIX "pcap"
@@ -29,7 +36,8 @@ extern int signal_val;
 namespace zeek::iosource {
 
 Manager::WakeupHandler::WakeupHandler() {
-    if ( ! iosource_mgr->RegisterFd(flare.FD(), this) )
+    // Process() empties the flare, so edge-triggered is fine.
+    if ( ! iosource_mgr->RegisterFd(flare.FD(), this, IOSource::READ | IOSource::EDGE_TRIGGERED) )
         reporter->FatalError("Failed to register WakeupHandler's fd with iosource_mgr");
 }
 
@@ -47,9 +55,15 @@ void Manager::WakeupHandler::Ping(std::string_view where) {
 }
 
 Manager::Manager() {
+#ifdef ZEEK_IOSOURCE_EPOLL
+    event_queue = epoll_create1(EPOLL_CLOEXEC);
+    if ( event_queue == -1 )
+        reporter->FatalError("Failed to initialize epoll: %s", strerror(errno));
+#else
     event_queue = kqueue();
     if ( event_queue == -1 )
         reporter->FatalError("Failed to initialize kqueue: %s", strerror(errno));
+#endif
 }
 
 Manager::~Manager() {
@@ -92,6 +106,33 @@ Manager::~Manager() {
 void Manager::InitPostScript() {
     wakeup = new WakeupHandler();
     poll_interval = BifConst::io_poll_interval_default;
+    busy_poll_idle = BifConst::io_busy_poll_idle;
+
+    iterations_metric = telemetry_mgr->CounterFamily("zeek", "iosource-loop-iterations", {},
+                                                     "Number of main loop iterations looking for ready IO sources",
+                                                     "1", true)
+                            .GetOrAdd({});
+    polls_metric = telemetry_mgr->CounterFamily("zeek", "iosource-polls", {},
+                                                "Number of times the main loop polled for ready file descriptors",
+                                                "1", true)
+                       .GetOrAdd({});
+    wait_metric = telemetry_mgr->CounterFamily<double>("zeek", "iosource-poll-wait", {},
+                                                       "Time the main loop spent waiting for ready file descriptors",
+                                                       "seconds", true)
+                      .GetOrAdd({});
+}
+
+void Manager::UpdateMetrics() {
+    if ( ! iterations_metric )
+        return;
+
+    iterations_metric->Inc(pending_iterations);
+    polls_metric->Inc(pending_polls);
+    wait_metric->Inc(pending_wait);
+
+    pending_iterations = 0;
+    pending_polls = 0;
+    pending_wait = 0.0;
 }
 
 void Manager::RemoveAll() {
@@ -126,6 +167,7 @@ void Manager::FindReadySources(ReadySources* ready) {
     IOSource* timeout_src = nullptr;
     bool time_to_poll = false;
 
+    ++pending_iterations;
     ++poll_counter;
     if ( poll_counter % poll_interval == 0 ) {
         poll_counter = 0;
@@ -154,10 +196,14 @@ void Manager::FindReadySources(ReadySources* ready) {
             }
             else if ( iosource == pkt_src ) {
                 if ( pkt_src->IsLive() ) {
-                    if ( ! time_to_poll )
-                        // Avoid calling Poll() if we can help it since on very
-                        // high-traffic networks, we spend too much time in
-                        // Poll() and end up dropping packets.
+                    // Avoid calling Poll() if we can help it since on very
+                    // high-traffic networks, we spend too much time in
+                    // Poll() and end up dropping packets. Once the source
+                    // has gone quiet for a while, though, stop spinning on
+                    // it and let Poll() wait for its fd.
+                    bool busy = busy_poll_idle <= 0.0 || ! pkt_src->HasBeenIdleFor(busy_poll_idle);
+
+                    if ( ! time_to_poll && busy )
                         ready->push_back({pkt_src, -1, 0});
                 }
             }
@@ -174,15 +220,37 @@ void Manager::FindReadySources(ReadySources* ready) {
 }
 
 void Manager::Poll(ReadySources* ready, double timeout, IOSource* timeout_src) {
+    ++pending_polls;
+
+    // A timeout of exactly zero can't block, so skip measuring it.
+    double wait_start = timeout != 0.0 ? util::current_time(true) : 0.0;
+
+#ifdef ZEEK_IOSOURCE_EPOLL
+    // epoll only deals in milliseconds. Round up, so that short timeouts
+    // don't turn into spinning.
+    int epoll_timeout = timeout < 0 ? 100 : static_cast<int>(std::min(std::ceil(timeout * 1e3), 1e9));
+    int ret = epoll_wait(event_queue, events.data(), events.size(), epoll_timeout);
+#else
     struct timespec kqueue_timeout;
     ConvertTimeout(timeout, kqueue_timeout);
 
     int ret = kevent(event_queue, NULL, 0, events.data(), events.size(), &kqueue_timeout);
+#endif
+
+    if ( wait_start > 0.0 )
+        pending_wait += util::current_time(true) - wait_start;
+
+    UpdateMetrics();
+
     if ( ret == -1 ) {
         // Ignore interrupts since we may catch one during shutdown and we don't want the
         // error to get printed.
         if ( errno != EINTR )
+#ifdef ZEEK_IOSOURCE_EPOLL
+            reporter->InternalWarning("Error calling epoll_wait: %s", strerror(errno));
+#else
             reporter->InternalWarning("Error calling kevent: %s", strerror(errno));
+#endif
     }
     else if ( ret == 0 ) {
         // If a timeout_src was provided and nothing else was ready, we timed out
@@ -191,24 +259,37 @@ void Manager::Poll(ReadySources* ready, double timeout, IOSource* timeout_src) {
             ready->push_back({timeout_src, -1, 0});
     }
     else {
-        // kevent returns the number of events that are ready, so we only need to loop
-        // over that many of them.
+        // The backend returns the number of events that are ready, so we only need
+        // to loop over that many of them.
         bool timeout_src_added = false;
         for ( int i = 0; i < ret; i++ ) {
-            if ( events[i].filter == EVFILT_READ ) {
-                std::map<int, IOSource*>::const_iterator it = fd_map.find(events[i].ident);
+#ifdef ZEEK_IOSOURCE_EPOLL
+            int fd = events[i].data.fd;
+            bool readable = events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP | EPOLLRDHUP);
+            bool writable = events[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP);
+#else
+            int fd = static_cast<int>(events[i].ident);
+            bool readable = events[i].filter == EVFILT_READ;
+            bool writable = events[i].filter == EVFILT_WRITE;
+#endif
+
+            if ( readable ) {
+                std::map<int, IOSource*>::const_iterator it = fd_map.find(fd);
                 if ( it != fd_map.end() )
-                    ready->push_back({it->second, static_cast<int>(events[i].ident), IOSource::ProcessFlags::READ});
-            }
-            else if ( events[i].filter == EVFILT_WRITE ) {
-                std::map<int, IOSource*>::const_iterator it = write_fd_map.find(events[i].ident);
-                if ( it != write_fd_map.end() )
-                    ready->push_back({it->second, static_cast<int>(events[i].ident), IOSource::ProcessFlags::WRITE});
+                    ready->push_back({it->second, fd, IOSource::ProcessFlags::READ});
             }
 
             // If we added a source that is the same as the passed timeout_src, take
             // note as to avoid adding it twice.
             timeout_src_added |= ready->size() > 0 ? ready->back().src == timeout_src : false;
+
+            if ( writable ) {
+                std::map<int, IOSource*>::const_iterator it = write_fd_map.find(fd);
+                if ( it != write_fd_map.end() )
+                    ready->push_back({it->second, fd, IOSource::ProcessFlags::WRITE});
+            }
+
+            timeout_src_added |= ready->size() > 0 ? ready->back().src == timeout_src : false;
         }
 
         // A timeout_src with a zero timeout can be considered ready.
@@ -231,87 +312,125 @@ void Manager::ConvertTimeout(double timeout, struct timespec& spec) {
     }
 }
 
-bool Manager::RegisterFd(int fd, IOSource* src, int flags) {
-    std::vector<struct kevent> new_events;
-
-    if ( (flags & IOSource::READ) != 0 ) {
-        if ( fd_map.count(fd) == 0 ) {
-            new_events.push_back({});
-            EV_SET(&(new_events.back()), fd, EVFILT_READ, EV_ADD, 0, 0, NULL);
+bool Manager::UpdateFd(int fd, int old_flags, int new_flags) {
+#ifdef ZEEK_IOSOURCE_EPOLL
+    struct epoll_event ev = {};
+    ev.data.fd = fd;
+
+    if ( (new_flags & IOSource::READ) != 0 )
+        ev.events |= EPOLLIN;
+    if ( (new_flags & IOSource::WRITE) != 0 )
+        ev.events |= EPOLLOUT;
+    if ( (new_flags & IOSource::EDGE_TRIGGERED) != 0 )
+        ev.events |= EPOLLET;
+
+    int op = EPOLL_CTL_MOD;
+    if ( old_flags == 0 )
+        op = EPOLL_CTL_ADD;
+    else if ( new_flags == 0 )
+        op = EPOLL_CTL_DEL;
+
+    return epoll_ctl(event_queue, op, fd, &ev) != -1;
+#else
+    std::vector<struct kevent> changes;
+    u_short clear = (new_flags & IOSource::EDGE_TRIGGERED) != 0 ? EV_CLEAR : 0;
+
+    auto update = [&](int flag, short filter) {
+        bool had = (old_flags & flag) != 0;
+        bool has = (new_flags & flag) != 0;
+
+        if ( has && ! had ) {
+            changes.push_back({});
+            EV_SET(&(changes.back()), fd, filter, EV_ADD | clear, 0, 0, NULL);
         }
-    }
-    if ( (flags & IOSource::WRITE) != 0 ) {
-        if ( write_fd_map.count(fd) == 0 ) {
-            new_events.push_back({});
-            EV_SET(&(new_events.back()), fd, EVFILT_WRITE, EV_ADD, 0, 0, NULL);
+        else if ( had && ! has ) {
+            changes.push_back({});
+            EV_SET(&(changes.back()), fd, filter, EV_DELETE, 0, 0, NULL);
         }
-    }
+    };
 
-    if ( ! new_events.empty() ) {
-        int ret = kevent(event_queue, new_events.data(), new_events.size(), NULL, 0, NULL);
-        if ( ret != -1 ) {
-            DBG_LOG(DBG_MAINLOOP, "Registered fd %d from %s", fd, src->Tag());
-            for ( const auto& a : new_events )
-                events.push_back({});
+    update(IOSource::READ, EVFILT_READ);
+    update(IOSource::WRITE, EVFILT_WRITE);
 
-            if ( (flags & IOSource::READ) != 0 )
-                fd_map[fd] = src;
-            if ( (flags & IOSource::WRITE) != 0 )
-                write_fd_map[fd] = src;
+    if ( changes.empty() )
+        return true;
 
-            Wakeup("RegisterFd");
-            return true;
-        }
-        else {
-            reporter->Error("Failed to register fd %d from %s: %s (flags %d)", fd, src->Tag(), strerror(errno), flags);
-            return false;
-        }
+    return kevent(event_queue, changes.data(), changes.size(), NULL, 0, NULL) != -1;
+#endif
+}
+
+bool Manager::RegisterFd(int fd, IOSource* src, int flags) {
+    auto it = fd_flags.find(fd);
+    int old_flags = it != fd_flags.end() ? it->second : 0;
+    int new_flags = old_flags;
+
+    if ( (flags & IOSource::READ) != 0 && fd_map.count(fd) == 0 )
+        new_flags |= IOSource::READ;
+    if ( (flags & IOSource::WRITE) != 0 && write_fd_map.count(fd) == 0 )
+        new_flags |= IOSource::WRITE;
+
+    if ( new_flags == old_flags )
+        return true;
+
+    new_flags |= (flags & IOSource::EDGE_TRIGGERED);
+
+    if ( ! UpdateFd(fd, old_flags, new_flags) ) {
+        reporter->Error("Failed to register fd %d from %s: %s (flags %d)", fd, src->Tag(), strerror(errno), flags);
+        return false;
     }
 
+    DBG_LOG(DBG_MAINLOOP, "Registered fd %d from %s", fd, src->Tag());
+
+    fd_flags[fd] = new_flags;
+
+    if ( (flags & IOSource::READ) != 0 )
+        fd_map[fd] = src;
+    if ( (flags & IOSource::WRITE) != 0 )
+        write_fd_map[fd] = src;
+
+    events.resize(std::max<size_t>(fd_map.size() + write_fd_map.size(), 1));
+
+    Wakeup("RegisterFd");
     return true;
 }
 
 bool Manager::UnregisterFd(int fd, IOSource* src, int flags) {
-    std::vector<struct kevent> new_events;
+    auto it = fd_flags.find(fd);
+    int old_flags = it != fd_flags.end() ? it->second : 0;
+    int new_flags = old_flags;
 
-    if ( (flags & IOSource::READ) != 0 ) {
-        if ( fd_map.count(fd) != 0 ) {
-            new_events.push_back({});
-            EV_SET(&(new_events.back()), fd, EVFILT_READ, EV_DELETE, 0, 0, NULL);
-        }
-    }
-    if ( (flags & IOSource::WRITE) != 0 ) {
-        if ( write_fd_map.count(fd) != 0 ) {
-            new_events.push_back({});
-            EV_SET(&(new_events.back()), fd, EVFILT_WRITE, EV_DELETE, 0, 0, NULL);
-        }
+    if ( (flags & IOSource::READ) != 0 && fd_map.count(fd) != 0 )
+        new_flags &= ~IOSource::READ;
+    if ( (flags & IOSource::WRITE) != 0 && write_fd_map.count(fd) != 0 )
+        new_flags &= ~IOSource::WRITE;
+
+    if ( new_flags == old_flags ) {
+        reporter->Error("Attempted to unregister an unknown file descriptor %d from %s", fd, src->Tag());
+        return false;
     }
 
-    if ( ! new_events.empty() ) {
-        int ret = kevent(event_queue, new_events.data(), new_events.size(), NULL, 0, NULL);
-        if ( ret != -1 ) {
-            DBG_LOG(DBG_MAINLOOP, "Unregistered fd %d from %s", fd, src->Tag());
-            for ( const auto& a : new_events )
-                events.pop_back();
+    if ( (new_flags & (IOSource::READ | IOSource::WRITE)) == 0 )
+        new_flags = 0;
 
-            if ( (flags & IOSource::READ) != 0 )
-                fd_map.erase(fd);
-            if ( (flags & IOSource::WRITE) != 0 )
-                write_fd_map.erase(fd);
+    // We don't care about failure here. If it failed to unregister, it's likely because
+    // the file descriptor was already closed, and the kernel already automatically removed
+    // it. Either way, it's no longer watched, so forget about it.
+    if ( UpdateFd(fd, old_flags, new_flags) )
+        DBG_LOG(DBG_MAINLOOP, "Unregistered fd %d from %s", fd, src->Tag());
 
-            Wakeup("UnregisterFd");
-            return true;
-        }
+    if ( new_flags == 0 )
+        fd_flags.erase(fd);
+    else
+        fd_flags[fd] = new_flags;
 
-        // We don't care about failure here. If it failed to unregister, it's likely because
-        // the file descriptor was already closed, and kqueue already automatically removed
-        // it.
-    }
-    else {
-        reporter->Error("Attempted to unregister an unknown file descriptor %d from %s", fd, src->Tag());
-        return false;
-    }
+    if ( (flags & IOSource::READ) != 0 )
+        fd_map.erase(fd);
+    if ( (flags & IOSource::WRITE) != 0 )
+        write_fd_map.erase(fd);
+
+    events.resize(std::max<size_t>(fd_map.size() + write_fd_map.size(), 1));
 
+    Wakeup("UnregisterFd");
     return true;
 }
 
@@ -5,14 +5,22 @@
 #include "zeek/zeek-config.h"
 
 #include <map>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include "zeek/Flare.h"
 #include "zeek/iosource/IOSource.h"
+#include "zeek/telemetry/Counter.h"
+
+// On Linux, we use epoll natively rather than kqueue through libkqueue.
+#if defined(__linux__)
+#define ZEEK_IOSOURCE_EPOLL
+#endif
 
 struct timespec;
 struct kevent;
+struct epoll_event;
 
 namespace zeek {
 namespace iosource {
@@ -163,6 +171,17 @@ private:
      */
     void ConvertTimeout(double timeout, struct timespec& spec);
 
+    /**
+     * Updates the backend's registration of an fd to the flags given,
+     * which may be zero to remove it. Returns false on error.
+     */
+    bool UpdateFd(int fd, int old_flags, int new_flags);
+
+    /**
+     * Passes accumulated loop statistics on to telemetry.
+     */
+    void UpdateMetrics();
+
     /**
      * Specialized registration method for packet sources.
      */
@@ -212,13 +231,31 @@ private:
     int poll_counter = 0;
     int poll_interval = 0; // Set in InitPostScript() based on const value.
 
+    // How long a live packet source may go without packets before we stop
+    // busy-polling it and wait for its fd instead. Zero to always poll.
+    double busy_poll_idle = 0.0;
+
     int event_queue = -1;
     std::map<int, IOSource*> fd_map;
     std::map<int, IOSource*> write_fd_map;
+    std::map<int, int> fd_flags; // The flags each fd is registered with.
 
-    // This is only used for the output of the call to kqueue in FindReadySources().
-    // The actual events are stored as part of the queue.
+    // This is only used for the output of the call to kqueue/epoll in
+    // FindReadySources(). The actual events are stored as part of the queue.
+#ifdef ZEEK_IOSOURCE_EPOLL
+    std::vector<struct epoll_event> events;
+#else
     std::vector<struct kevent> events;
+#endif
+
+    // Loop statistics not yet passed on to telemetry.
+    uint64_t pending_iterations = 0;
+    uint64_t pending_polls = 0;
+    double pending_wait = 0.0;
+
+    std::optional<telemetry::IntCounter> iterations_metric;
+    std::optional<telemetry::IntCounter> polls_metric;
+    std::optional<telemetry::DblCounter> wait_metric;
 };
 
 } // namespace iosource
@@ -12,6 +12,10 @@
 
 struct pcap_pkthdr;
 
+namespace zeek {
+struct ConnTuple;
+}
+
 namespace zeek::iosource {
 
 /**
@@ -201,6 +205,21 @@ public:
      */
     virtual bool SetFilter(int index) = 0;
 
+    /**
+     * Asks the source to stop passing on packets of the given flow, in
+     * both directions, for example by installing a rule in the capture
+     * hardware. Zeek calls this for connections where no analysis needs
+     * further packets. Sources may keep passing on packets that signal
+     * the end of the flow, such as TCP FIN/RST, but don't need to.
+     *
+     * The default implementation doesn't support shunting.
+     *
+     * @param tuple The flow, with ports in network byte order.
+     *
+     * @return True if the source will drop the flow's packets.
+     */
+    virtual bool ShuntFlow(const ConnTuple& tuple) { return false; }
+
     /**
      * Returns current statistics about the source.
      *
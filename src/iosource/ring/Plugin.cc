@@ -0,0 +1,23 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/plugin/Plugin.h"
+
+#include "zeek/iosource/Component.h"
+#include "zeek/iosource/ring/Source.h"
+
+namespace zeek::plugin::detail::Zeek_PacketRing {
+
+class Plugin : public plugin::Plugin {
+public:
+    plugin::Configuration Configure() override {
+        AddComponent(new iosource::PktSrcComponent("PacketRingReader", "ring", iosource::PktSrcComponent::LIVE,
+                                                   iosource::ring::RingSource::Instantiate));
+
+        plugin::Configuration config;
+        config.name = "Zeek::PacketRing";
+        config.description = "Packet acquisition via memory-mapped TPACKET_V3 rings";
+        return config;
+    }
+} plugin;
+
+} // namespace zeek::plugin::detail::Zeek_PacketRing
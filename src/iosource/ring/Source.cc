@@ -0,0 +1,288 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/iosource/ring/Source.h"
+
+#include "zeek/zeek-config.h"
+
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <net/if.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "zeek/ID.h"
+#include "zeek/iosource/BPF_Program.h"
+#include "zeek/iosource/Packet.h"
+#include "zeek/iosource/pcap/pcap.bif.h"
+
+namespace zeek::iosource::ring {
+
+RingSource::~RingSource() { Close(); }
+
+RingSource::RingSource(const std::string& path, bool is_live) {
+    props.path = path;
+    props.is_live = is_live;
+}
+
+void RingSource::Open() {
+    if ( ! props.is_live ) {
+        Error("ring packet sources only support live capture");
+        return;
+    }
+
+    int ifindex = if_nametoindex(props.path.c_str());
+
+    if ( ! ifindex ) {
+        Error(util::fmt("unknown interface %s", props.path.c_str()));
+        return;
+    }
+
+    fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+
+    if ( fd < 0 ) {
+        Error(util::fmt("cannot create packet socket: %s", strerror(errno)));
+        return;
+    }
+
+    if ( ! ConfigureSocket(ifindex) )
+        return;
+
+    props.selectable_fd = fd;
+    props.link_type = DLT_EN10MB;
+    props.netmask = NETMASK_UNKNOWN;
+    props.is_live = true;
+
+    Opened(props);
+}
+
+bool RingSource::ConfigureSocket(int ifindex) {
+    int version = TPACKET_V3;
+
+    if ( setsockopt(fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0 ) {
+        RingError("PACKET_VERSION");
+        return false;
+    }
+
+    // The kernel wants the block size to be a multiple of the page size,
+    // and the frame size to be a multiple of TPACKET_ALIGNMENT.  With
+    // TPACKET_V3 the frame size merely serves as an upper bound for the
+    // number of packets, as they're packed into blocks back-to-back.
+    long page_size = sysconf(_SC_PAGESIZE);
+    block_size = id::find_const("PacketRing::block_size")->AsCount() * 1024;
+    block_size = std::max<uint32_t>(block_size / page_size, 1) * page_size;
+
+    uint64_t buffer_size = id::find_const("PacketRing::buffer_size")->AsCount() * 1024 * 1024;
+    num_blocks = std::max<uint64_t>(buffer_size / block_size, 2);
+
+    uint32_t frame_size = TPACKET_ALIGN(TPACKET3_HDRLEN + BifConst::Pcap::snaplen);
+    frame_size = std::min(frame_size, block_size);
+
+    struct tpacket_req3 req = {};
+    req.tp_block_size = block_size;
+    req.tp_block_nr = num_blocks;
+    req.tp_frame_size = frame_size;
+    req.tp_frame_nr = (block_size / frame_size) * num_blocks;
+    req.tp_retire_blk_tov = std::max<uint32_t>(id::find_const("PacketRing::block_timeout")->AsInterval() * 1e3, 1);
+
+    if ( setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0 ) {
+        RingError("PACKET_RX_RING");
+        return false;
+    }
+
+    ring_size = static_cast<size_t>(block_size) * num_blocks;
+    auto m = mmap(nullptr, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+
+    if ( m == MAP_FAILED ) {
+        ring_size = 0;
+        RingError("mmap");
+        return false;
+    }
+
+    ring = static_cast<u_char*>(m);
+
+    struct sockaddr_ll sll = {};
+    sll.sll_family = AF_PACKET;
+    sll.sll_protocol = htons(ETH_P_ALL);
+    sll.sll_ifindex = ifindex;
+
+    if ( bind(fd, reinterpret_cast<struct sockaddr*>(&sll), sizeof(sll)) < 0 ) {
+        RingError("bind");
+        return false;
+    }
+
+    struct packet_mreq mreq = {};
+    mreq.mr_ifindex = ifindex;
+    mreq.mr_type = PACKET_MR_PROMISC;
+
+    if ( setsockopt(fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0 ) {
+        RingError("PACKET_ADD_MEMBERSHIP");
+        return false;
+    }
+
+    if ( auto fanout_id = id::find_const("PacketRing::fanout_id")->AsCount(); fanout_id > 0 ) {
+        // Spread flows across all sockets joining the same group.
+        int fanout = (fanout_id & 0xffff) | (PACKET_FANOUT_HASH << 16);
+
+        if ( setsockopt(fd, SOL_PACKET, PACKET_FANOUT, &fanout, sizeof(fanout)) < 0 ) {
+            RingError("PACKET_FANOUT");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void RingSource::Close() {
+    if ( fd < 0 )
+        return;
+
+    if ( ring )
+        munmap(ring, ring_size);
+
+    close(fd);
+
+    fd = -1;
+    ring = nullptr;
+    ring_size = 0;
+    cur_block = 0;
+    cur_pkt = nullptr;
+    pkts_left = 0;
+    pkt_in_flight = false;
+
+    Closed();
+}
+
+tpacket_block_desc* RingSource::Block(uint32_t i) const {
+    return reinterpret_cast<tpacket_block_desc*>(ring + static_cast<size_t>(i) * block_size);
+}
+
+bool RingSource::ExtractNextPacket(Packet* pkt) {
+    if ( ! ring )
+        return false;
+
+    // PktSrc skips DoneWithPacket() for packets it discards, so catch
+    // up here to not lose our place in the block.
+    if ( pkt_in_flight )
+        DoneWithPacket();
+
+    if ( ! pkts_left ) {
+        auto desc = Block(cur_block);
+
+        if ( ! (__atomic_load_n(&desc->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) )
+            return false;
+
+        pkts_left = desc->hdr.bh1.num_pkts;
+
+        if ( ! pkts_left ) {
+            ReleaseBlock();
+            return false;
+        }
+
+        cur_pkt = reinterpret_cast<tpacket3_hdr*>(reinterpret_cast<u_char*>(desc) + desc->hdr.bh1.offset_to_first_pkt);
+    }
+
+    auto hdr = cur_pkt;
+    pkt_timeval ts = {static_cast<time_t>(hdr->tp_sec), static_cast<suseconds_t>(hdr->tp_nsec / 1000)};
+    auto data = reinterpret_cast<const u_char*>(hdr) + hdr->tp_mac;
+
+    pkt->Init(props.link_type, &ts, hdr->tp_snaplen, hdr->tp_len, data);
+
+    // The kernel strips the outer VLAN tag and reports it separately.
+    if ( hdr->tp_status & TP_STATUS_VLAN_VALID )
+        pkt->vlan = hdr->hv1.tp_vlan_tci & 0x0fff;
+
+    pkt_in_flight = true;
+
+    ++stats.received;
+    stats.bytes_received += hdr->tp_len;
+
+    return true;
+}
+
+void RingSource::DoneWithPacket() {
+    if ( ! pkt_in_flight )
+        return;
+
+    pkt_in_flight = false;
+
+    if ( --pkts_left > 0 ) {
+        cur_pkt = reinterpret_cast<tpacket3_hdr*>(reinterpret_cast<u_char*>(cur_pkt) + cur_pkt->tp_next_offset);
+        return;
+    }
+
+    ReleaseBlock();
+}
+
+void RingSource::ReleaseBlock() {
+    // Once handed back, the kernel may overwrite the block at any time,
+    // so this must only happen once all of its packets are done.
+    auto desc = Block(cur_block);
+    __atomic_store_n(&desc->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+
+    cur_block = (cur_block + 1) % num_blocks;
+    cur_pkt = nullptr;
+    pkts_left = 0;
+}
+
+bool RingSource::SetFilter(int index) {
+    if ( fd < 0 )
+        return true; // Prevent error message
+
+    iosource::detail::BPF_Program* code = GetBPFFilter(index);
+
+    if ( ! code ) {
+        Error(util::fmt("No precompiled pcap filter for index %d", index));
+        return false;
+    }
+
+    if ( auto program = code->GetProgram() ) {
+        // struct bpf_program and struct sock_fprog share their layout.
+        struct sock_fprog fprog = {};
+        fprog.len = program->bf_len;
+        fprog.filter = reinterpret_cast<struct sock_filter*>(program->bf_insns);
+
+        if ( setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) < 0 ) {
+            Error(util::fmt("cannot attach BPF filter: %s", strerror(errno)));
+            return false;
+        }
+    }
+    else if ( code->GetState() != FilterState::OK )
+        return false;
+
+    return true;
+}
+
+void RingSource::Statistics(Stats* s) {
+    if ( fd >= 0 ) {
+        // The kernel resets its counters on each query.
+        struct tpacket_stats_v3 tp_stats = {};
+        socklen_t len = sizeof(tp_stats);
+
+        if ( getsockopt(fd, SOL_PACKET, PACKET_STATISTICS, &tp_stats, &len) == 0 ) {
+            stats.link += tp_stats.tp_packets;
+            stats.dropped += tp_stats.tp_drops;
+        }
+    }
+
+    s->link = stats.link;
+    s->dropped = stats.dropped;
+    s->received = stats.received;
+    s->bytes_received = stats.bytes_received;
+}
+
+void RingSource::RingError(const char* where) {
+    Error(util::fmt("%s: %s", where, strerror(errno)));
+    Close();
+}
+
+iosource::PktSrc* RingSource::Instantiate(const std::string& path, bool is_live) {
+    return new RingSource(path, is_live);
+}
+
+} // namespace zeek::iosource::ring
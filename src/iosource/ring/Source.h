@@ -0,0 +1,66 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+// A packet source reading from a memory-mapped TPACKET_V3 receive ring.
+// The kernel fills the ring in blocks of packets; we hand out Packets
+// that point directly into a block and give the block back to the
+// kernel once its last packet has been processed, so no packet data
+// gets copied on the way into Zeek.
+//
+// Usage: zeek -i ring::eth0
+
+#pragma once
+
+#include <cstdint>
+
+#include "zeek/iosource/PktSrc.h"
+
+struct tpacket_block_desc;
+struct tpacket3_hdr;
+
+namespace zeek::iosource::ring {
+
+class RingSource : public PktSrc {
+public:
+    RingSource(const std::string& path, bool is_live);
+    ~RingSource() override;
+
+    static PktSrc* Instantiate(const std::string& path, bool is_live);
+
+protected:
+    // PktSrc interface.
+    void Open() override;
+    void Close() override;
+    bool ExtractNextPacket(Packet* pkt) override;
+    void DoneWithPacket() override;
+    bool SetFilter(int index) override;
+    void Statistics(Stats* stats) override;
+
+private:
+    bool ConfigureSocket(int ifindex);
+    tpacket_block_desc* Block(uint32_t i) const;
+    void ReleaseBlock();
+    void RingError(const char* where);
+
+    Properties props;
+    Stats stats;
+
+    int fd = -1;
+
+    u_char* ring = nullptr;
+    size_t ring_size = 0;
+    uint32_t block_size = 0;
+    uint32_t num_blocks = 0;
+
+    // Position within the ring.  "pkts_left" counts the packets of the
+    // current block that haven't been passed on yet, including the one
+    // "cur_pkt" refers to.
+    uint32_t cur_block = 0;
+    tpacket3_hdr* cur_pkt = nullptr;
+    uint32_t pkts_left = 0;
+
+    // True if we've returned a packet for which DoneWithPacket() hasn't
+    // been called yet.
+    bool pkt_in_flight = false;
+};
+
+} // namespace zeek::iosource::ring
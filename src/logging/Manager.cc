@@ -3,6 +3,7 @@
 #include "zeek/logging/Manager.h"
 
 #include <broker/endpoint_info.hh>
+#include <algorithm>
 #include <functional>
 #include <optional>
 #include <utility>
@@ -16,6 +17,7 @@
 #include "zeek/NetVar.h"
 #include "zeek/OpaqueVal.h"
 #include "zeek/RunState.h"
+#include "zeek/SubsystemStats.h"
 #include "zeek/Type.h"
 #include "zeek/broker/Manager.h"
 #include "zeek/input.h"
@@ -933,6 +935,8 @@ bool Manager::Write(EnumVal* id, RecordVal* columns_arg) {
     if ( ! stream->enabled )
         return true;
 
+    zeek::detail::SubsystemScope scope(zeek::detail::Subsystem::Log, stream->name.c_str());
+
     auto columns = columns_arg->CoerceTo({NewRef{}, stream->columns});
 
     if ( ! columns ) {
@@ -1578,6 +1582,10 @@ bool Manager::CreateWriterForRemoteLog(EnumVal* id, EnumVal* writer, WriterBacke
     return CreateWriter(id, writer, info, num_fields, fields, true, false, true);
 }
 
+// Upper bound for the number of shards of a writer, to keep a stray
+// Log::shards entry from spawning an excessive number of threads.
+static constexpr zeek_uint_t MAX_SHARDS = 64;
+
 static void delete_info_and_fields(WriterBackend::WriterInfo* info, int num_fields,
                                    const threading::Field* const* fields) {
     for ( int i = 0; i < num_fields; i++ )
@@ -1675,7 +1683,20 @@ WriterFrontend* Manager::CreateWriter(EnumVal* id, EnumVal* writer, WriterBacken
     winfo->info->rotation_interval = winfo->interval;
     winfo->info->rotation_base = util::detail::parse_rotate_base_time(base_time);
 
-    winfo->writer = new WriterFrontend(*winfo->info, id, writer, local, remote);
+    // Spread the stream's writes across several backends if so configured.
+    static auto log_shards = id::find_val<TableVal>("Log::shards");
+    static auto log_shard_by = id::find_val<TableVal>("Log::shard_by");
+
+    int num_shards = 1;
+    std::string shard_by;
+
+    if ( auto n = log_shards->FindOrDefault({NewRef{}, id}) )
+        num_shards = std::clamp<zeek_uint_t>(n->AsCount(), 1, MAX_SHARDS);
+
+    if ( auto f = log_shard_by->FindOrDefault({NewRef{}, id}) )
+        shard_by = f->AsStringVal()->ToStdString();
+
+    winfo->writer = new WriterFrontend(*winfo->info, id, writer, local, remote, num_shards, std::move(shard_by));
     winfo->writer->Init(num_fields, fields);
 
     if ( ! from_remote ) {
@@ -1983,16 +2004,21 @@ void Manager::Rotate(WriterInfo* winfo) {
     else
         ppf = default_ppf;
 
-    auto rotation_path = FormatRotationPath({NewRef{}, winfo->type}, winfo->writer->Info().path, winfo->open_time,
-                                            run_state::network_time, run_state::terminating, std::move(ppf));
+    // Each shard of a sharded writer rotates its own output, named after
+    // the shard's path.
+    for ( int i = 0; i < winfo->writer->NumShards(); ++i ) {
+        auto rotation_path = FormatRotationPath({NewRef{}, winfo->type}, winfo->writer->ShardPath(i), winfo->open_time,
+                                                run_state::network_time, run_state::terminating, ppf);
 
-    winfo->writer->Rotate(rotation_path.data(), winfo->open_time, run_state::network_time, run_state::terminating);
+        winfo->writer->Rotate(rotation_path.data(), winfo->open_time, run_state::network_time, run_state::terminating,
+                              i);
 
-    ++rotations_pending;
+        ++rotations_pending;
+    }
 }
 
 bool Manager::FinishedRotation(WriterFrontend* writer, const char* new_name, const char* old_name, double open,
-                               double close, bool success, bool terminating) {
+                               double close, bool success, bool terminating, int shard) {
     assert(writer);
 
     --rotations_pending;
@@ -2013,10 +2039,11 @@ bool Manager::FinishedRotation(WriterFrontend* writer, const char* new_name, con
     auto info = make_intrusive<RecordVal>(BifType::Record::Log::RotationInfo);
     info->Assign(0, {NewRef{}, winfo->type});
     info->Assign(1, new_name);
-    info->Assign(2, winfo->writer->Info().path);
+    info->Assign(2, winfo->writer->ShardPath(shard));
     info->AssignTime(3, open);
     info->AssignTime(4, close);
     info->Assign(5, terminating);
+    info->Assign(6, val_mgr->Count(shard));
 
     static auto default_ppf = id::find_func("Log::__default_rotation_postprocessor");
 
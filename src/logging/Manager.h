@@ -361,9 +361,10 @@ protected:
                                  const threading::Field* const* fields, bool local, bool remote, bool from_remote,
                                  const std::string& instantiating_filter = "");
 
-    // Signals that a file has been rotated.
+    // Signals that a file has been rotated. For sharded writers, shard
+    // is the index of the rotated backend.
     bool FinishedRotation(WriterFrontend* writer, const char* new_name, const char* old_name, double open, double close,
-                          bool success, bool terminating);
+                          bool success, bool terminating, int shard = 0);
 
     // Deletes the values as passed into Write().
     void DeleteVals(int num_fields, threading::Value** vals);
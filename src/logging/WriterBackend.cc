@@ -19,14 +19,15 @@ namespace zeek::logging {
 class RotationFinishedMessage final : public threading::OutputMessage<WriterFrontend> {
 public:
     RotationFinishedMessage(WriterFrontend* writer, const char* new_name, const char* old_name, double open,
-                            double close, bool success, bool terminating)
+                            double close, bool success, bool terminating, int shard)
         : threading::OutputMessage<WriterFrontend>("RotationFinished", writer),
           new_name(util::copy_string(new_name)),
           old_name(util::copy_string(old_name)),
           open(open),
           close(close),
           success(success),
-          terminating(terminating) {}
+          terminating(terminating),
+          shard(shard) {}
 
     ~RotationFinishedMessage() override {
         delete[] new_name;
@@ -34,7 +35,7 @@ public:
     }
 
     bool Process() override {
-        return log_mgr->FinishedRotation(Object(), new_name, old_name, open, close, success, terminating);
+        return log_mgr->FinishedRotation(Object(), new_name, old_name, open, close, success, terminating, shard);
     }
 
 private:
@@ -44,6 +45,7 @@ private:
     double close;
     bool success;
     bool terminating;
+    int shard;
 };
 
 class FlushWriteBufferMessage final : public threading::OutputMessage<WriterFrontend> {
@@ -123,6 +125,7 @@ WriterBackend::WriterBackend(WriterFrontend* arg_frontend) : MsgThread() {
     frontend = arg_frontend;
     info = new WriterInfo(frontend->Info());
     rotation_counter = 0;
+    shard = 0;
 
     SetName(frontend->Name());
 }
@@ -153,18 +156,29 @@ void WriterBackend::DeleteVals(int num_writes, Value*** vals) {
 bool WriterBackend::FinishedRotation(const char* new_name, const char* old_name, double open, double close,
                                      bool terminating) {
     --rotation_counter;
-    SendOut(new RotationFinishedMessage(frontend, new_name, old_name, open, close, true, terminating));
+    SendOut(new RotationFinishedMessage(frontend, new_name, old_name, open, close, true, terminating, shard));
     return true;
 }
 
 bool WriterBackend::FinishedRotation() {
     --rotation_counter;
-    SendOut(new RotationFinishedMessage(frontend, nullptr, nullptr, 0, 0, false, false));
+    SendOut(new RotationFinishedMessage(frontend, nullptr, nullptr, 0, 0, false, false, shard));
     return true;
 }
 
 void WriterBackend::DisableFrontend() { SendOut(new DisableMessage(frontend)); }
 
+void WriterBackend::SetShard(int arg_shard, const char* path) {
+    shard = arg_shard;
+
+    auto new_info = new WriterInfo(*info);
+    delete[] new_info->path;
+    new_info->path = util::copy_string(path);
+
+    delete info;
+    info = new_info;
+}
+
 bool WriterBackend::Init(int arg_num_fields, const Field* const* arg_fields) {
     SetOSName(Fmt("zk.%s", Name()));
     num_fields = arg_num_fields;
@@ -190,6 +190,16 @@ public:
      */
     void DisableFrontend();
 
+    /**
+     * Marks the backend as one shard of a sharded writer, writing to its
+     * own path rather than the one from the frontend's writer information.
+     * Rotations get reported with the shard's index.
+     *
+     * This method must only be called from the main thread, before the
+     * backend has been started.
+     */
+    void SetShard(int shard, const char* path);
+
     /**
      * Returns the additional writer information passed into the constructor.
      */
@@ -385,6 +395,7 @@ private:
     bool buffering;                        // True if buffering is enabled.
 
     int rotation_counter; // Tracks FinishedRotation() calls.
+    int shard;            // Index among the backends of a sharded writer.
 };
 
 } // namespace zeek::logging
@@ -1,5 +1,8 @@
 #include "zeek/logging/WriterFrontend.h"
 
+#include <functional>
+#include <string_view>
+
 #include "zeek/RunState.h"
 #include "zeek/broker/Manager.h"
 #include "zeek/logging/Manager.h"
@@ -11,6 +14,68 @@ using zeek::threading::Value;
 
 namespace zeek::logging {
 
+namespace {
+
+size_t hash_addr(const Value::addr_t& addr) {
+    if ( addr.family == IPv4 )
+        return std::hash<uint32_t>{}(addr.in.in4.s_addr);
+
+    return std::hash<std::string_view>{}(std::string_view(reinterpret_cast<const char*>(&addr.in.in6), 16));
+}
+
+// Hashes a log value for selecting its shard, such that equal values
+// end up with the same hash.
+size_t hash_value(const Value* v) {
+    if ( ! v->present )
+        return 0;
+
+    switch ( v->type ) {
+        case TYPE_STRING:
+        case TYPE_FILE:
+        case TYPE_FUNC:
+            return std::hash<std::string_view>{}(std::string_view(v->val.string_val.data, v->val.string_val.length));
+
+        case TYPE_ADDR: return hash_addr(v->val.addr_val);
+
+        case TYPE_SUBNET: return hash_addr(v->val.subnet_val.prefix) * 31 + v->val.subnet_val.length;
+
+        case TYPE_PORT: return std::hash<zeek_uint_t>{}(v->val.port_val.port);
+
+        case TYPE_DOUBLE:
+        case TYPE_TIME:
+        case TYPE_INTERVAL: return std::hash<double>{}(v->val.double_val);
+
+        case TYPE_BOOL:
+        case TYPE_INT:
+        case TYPE_COUNT:
+        case TYPE_ENUM: return std::hash<zeek_uint_t>{}(v->val.uint_val);
+
+        case TYPE_TABLE: {
+            // The order of a set's elements isn't defined, so combine
+            // their hashes in a way that doesn't depend on it.
+            size_t h = v->val.set_val.size;
+
+            for ( zeek_int_t i = 0; i < v->val.set_val.size; ++i )
+                h += hash_value(v->val.set_val.vals[i]);
+
+            return h;
+        }
+
+        case TYPE_VECTOR: {
+            size_t h = v->val.vector_val.size;
+
+            for ( zeek_int_t i = 0; i < v->val.vector_val.size; ++i )
+                h = h * 31 + hash_value(v->val.vector_val.vals[i]);
+
+            return h;
+        }
+
+        default: return 0;
+    }
+}
+
+} // namespace
+
 // Messages sent from frontend to backend (i.e., "InputMessages").
 
 class InitMessage final : public threading::InputMessage<WriterBackend> {
@@ -89,7 +154,7 @@ private:
 // Frontend methods.
 
 WriterFrontend::WriterFrontend(const WriterBackend::WriterInfo& arg_info, EnumVal* arg_stream, EnumVal* arg_writer,
-                               bool arg_local, bool arg_remote) {
+                               bool arg_local, bool arg_remote, int num_shards, std::string arg_shard_by) {
     stream = arg_stream;
     writer = arg_writer;
     Ref(stream);
@@ -99,9 +164,10 @@ WriterFrontend::WriterFrontend(const WriterBackend::WriterInfo& arg_info, EnumVa
     buf = true;
     local = arg_local;
     remote = arg_remote;
-    write_buffer = nullptr;
-    write_buffer_pos = 0;
     info = new WriterBackend::WriterInfo(arg_info);
+    shard_by = std::move(arg_shard_by);
+    shard_field = -1;
+    next_shard = 0;
 
     num_fields = 0;
     fields = nullptr;
@@ -109,15 +175,27 @@ WriterFrontend::WriterFrontend(const WriterBackend::WriterInfo& arg_info, EnumVa
     const char* w = arg_writer->GetType()->AsEnumType()->Lookup(arg_writer->InternalInt());
     name = util::copy_string(util::fmt("%s/%s", arg_info.path, w));
 
-    if ( local ) {
-        backend = log_mgr->CreateBackend(this, writer);
+    if ( ! local || num_shards < 1 )
+        num_shards = 1;
 
-        if ( backend )
-            backend->Start();
-    }
+    shards.resize(num_shards);
 
-    else
-        backend = nullptr;
+    for ( int i = 0; i < num_shards; ++i ) {
+        auto& s = shards[i];
+        s.path = num_shards > 1 ? util::fmt("%s.shard%d", arg_info.path, i) : arg_info.path;
+
+        if ( ! local )
+            continue;
+
+        s.backend = log_mgr->CreateBackend(this, writer);
+
+        if ( s.backend ) {
+            if ( num_shards > 1 )
+                s.backend->SetShard(i, s.path.c_str());
+
+            s.backend->Start();
+        }
+    }
 }
 
 WriterFrontend::~WriterFrontend() {
@@ -136,9 +214,11 @@ void WriterFrontend::Stop() {
     FlushWriteBuffer();
     SetDisable();
 
-    if ( backend ) {
-        backend->SignalStop();
-        backend = nullptr; // Thread manager will clean it up once it finishes.
+    for ( auto& s : shards ) {
+        if ( s.backend ) {
+            s.backend->SignalStop();
+            s.backend = nullptr; // Thread manager will clean it up once it finishes.
+        }
     }
 }
 
@@ -154,13 +234,29 @@ void WriterFrontend::Init(int arg_num_fields, const Field* const* arg_fields) {
 
     initialized = true;
 
-    if ( backend ) {
+    if ( shards.size() > 1 && ! shard_by.empty() ) {
+        for ( int i = 0; i < num_fields; ++i ) {
+            if ( shard_by == fields[i]->name ) {
+                shard_field = i;
+                break;
+            }
+        }
+
+        if ( shard_field < 0 )
+            reporter->Warning("unknown field '%s' to shard %s by, distributing writes round-robin", shard_by.c_str(),
+                              name);
+    }
+
+    for ( auto& s : shards ) {
+        if ( ! s.backend )
+            continue;
+
         auto fs = new Field*[num_fields];
 
         for ( auto i = 0; i < num_fields; ++i )
             fs[i] = new Field(*fields[i]);
 
-        backend->SendIn(new InitMessage(backend, arg_num_fields, fs));
+        s.backend->SendIn(new InitMessage(s.backend, arg_num_fields, fs));
     }
 
     if ( remote ) {
@@ -168,6 +264,16 @@ void WriterFrontend::Init(int arg_num_fields, const Field* const* arg_fields) {
     }
 }
 
+int WriterFrontend::SelectShard(Value** vals) {
+    if ( shards.size() == 1 )
+        return 0;
+
+    if ( shard_field < 0 )
+        return next_shard++ % shards.size();
+
+    return hash_value(vals[shard_field]) % shards.size();
+}
+
 void WriterFrontend::Write(int arg_num_fields, Value** vals) {
     if ( disabled ) {
         DeleteVals(arg_num_fields, vals);
@@ -185,35 +291,45 @@ void WriterFrontend::Write(int arg_num_fields, Value** vals) {
         broker_mgr->PublishLogWrite(stream, writer, info->path, num_fields, vals);
     }
 
-    if ( ! backend ) {
+    int shard = SelectShard(vals);
+    auto& s = shards[shard];
+
+    if ( ! s.backend ) {
         DeleteVals(arg_num_fields, vals);
         return;
     }
 
-    if ( ! write_buffer ) {
+    if ( ! s.write_buffer ) {
         // Need new buffer.
-        write_buffer = new Value**[WRITER_BUFFER_SIZE];
-        write_buffer_pos = 0;
+        s.write_buffer = new Value**[WRITER_BUFFER_SIZE];
+        s.write_buffer_pos = 0;
     }
 
-    write_buffer[write_buffer_pos++] = vals;
+    s.write_buffer[s.write_buffer_pos++] = vals;
 
-    if ( write_buffer_pos >= WRITER_BUFFER_SIZE || ! buf || run_state::terminating )
+    if ( s.write_buffer_pos >= WRITER_BUFFER_SIZE || ! buf || run_state::terminating )
         // Buffer full (or no buffering desired or terminating).
-        FlushWriteBuffer();
+        FlushWriteBuffer(shard);
 }
 
 void WriterFrontend::FlushWriteBuffer() {
-    if ( ! write_buffer_pos )
+    for ( size_t i = 0; i < shards.size(); ++i )
+        FlushWriteBuffer(i);
+}
+
+void WriterFrontend::FlushWriteBuffer(int shard) {
+    auto& s = shards[shard];
+
+    if ( ! s.write_buffer_pos )
         // Nothing to do.
         return;
 
-    if ( backend )
-        backend->SendIn(new WriteMessage(backend, num_fields, write_buffer_pos, write_buffer));
+    if ( s.backend )
+        s.backend->SendIn(new WriteMessage(s.backend, num_fields, s.write_buffer_pos, s.write_buffer));
 
     // Clear buffer (no delete, we pass ownership to child thread.)
-    write_buffer = nullptr;
-    write_buffer_pos = 0;
+    s.write_buffer = nullptr;
+    s.write_buffer_pos = 0;
 }
 
 void WriterFrontend::SetBuf(bool enabled) {
@@ -222,8 +338,10 @@ void WriterFrontend::SetBuf(bool enabled) {
 
     buf = enabled;
 
-    if ( backend )
-        backend->SendIn(new SetBufMessage(backend, enabled));
+    for ( auto& s : shards ) {
+        if ( s.backend )
+            s.backend->SendIn(new SetBufMessage(s.backend, enabled));
+    }
 
     if ( ! buf )
         // Make sure no longer buffer any still queued data.
@@ -236,21 +354,25 @@ void WriterFrontend::Flush(double network_time) {
 
     FlushWriteBuffer();
 
-    if ( backend )
-        backend->SendIn(new FlushMessage(backend, network_time));
+    for ( auto& s : shards ) {
+        if ( s.backend )
+            s.backend->SendIn(new FlushMessage(s.backend, network_time));
+    }
 }
 
-void WriterFrontend::Rotate(const char* rotated_path, double open, double close, bool terminating) {
+void WriterFrontend::Rotate(const char* rotated_path, double open, double close, bool terminating, int shard) {
     if ( disabled )
         return;
 
-    FlushWriteBuffer();
+    FlushWriteBuffer(shard);
+
+    auto backend = shards[shard].backend;
 
     if ( backend )
         backend->SendIn(new RotateMessage(backend, this, rotated_path, open, close, terminating));
     else
         // Still signal log manager that we're done.
-        log_mgr->FinishedRotation(this, nullptr, nullptr, 0, 0, false, terminating);
+        log_mgr->FinishedRotation(this, nullptr, nullptr, 0, 0, false, terminating, shard);
 }
 
 void WriterFrontend::DeleteVals(int num_fields, Value** vals) {
@@ -2,6 +2,9 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include "zeek/logging/WriterBackend.h"
 
 namespace zeek::logging {
@@ -36,9 +39,18 @@ public:
      * remote: If true, the writer will forward logs to remote
      * clients.
      *
+     * num_shards: The number of backends to spread local writes across.
+     * With more than one, each backend writes to its own path, see
+     * ShardPath().
+     *
+     * shard_by: If non-empty, the name of the field whose value selects
+     * the backend for a write, so that writes with the same value end up
+     * in the same output. Otherwise writes are distributed round-robin.
+     *
      * Frontends must only be instantiated by the main thread.
      */
-    WriterFrontend(const WriterBackend::WriterInfo& info, EnumVal* stream, EnumVal* writer, bool local, bool remote);
+    WriterFrontend(const WriterBackend::WriterInfo& info, EnumVal* stream, EnumVal* writer, bool local, bool remote,
+                   int num_shards = 1, std::string shard_by = "");
 
     /**
      * Destructor.
@@ -126,11 +138,13 @@ public:
      * the corresponding message there. If the backend method fails, it
      * sends a message back that will asynchronously call Disable().
      *
-     * See WriterBackend::Rotate() for arguments.
+     * See WriterBackend::Rotate() for arguments. For sharded writers,
+     * \a shard selects the backend to rotate; each one reports its
+     * completion separately.
      *
      * This method must only be called from the main thread.
      */
-    void Rotate(const char* rotated_path, double open, double close, bool terminating);
+    void Rotate(const char* rotated_path, double open, double close, bool terminating, int shard = 0);
 
     /**
      * Explicitly triggers a transfer of all potentially buffered Write()
@@ -182,30 +196,53 @@ public:
      */
     const threading::Field* const* Fields() const { return fields; }
 
+    /**
+     * Returns the number of backends that writes are spread across.
+     */
+    int NumShards() const { return static_cast<int>(shards.size()); }
+
+    /**
+     * Returns the path that the given shard's backend writes to. That's
+     * the writer's path if there's just a single shard, and the path
+     * with ".shard<N>" appended otherwise.
+     */
+    const char* ShardPath(int shard) const { return shards[shard].path.c_str(); }
+
 protected:
     friend class Manager;
 
     void DeleteVals(int num_fields, threading::Value** vals);
+    void FlushWriteBuffer(int shard);
+    int SelectShard(threading::Value** vals);
+
+    // Buffer for bulk writes.
+    static const int WRITER_BUFFER_SIZE = 1000;
+
+    // A backend along with the writes buffered for it.
+    struct Shard {
+        WriterBackend* backend = nullptr;           // The backend we have instantiated.
+        std::string path;                           // The path the backend writes to.
+        int write_buffer_pos = 0;                   // Position of next write in buffer.
+        threading::Value*** write_buffer = nullptr; // Buffer of size WRITER_BUFFER_SIZE.
+    };
 
     EnumVal* stream;
     EnumVal* writer;
 
-    WriterBackend* backend; // The backend we have instantiated.
-    bool disabled;          // True if disabled.
-    bool initialized;       // True if initialized.
-    bool buf;               // True if buffering is enabled (default).
-    bool local;             // True if logging locally.
-    bool remote;            // True if logging remotely.
+    std::vector<Shard> shards; // Always at least one.
+    std::string shard_by;      // Field selecting the shard, if any.
+    int shard_field;           // Index of the shard_by field, or -1.
+    unsigned int next_shard;   // Next shard for round-robin distribution.
+    bool disabled;             // True if disabled.
+    bool initialized;          // True if initialized.
+    bool buf;                  // True if buffering is enabled (default).
+    bool local;                // True if logging locally.
+    bool remote;               // True if logging remotely.
 
     const char* name;                      // Descriptive name of the
     WriterBackend::WriterInfo* info;       // The writer information.
     int num_fields;                        // The number of log fields.
     const threading::Field* const* fields; // The log fields.
-
-    // Buffer for bulk writes.
-    static const int WRITER_BUFFER_SIZE = 1000;
-    int write_buffer_pos;             // Position of next write in buffer.
-    threading::Value*** write_buffer; // Buffer of size WRITER_BUFFER_SIZE.
 };
 
 } // namespace zeek::logging
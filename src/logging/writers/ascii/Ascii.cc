@@ -20,6 +20,7 @@
 #include "zeek/RunState.h"
 #include "zeek/logging/Manager.h"
 #include "zeek/logging/writers/ascii/ascii.bif.h"
+#include "zeek/telemetry/Manager.h"
 #include "zeek/threading/SerialTypes.h"
 #include "zeek/util.h"
 
@@ -208,9 +209,28 @@ Ascii::Ascii(WriterFrontend* frontend) : WriterBackend(frontend) {
     formatter = nullptr;
     gzip_level = 0;
     gzfile = nullptr;
+    compression_threads = 0;
+    async_io = false;
 
     InitConfigOptions();
     init_options = InitFilterOptions();
+
+    if ( init_options && UseBlockOutput() ) {
+        // Set up the telemetry here, as we're still running in the main thread.
+        auto bytes_in_family =
+            telemetry_mgr->CounterFamily("zeek", "log-ascii-uncompressed", {"path"},
+                                         "Bytes passed to the ASCII writer's block output", "bytes", true);
+        auto bytes_out_family = telemetry_mgr->CounterFamily(
+            "zeek", "log-ascii-written", {"path"}, "Bytes written to disk by the ASCII writer's block output", "bytes",
+            true);
+        auto pending_family = telemetry_mgr->GaugeFamily("zeek", "log-ascii-pending-blocks", {"path"},
+                                                         "Blocks queued for compression or writing");
+
+        std::initializer_list<telemetry::LabelView> labels{{"path", Info().path}};
+        block_output_metrics.emplace(BlockOutputMetrics{bytes_in_family.GetOrAdd(labels),
+                                                        bytes_out_family.GetOrAdd(labels),
+                                                        pending_family.GetOrAdd(labels)});
+    }
 }
 
 void Ascii::InitConfigOptions() {
@@ -219,6 +239,8 @@ void Ascii::InitConfigOptions() {
     use_json = BifConst::LogAscii::use_json;
     enable_utf_8 = BifConst::LogAscii::enable_utf_8;
     gzip_level = BifConst::LogAscii::gzip_level;
+    compression_threads = BifConst::LogAscii::compression_threads;
+    async_io = BifConst::LogAscii::async_io;
 
     separator.assign((const char*)BifConst::LogAscii::separator->Bytes(), BifConst::LogAscii::separator->Len());
 
@@ -482,18 +504,29 @@ bool Ascii::DoInit(const WriterInfo& info, int num_fields, const threading::Fiel
             return false;
         }
 
-        char mode[4];
-        snprintf(mode, sizeof(mode), "wb%d", gzip_level);
-        errno = 0; // errno will only be set under certain circumstances by gzdopen.
-        gzfile = gzdopen(fd, mode);
+        if ( UseBlockOutput() ) {
+            gzfile = nullptr;
+            block_output = std::make_unique<BlockOutput>(fd, gzip_level, compression_threads,
+                                                         block_output_metrics ? &*block_output_metrics : nullptr);
+        }
+        else {
+            char mode[4];
+            snprintf(mode, sizeof(mode), "wb%d", gzip_level);
+            errno = 0; // errno will only be set under certain circumstances by gzdopen.
+            gzfile = gzdopen(fd, mode);
 
-        if ( gzfile == nullptr ) {
-            Error(Fmt("cannot gzip %s: %s", fname.c_str(), Strerror(errno)));
-            return false;
+            if ( gzfile == nullptr ) {
+                Error(Fmt("cannot gzip %s: %s", fname.c_str(), Strerror(errno)));
+                return false;
+            }
         }
     }
     else {
         gzfile = nullptr;
+
+        if ( UseBlockOutput() )
+            block_output = std::make_unique<BlockOutput>(fd, 0, compression_threads,
+                                                         block_output_metrics ? &*block_output_metrics : nullptr);
     }
 
     if ( ! WriteHeader(path) ) {
@@ -549,7 +582,16 @@ bool Ascii::WriteHeader(const string& path) {
 }
 
 bool Ascii::DoFlush(double network_time) {
-    fsync(fd);
+    // With block output, a flush only hands off what's buffered, rather
+    // than waiting for the pool: the blocks get written in order anyway.
+    if ( block_output ) {
+        if ( ! block_output->Flush() )
+            Error(Fmt("error writing to %s: %s", fname.c_str(), Strerror(block_output->Errno())));
+
+        return true;
+    }
+
+    Sync();
     return true;
 }
 
@@ -598,7 +640,7 @@ bool Ascii::DoWrite(int num_fields, const threading::Field* const* fields, threa
         goto write_error;
 
     if ( ! IsBuf() )
-        fsync(fd);
+        Sync();
 
     return true;
 
@@ -812,7 +854,29 @@ string Ascii::Timestamp(double t) {
     return tmp;
 }
 
+bool Ascii::UseBlockOutput() {
+    if ( output_to_stdout || IsSpecial(Info().path) )
+        return false;
+
+    return async_io || (gzip_level > 0 && compression_threads > 0);
+}
+
+void Ascii::Sync() {
+    if ( block_output && ! block_output->Drain() )
+        Error(Fmt("error writing to %s: %s", fname.c_str(), Strerror(block_output->Errno())));
+
+    fsync(fd);
+}
+
 bool Ascii::InternalWrite(int fd, const char* data, int len) {
+    if ( block_output ) {
+        if ( block_output->Write(data, len) )
+            return true;
+
+        errno = block_output->Errno();
+        return false;
+    }
+
     if ( ! gzfile )
         return util::safe_write(fd, data, len);
 
@@ -833,6 +897,20 @@ bool Ascii::InternalWrite(int fd, const char* data, int len) {
 }
 
 bool Ascii::InternalClose(int fd) {
+    if ( block_output ) {
+        bool ok = block_output->Finish();
+        int err = block_output->Errno();
+        block_output.reset();
+        util::safe_close(fd);
+
+        if ( ! ok ) {
+            Error(Fmt("Ascii::InternalClose write error: %s\n", Strerror(err)));
+            return false;
+        }
+
+        return true;
+    }
+
     if ( ! gzfile ) {
         util::safe_close(fd);
         return true;
@@ -5,9 +5,12 @@
 #pragma once
 
 #include <zlib.h>
+#include <memory>
+#include <optional>
 
 #include "zeek/Desc.h"
 #include "zeek/logging/WriterBackend.h"
+#include "zeek/logging/writers/ascii/BlockOutput.h"
 #include "zeek/threading/formatters/Ascii.h"
 #include "zeek/threading/formatters/JSON.h"
 
@@ -50,9 +53,13 @@ private:
     bool InitFormatter();
     bool InternalWrite(int fd, const char* data, int len);
     bool InternalClose(int fd);
+    bool UseBlockOutput();
+    void Sync();
 
     int fd;
     gzFile gzfile;
+    std::unique_ptr<BlockOutput> block_output;
+    std::optional<BlockOutputMetrics> block_output_metrics;
     std::string fname;
     ODesc desc;
     bool ascii_done;
@@ -70,6 +77,8 @@ private:
 
     int gzip_level; // level > 0 enables gzip compression
     std::string gzip_file_extension;
+    int compression_threads;
+    bool async_io;
     bool use_json;
     bool enable_utf_8;
     std::string json_timestamps;
@@ -0,0 +1,220 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/logging/writers/ascii/BlockOutput.h"
+
+#include <zlib.h>
+#include <algorithm>
+#include <cerrno>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "zeek/util.h"
+
+namespace zeek::logging::writer::detail {
+
+namespace {
+
+// The threads compressing and writing blocks, shared by all writers. They
+// get created from within a writer thread, so they inherit its blocked
+// signals. At exit, they finish any jobs still queued and get joined.
+class BlockPool {
+public:
+    explicit BlockPool(int num_threads) {
+        for ( int i = 0; i < num_threads; ++i ) {
+            threads.emplace_back(&BlockPool::Run, this);
+            util::detail::set_thread_name("zk.ascii-block", threads.back().native_handle());
+        }
+    }
+
+    ~BlockPool() {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stop = true;
+        }
+
+        cv.notify_all();
+
+        for ( auto& t : threads )
+            t.join();
+    }
+
+    void Submit(std::function<void()> job) {
+        std::lock_guard<std::mutex> lock(mtx);
+        jobs.push_back(std::move(job));
+        cv.notify_one();
+    }
+
+private:
+    void Run() {
+        while ( true ) {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this] { return stop || ! jobs.empty(); });
+
+            if ( jobs.empty() )
+                return;
+
+            auto job = std::move(jobs.front());
+            jobs.pop_front();
+            lock.unlock();
+
+            job();
+        }
+    }
+
+    std::vector<std::thread> threads;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> jobs;
+    bool stop = false;
+};
+
+BlockPool& block_pool(int num_threads) {
+    static BlockPool pool(std::max(num_threads, 1));
+    return pool;
+}
+
+} // namespace
+
+BlockOutput::BlockOutput(int fd, int gzip_level, int num_threads, BlockOutputMetrics* metrics)
+    : fd(fd), gzip_level(gzip_level), num_threads(num_threads), metrics(metrics) {
+    cur.reserve(BLOCK_SIZE);
+}
+
+BlockOutput::~BlockOutput() { Drain(); }
+
+bool BlockOutput::Write(const char* data, size_t len) {
+    if ( metrics )
+        metrics->bytes_in.Inc(len);
+
+    cur.append(data, len);
+
+    if ( cur.size() >= BLOCK_SIZE )
+        Seal();
+
+    return Errno() == 0;
+}
+
+bool BlockOutput::Flush() {
+    Seal();
+    return Errno() == 0;
+}
+
+bool BlockOutput::Drain() {
+    Seal();
+
+    std::unique_lock<std::mutex> lock(mtx);
+    cv.wait(lock, [this] { return pending.empty() && ! writing; });
+
+    return Errno() == 0;
+}
+
+bool BlockOutput::Finish() {
+    if ( gzip_level > 0 && ! any_output && cur.empty() )
+        Seal(true);
+
+    return Drain();
+}
+
+int BlockOutput::Errno() { return error.load(std::memory_order_relaxed); }
+
+void BlockOutput::Seal(bool force) {
+    if ( cur.empty() && ! force )
+        return;
+
+    auto b = std::make_unique<Block>();
+    b->data.swap(cur);
+    cur.reserve(BLOCK_SIZE);
+
+    auto bp = b.get();
+
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [this] { return pending.size() < MAX_PENDING_BLOCKS; });
+        pending.push_back(std::move(b));
+    }
+
+    any_output = true;
+
+    if ( metrics )
+        metrics->pending_blocks.Inc();
+
+    block_pool(num_threads).Submit([this, bp]() { Process(bp); });
+}
+
+void BlockOutput::Process(Block* b) {
+    bool compressed = gzip_level == 0 || Compress(b);
+
+    std::unique_lock<std::mutex> lock(mtx);
+
+    if ( ! compressed )
+        SetError(ENOMEM);
+
+    b->done = true;
+
+    // Whoever is writing already will pick up this block as well once
+    // it's at the front.
+    if ( writing )
+        return;
+
+    writing = true;
+
+    while ( ! pending.empty() && pending.front()->done ) {
+        auto next = std::move(pending.front());
+        pending.pop_front();
+        lock.unlock();
+
+        // After a failure, we keep discarding data so that Drain() does
+        // not get stuck.
+        if ( Errno() == 0 ) {
+            if ( util::safe_write(fd, next->data.data(), next->data.size()) ) {
+                if ( metrics )
+                    metrics->bytes_out.Inc(next->data.size());
+            }
+            else
+                SetError(errno);
+        }
+
+        if ( metrics )
+            metrics->pending_blocks.Dec();
+
+        lock.lock();
+    }
+
+    writing = false;
+    cv.notify_all();
+}
+
+bool BlockOutput::Compress(Block* b) {
+    // Each block becomes a gzip member of its own, so that blocks can be
+    // compressed independently.
+    z_stream zs = {};
+
+    if ( deflateInit2(&zs, gzip_level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK )
+        return false;
+
+    std::string out(deflateBound(&zs, b->data.size()), '\0');
+
+    zs.next_in = reinterpret_cast<Bytef*>(b->data.data());
+    zs.avail_in = b->data.size();
+    zs.next_out = reinterpret_cast<Bytef*>(out.data());
+    zs.avail_out = out.size();
+
+    int res = deflate(&zs, Z_FINISH);
+    auto len = zs.total_out;
+    deflateEnd(&zs);
+
+    if ( res != Z_STREAM_END )
+        return false;
+
+    out.resize(len);
+    b->data = std::move(out);
+    return true;
+}
+
+void BlockOutput::SetError(int err) {
+    int expected = 0;
+    error.compare_exchange_strong(expected, err ? err : EIO);
+}
+
+} // namespace zeek::logging::writer::detail
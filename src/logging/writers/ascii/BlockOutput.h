@@ -0,0 +1,127 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Output stage of the ASCII writer that moves compression and disk I/O off
+// the writer thread. Data is collected into blocks; once a block is full,
+// a thread from a small pool shared by all writers compresses it into a
+// gzip member of its own (if compression is enabled) and writes it out.
+// Blocks are always written in the order they were filled, so the
+// resulting file is a valid multi-member gzip stream (or plain text).
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "zeek/telemetry/Counter.h"
+#include "zeek/telemetry/Gauge.h"
+
+namespace zeek::logging::writer::detail {
+
+/**
+ * Telemetry for a writer's block output. Updated from the pool's threads.
+ */
+struct BlockOutputMetrics {
+    telemetry::IntCounter bytes_in;     // Uncompressed bytes passed in.
+    telemetry::IntCounter bytes_out;    // Bytes written to disk.
+    telemetry::IntGauge pending_blocks; // Blocks not written yet.
+};
+
+class BlockOutput {
+public:
+    // How much data to collect before handing a block off.
+    static constexpr size_t BLOCK_SIZE = 256 * 1024;
+
+    // How many blocks may be in flight before Write() blocks, to bound
+    // memory usage if the disk can't keep up.
+    static constexpr size_t MAX_PENDING_BLOCKS = 16;
+
+    /**
+     * Constructor.
+     *
+     * @param fd The file to write to. It remains owned by the caller.
+     *
+     * @param gzip_level The compression level, or 0 for no compression.
+     *
+     * @param num_threads The size of the thread pool. Only the first
+     * instance's value takes effect, as the pool is shared.
+     *
+     * @param metrics Telemetry to update, or null.
+     */
+    BlockOutput(int fd, int gzip_level, int num_threads, BlockOutputMetrics* metrics);
+
+    /**
+     * Destructor. Waits for all pending blocks to be written.
+     */
+    ~BlockOutput();
+
+    BlockOutput(const BlockOutput&) = delete;
+    BlockOutput& operator=(const BlockOutput&) = delete;
+
+    /**
+     * Appends data to the output.
+     *
+     * @return False if writing an earlier block has failed; see Errno().
+     */
+    bool Write(const char* data, size_t len);
+
+    /**
+     * Hands off the current block, even if not full, without waiting for
+     * it to be written.
+     *
+     * @return False if writing an earlier block has failed; see Errno().
+     */
+    bool Flush();
+
+    /**
+     * Hands off the current block, even if not full, and waits until all
+     * data has been written.
+     *
+     * @return False if writing any block has failed; see Errno().
+     */
+    bool Drain();
+
+    /**
+     * Like Drain(), but for the final time before closing the file: if
+     * nothing at all has been written to a compressed file, this writes
+     * an empty gzip member so that the file remains valid.
+     */
+    bool Finish();
+
+    /**
+     * Returns the errno value of the first failed write, or 0.
+     */
+    int Errno();
+
+private:
+    struct Block {
+        std::string data;
+        bool done = false;
+    };
+
+    void Seal(bool force = false);
+    void Process(Block* b);
+    bool Compress(Block* b);
+    void SetError(int err);
+
+    int fd;
+    int gzip_level;
+    int num_threads;
+    BlockOutputMetrics* metrics;
+
+    std::string cur;         // The block being filled.
+    bool any_output = false; // True once a block has been handed off.
+
+    // State shared with the pool's threads.
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<std::unique_ptr<Block>> pending; // In file order.
+    bool writing = false;                       // True while a thread writes to the file.
+    std::atomic<int> error = 0;                 // The first write error.
+};
+
+} // namespace zeek::logging::writer::detail
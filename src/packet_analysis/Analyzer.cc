@@ -5,6 +5,7 @@
 #include "zeek/DebugLogger.h"
 #include "zeek/Event.h"
 #include "zeek/RunState.h"
+#include "zeek/SubsystemStats.h"
 #include "zeek/session/Manager.h"
 #include "zeek/util.h"
 
@@ -114,6 +115,7 @@ bool Analyzer::ForwardPacket(size_t len, const uint8_t* data, Packet* packet, ui
     DBG_LOG(DBG_PACKET_ANALYSIS, "Analysis in %s succeeded, next layer identifier is %#x.", GetAnalyzerName(),
             identifier);
 
+    zeek::detail::SubsystemScope scope(zeek::detail::Subsystem::PacketAnalysis, inner_analyzer.get());
     return inner_analyzer->AnalyzePacket(len, data, packet);
 }
 
@@ -129,6 +131,7 @@ bool Analyzer::ForwardPacket(size_t len, const uint8_t* data, Packet* packet) co
         return false;
     }
 
+    zeek::detail::SubsystemScope scope(zeek::detail::Subsystem::PacketAnalysis, inner_analyzer.get());
     return inner_analyzer->AnalyzePacket(len, data, packet);
 }
 
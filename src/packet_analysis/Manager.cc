@@ -2,17 +2,39 @@
 
 #include "zeek/packet_analysis/Manager.h"
 
+#include <iterator>
+
 #include "zeek/RunState.h"
 #include "zeek/Stats.h"
+#include "zeek/SubsystemStats.h"
 #include "zeek/iosource/Manager.h"
 #include "zeek/iosource/PktDumper.h"
 #include "zeek/packet_analysis/Analyzer.h"
 #include "zeek/packet_analysis/Dispatcher.h"
 #include "zeek/plugin/Manager.h"
+#include "zeek/telemetry/Manager.h"
 #include "zeek/zeek-bif.h"
 
 using namespace zeek::packet_analysis;
 
+namespace {
+
+// DLT_EN10MB, which the root analyzer maps to Ethernet.
+constexpr uint32_t ETHERNET_LINK_TYPE = 1;
+
+constexpr uint32_t IP_ETHER_TYPES[] = {0x0800, 0x86DD};
+constexpr uint32_t VLAN_ETHER_TYPES[] = {0x8100, 0x88A8, 0x9100};
+
+bool contains(const std::vector<uint32_t>& types, uint32_t type) {
+    for ( auto t : types )
+        if ( t == type )
+            return true;
+
+    return false;
+}
+
+} // namespace
+
 Manager::Manager() : plugin::ComponentManager<packet_analysis::Component>("PacketAnalyzer", "Tag", "AllAnalyzers") {}
 
 Manager::~Manager() {
@@ -46,6 +68,14 @@ void Manager::InitPostScript(const std::string& unprocessed_output_file) {
     unknown_sampling_duration = id::find_val("UnknownProtocol::sampling_duration")->AsInterval();
     unknown_first_bytes_count = id::find_val("UnknownProtocol::first_bytes_count")->AsCount();
 
+    static const char* fast_path_labels[] = {"ethernet-ip", "ethernet-vlan-ip", "ethernet-qinq-ip", "generic"};
+    auto fast_path_family =
+        telemetry_mgr->CounterFamily("zeek", "packet-analysis-dispatch", {"path"},
+                                     "Packets by link-layer dispatch path taken", "1", true);
+
+    for ( size_t i = 0; i < std::size(fast_path_metrics); ++i )
+        fast_path_metrics[i] = fast_path_family.GetOrAdd({{"path", fast_path_labels[i]}});
+
     if ( ! unprocessed_output_file.empty() )
         // This gets automatically cleaned up by iosource_mgr. No need to delete it locally.
         unprocessed_dumper = iosource_mgr->OpenPktDumper(unprocessed_output_file, true);
@@ -114,7 +144,13 @@ void Manager::ProcessPacket(Packet* packet) {
     }
 
     // Start packet analysis
-    root_analyzer->ForwardPacket(packet->cap_len, packet->data, packet, packet->link_type);
+    if ( ! fast_path_initialized && run_state::detail::zeek_init_done )
+        InitFastPath();
+
+    if ( ! ProcessFastPath(packet) ) {
+        fast_path_metrics[MAX_FAST_PATH_VLANS + 1]->Inc();
+        root_analyzer->ForwardPacket(packet->cap_len, packet->data, packet, packet->link_type);
+    }
 
     if ( ! packet->processed ) {
         if ( packet_not_processed )
@@ -136,6 +172,110 @@ void Manager::ProcessPacket(Packet* packet) {
         DumpPacket(packet, packet->dump_size);
 }
 
+void Manager::InitFastPath() {
+    fast_path_initialized = true;
+
+    if ( ! id::find_val("PacketAnalyzer::fast_path")->AsBool() )
+        return;
+
+    auto ethernet = GetAnalyzer("Ethernet");
+    auto vlan = GetAnalyzer("VLAN");
+    auto ip = GetAnalyzer("IP");
+
+    if ( ! (root_analyzer && ethernet && vlan && ip) )
+        return;
+
+    // The fast path stands in for the regular dispatch only as long as it
+    // leads to the same analyzers.
+    if ( root_analyzer->Lookup(ETHERNET_LINK_TYPE) != ethernet || ! ethernet->IsEnabled() || ! ip->IsEnabled() )
+        return;
+
+    auto resolve = [&](const AnalyzerPtr& analyzer, FastPathLayer* layer) {
+        for ( auto type : IP_ETHER_TYPES )
+            if ( analyzer->Lookup(type) == ip )
+                layer->ip_types.push_back(type);
+
+        if ( ! vlan->IsEnabled() )
+            return;
+
+        for ( auto type : VLAN_ETHER_TYPES )
+            if ( analyzer->Lookup(type) == vlan )
+                layer->vlan_types.push_back(type);
+    };
+
+    resolve(ethernet, &fast_path_ethernet);
+    resolve(vlan, &fast_path_vlan);
+
+    if ( fast_path_ethernet.ip_types.empty() )
+        return;
+
+    fast_path_ip = ip.get();
+    fast_path_ethernet_analyzer = ethernet.get();
+    fast_path_vlan_analyzer = vlan.get();
+
+    DBG_LOG(DBG_PACKET_ANALYSIS, "Using fast path for Ethernet/VLAN/IP (%zu/%zu EtherTypes)",
+            fast_path_ethernet.ip_types.size() + fast_path_ethernet.vlan_types.size(),
+            fast_path_vlan.ip_types.size() + fast_path_vlan.vlan_types.size());
+}
+
+bool Manager::ProcessFastPath(Packet* packet) {
+    if ( ! fast_path_ip || packet->link_type != ETHERNET_LINK_TYPE )
+        return false;
+
+    // Leave analyzers disabled since InitFastPath() to the regular
+    // dispatch, which handles them as usual.
+    if ( ! fast_path_ethernet_analyzer->IsEnabled() || ! fast_path_ip->IsEnabled() )
+        return false;
+
+    // This mirrors the Ethernet and VLAN analyzers for the common case,
+    // bailing out before touching the packet for anything those would
+    // either report or handle differently (truncation, Cisco FabricPath,
+    // non-Ethernet II frames, other EtherTypes).
+    const uint8_t* data = packet->data;
+    size_t len = packet->cap_len;
+
+    if ( 16 >= len || (data[12] == 0x89 && data[13] == 0x03) )
+        return false;
+
+    const uint8_t* l2 = data;
+    uint32_t protocol = (data[12] << 8) + data[13];
+    data += 14;
+    len -= 14;
+
+    uint32_t tags[MAX_FAST_PATH_VLANS];
+    int num_tags = 0;
+    const FastPathLayer* layer = &fast_path_ethernet;
+
+    while ( ! contains(layer->ip_types, protocol) ) {
+        if ( num_tags == MAX_FAST_PATH_VLANS || ! contains(layer->vlan_types, protocol) || 4 >= len ||
+             ! fast_path_vlan_analyzer->IsEnabled() )
+            return false;
+
+        tags[num_tags++] = ((data[0] << 8u) + data[1]) & 0xfff;
+        protocol = (data[2] << 8u) + data[3];
+        data += 4;
+        len -= 4;
+        layer = &fast_path_vlan;
+    }
+
+    packet->eth_type = protocol;
+    packet->l2_dst = l2;
+    packet->l2_src = l2 + 6;
+
+    for ( int i = 0; i < num_tags; ++i ) {
+        auto& vlan_ref = packet->vlan != 0 ? packet->inner_vlan : packet->vlan;
+        vlan_ref = tags[i];
+    }
+
+    fast_path_metrics[num_tags]->Inc();
+
+    zeek::detail::SubsystemScope scope(zeek::detail::Subsystem::PacketAnalysis, fast_path_ip);
+    // As with the regular dispatch, whether the IP analyzer succeeded is
+    // reflected in the packet's state rather than returned.
+    fast_path_ip->AnalyzePacket(len, data, packet);
+    return true;
+}
+
 bool Manager::ProcessInnerPacket(Packet* packet) {
     return root_analyzer->ForwardPacket(packet->cap_len, packet->data, packet, packet->link_type);
 }
@@ -2,6 +2,9 @@
 
 #pragma once
 
+#include <optional>
+#include <vector>
+
 #include "zeek/Func.h"
 #include "zeek/PacketFilter.h"
 #include "zeek/Tag.h"
@@ -9,6 +12,7 @@
 #include "zeek/packet_analysis/Component.h"
 #include "zeek/packet_analysis/Dispatcher.h"
 #include "zeek/plugin/ComponentManager.h"
+#include "zeek/telemetry/Counter.h"
 
 namespace zeek {
 
@@ -199,6 +203,48 @@ private:
 
     bool PermitUnknownProtocol(const std::string& analyzer, uint32_t protocol);
 
+    /**
+     * Resolves the analyzers and EtherTypes that ProcessFastPath() relies
+     * on. This has to wait until zeek_init() has registered all mappings.
+     */
+    void InitFastPath();
+
+    /**
+     * Dissects Ethernet frames carrying IP, with up to MAX_FAST_PATH_VLANS
+     * VLAN tags in between, without dispatching through the individual
+     * link-layer analyzers, and hands the IP header to the IP analyzer
+     * directly. Anything else is left to the regular dispatch.
+     *
+     * @param packet The packet to process.
+     *
+     * @return True if the packet took the fast path. If false, the packet
+     * remains unmodified.
+     */
+    bool ProcessFastPath(Packet* packet);
+
+    static constexpr int MAX_FAST_PATH_VLANS = 2;
+
+    // EtherTypes that a link layer forwards to the IP and VLAN analyzers,
+    // respectively.
+    struct FastPathLayer {
+        std::vector<uint32_t> ip_types;
+        std::vector<uint32_t> vlan_types;
+    };
+
+    // The dispatch mappings are fixed once zeek_init() has finished, but
+    // analyzers may still get enabled or disabled, which the fast path
+    // checks for on each packet.
+    bool fast_path_initialized = false;
+    Analyzer* fast_path_ip = nullptr; // Null if the fast path is unavailable.
+    Analyzer* fast_path_ethernet_analyzer = nullptr;
+    Analyzer* fast_path_vlan_analyzer = nullptr;
+    FastPathLayer fast_path_ethernet;
+    FastPathLayer fast_path_vlan;
+
+    // Packets by path taken, indexed by the number of VLAN tags; the last
+    // one counts packets taking the regular dispatch.
+    std::optional<telemetry::IntCounter> fast_path_metrics[MAX_FAST_PATH_VLANS + 2];
+
     std::map<std::string, AnalyzerPtr> analyzers;
     AnalyzerPtr root_analyzer = nullptr;
 
@@ -1,11 +1,48 @@
 #include "zeek/packet_analysis/protocol/ip/SessionAdapter.h"
 
+#include <optional>
+
+#include "zeek/Conn.h"
 #include "zeek/File.h"
+#include "zeek/NetVar.h"
 #include "zeek/ZeekString.h"
+#include "zeek/iosource/Manager.h"
+#include "zeek/iosource/PktSrc.h"
 #include "zeek/packet_analysis/protocol/ip/IPBasedAnalyzer.h"
+#include "zeek/telemetry/Manager.h"
 
 using namespace zeek::packet_analysis::IP;
 
+namespace {
+
+struct BypassMetrics {
+    zeek::telemetry::IntCounter connections;
+    zeek::telemetry::IntCounter bytes;
+    zeek::telemetry::IntCounter shunted;
+};
+
+std::optional<BypassMetrics> bypass_metrics;
+
+BypassMetrics& get_bypass_metrics() {
+    if ( ! bypass_metrics ) {
+        auto connections_family =
+            zeek::telemetry_mgr->CounterFamily("zeek", "payload-bypassed-connections", {},
+                                               "Connections whose payload analysis was bypassed", "1", true);
+        auto bytes_family = zeek::telemetry_mgr->CounterFamily(
+            "zeek", "payload-bypassed", {}, "Payload not passed on to analyzers due to a bypass", "bytes", true);
+        auto shunted_family = zeek::telemetry_mgr->CounterFamily(
+            "zeek", "payload-bypass-shunted-connections", {}, "Bypassed connections shunted by the packet source",
+            "1", true);
+
+        bypass_metrics.emplace(
+            BypassMetrics{connections_family.GetOrAdd({}), bytes_family.GetOrAdd({}), shunted_family.GetOrAdd({})});
+    }
+
+    return *bypass_metrics;
+}
+
+} // namespace
+
 void SessionAdapter::Done() { Analyzer::Done(); }
 
 bool SessionAdapter::IsReuse(double t, const u_char* pkt) { return parent->IsReuse(t, pkt); }
@@ -19,6 +56,42 @@ zeek::FilePtr SessionAdapter::GetContentsFile(unsigned int /* direction */) cons
     return nullptr;
 }
 
+void SessionAdapter::CheckPayloadBypass() {
+    payload_check_pending = false;
+
+    if ( payload_bypassed || ! detail::bypass_unneeded_payload || Skipping() )
+        return;
+
+    if ( ChildrenNeedPayload() || ! BypassPayload() )
+        return;
+
+    DBG_LOG(DBG_ANALYZER, "%s bypassing further payload", fmt_analyzer(this).c_str());
+
+    payload_bypassed = true;
+    auto& metrics = get_bypass_metrics();
+    metrics.connections.Inc();
+
+    if ( ! detail::shunt_bypassed_flows )
+        return;
+
+    auto pkt_src = iosource_mgr->GetPktSrc();
+
+    if ( ! pkt_src )
+        return;
+
+    ConnTuple tuple;
+    tuple.src_addr = Conn()->OrigAddr();
+    tuple.dst_addr = Conn()->RespAddr();
+    tuple.src_port = Conn()->OrigPort();
+    tuple.dst_port = Conn()->RespPort();
+    tuple.proto = Conn()->ConnTransport();
+
+    if ( pkt_src->ShuntFlow(tuple) )
+        metrics.shunted.Inc();
+}
+
+void SessionAdapter::CountBypassedPayload(int len) { get_bypass_metrics().bytes.Inc(len); }
+
 void SessionAdapter::PacketContents(const u_char* data, int len) {
     if ( packet_contents && len > 0 ) {
         zeek::String* cbs = new zeek::String(data, len, true);
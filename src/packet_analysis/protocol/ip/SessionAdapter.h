@@ -92,9 +92,47 @@ public:
      */
     void PacketContents(const u_char* data, int len);
 
+    /**
+     * Notes that an analyzer below the adapter may have stopped needing
+     * payload. The adapter re-evaluates this through CheckPayloadBypass()
+     * at its next convenient point, as analyzers may report it in the
+     * middle of a delivery.
+     */
+    void PayloadNeedsChanged() { payload_check_pending = true; }
+
+    /**
+     * If enabled through \c bypass_unneeded_payload, and none of the
+     * adapter's analyzers needs any further payload, stops passing it on
+     * to them. Afterwards, if enabled through \c shunt_bypassed_flows,
+     * asks the packet source to drop the flow's packets entirely.
+     */
+    void CheckPayloadBypass();
+
+    /**
+     * Returns true if payload is no longer passed on to the analyzers.
+     */
+    bool PayloadBypassed() const { return payload_bypassed; }
+
 protected:
+    /**
+     * Stops passing payload on to the analyzer tree. Only header-level
+     * processing remains.
+     *
+     * @return False if the adapter can't bypass payload (right now), in
+     * which case nothing changes. The default implementation always
+     * returns false.
+     */
+    virtual bool BypassPayload() { return false; }
+
+    /**
+     * Counts payload that the adapter didn't pass on due to a bypass.
+     */
+    void CountBypassedPayload(int len);
+
     IPBasedAnalyzer* parent = nullptr;
     analyzer::pia::PIA* pia = nullptr;
+    bool payload_check_pending = false;
+    bool payload_bypassed = false;
 };
 
 } // namespace zeek::packet_analysis::IP
@@ -29,6 +29,7 @@ TCPSessionAdapter::TCPSessionAdapter(Connection* conn) : packet_analysis::IP::Se
     deferred_gen_event = close_deferred = 0;
 
     seen_first_ACK = 0;
+    coalesce_timer_pending = 0;
     is_active = 1;
     finished = 0;
     reassembling = 0;
@@ -57,6 +58,9 @@ void TCPSessionAdapter::Init() {
 }
 
 void TCPSessionAdapter::Done() {
+    orig->FlushCoalesced();
+    resp->FlushCoalesced();
+
     Analyzer::Done();
 
     if ( run_state::terminating && connection_pending && is_active && ! BothClosed() )
@@ -548,6 +552,8 @@ void TCPSessionAdapter::Process(bool is_orig, const struct tcphdr* tp, int len,
         // if ( len > 0 )
         //	Weird("RST_with_data");
 
+        endpoint->FlushCoalesced();
+        peer->FlushCoalesced();
         PacketWithRST();
     }
 
@@ -616,15 +622,28 @@ void TCPSessionAdapter::Process(bool is_orig, const struct tcphdr* tp, int len,
 
     rel_data_seq = flags.SYN() ? rel_seq + 1 : rel_seq;
 
+    if ( payload_check_pending )
+        CheckPayloadBypass();
+
     bool need_contents = false;
     if ( len > 0 && (remaining >= len || ! packet_children.empty()) && ! flags.RST() && ! Skipping() &&
-         ! seq_underflow )
-        need_contents =
-            endpoint->DataSent(run_state::current_timestamp, rel_data_seq, len, remaining, data, ip.get(), tp);
+         ! seq_underflow ) {
+        if ( payload_bypassed )
+            CountBypassedPayload(len);
+        else
+            need_contents =
+                endpoint->DataSent(run_state::current_timestamp, rel_data_seq, len, remaining, data, ip.get(), tp);
+    }
+
+    if ( flags.FIN() )
+        endpoint->FlushCoalesced();
 
     endpoint->CheckEOF();
 
     if ( do_close ) {
+        endpoint->FlushCoalesced();
+        peer->FlushCoalesced();
+
         // We need to postpone doing this until after we process
         // DataSent, so we don't generate a connection_finished event
         // until after data perhaps included with the FIN is processed.
@@ -1003,7 +1022,7 @@ void TCPSessionAdapter::DeliverPacket(int len, const u_char* data, bool is_orig,
         }
     }
 
-    if ( ! reassembling )
+    if ( ! reassembling && ! payload_bypassed )
         ForwardPacket(len, data, is_orig, seq, ip, caplen);
 }
 
@@ -1139,6 +1158,36 @@ void TCPSessionAdapter::DeleteTimer(double /* t */) { session_mgr->Remove(Conn()
 
 void TCPSessionAdapter::ConnDeleteTimer(double t) { Conn()->DeleteTimer(t); }
 
+void TCPSessionAdapter::CoalesceTimer(double t) {
+    coalesce_timer_pending = 0;
+
+    // Data that arrived after the timer got armed may not be due yet.
+    double next = 0.0;
+
+    for ( auto endp : {orig, resp} ) {
+        auto r = endp->contents_processor;
+
+        if ( ! r )
+            continue;
+
+        if ( auto due = r->CoalescedDue(); due && due <= t )
+            r->FlushCoalesced();
+        else if ( due && (! next || due < next) )
+            next = due;
+    }
+
+    if ( next )
+        ScheduleCoalesceFlush(next);
+}
+
+void TCPSessionAdapter::ScheduleCoalesceFlush(double t) {
+    if ( coalesce_timer_pending )
+        return;
+
+    ADD_ANALYZER_TIMER(&TCPSessionAdapter::CoalesceTimer, t, false, zeek::detail::TIMER_TCP_COALESCE);
+    coalesce_timer_pending = 1;
+}
+
 void TCPSessionAdapter::SetContentsFile(unsigned int direction, FilePtr f) {
     if ( direction == CONTENTS_NONE ) {
         orig->SetContentsFile(nullptr);
@@ -1297,7 +1346,7 @@ void TCPSessionAdapter::AddChildPacketAnalyzer(analyzer::Analyzer* a) {
 }
 
 bool TCPSessionAdapter::DataPending(analyzer::tcp::TCP_Endpoint* closing_endp) {
-    if ( Skipping() )
+    if ( Skipping() || payload_bypassed )
         return false;
 
     return closing_endp->DataPending();
@@ -1638,6 +1687,16 @@ int TCPSessionAdapter::ParseTCPOptions(const struct tcphdr* tcp, bool is_orig) {
     return 0;
 }
 
+bool TCPSessionAdapter::BypassPayload() {
+    // Anything recording the payload still needs it.
+    if ( tcp_contents || Conn()->RecordContents() || orig->GetContentsFile() || resp->GetContentsFile() )
+        return false;
+
+    orig->StopDeliveries();
+    resp->StopDeliveries();
+    return true;
+}
+
 void TCPSessionAdapter::CheckRecording(bool need_contents, analyzer::tcp::TCP_Flags flags) {
     bool record_current_content = need_contents || Conn()->RecordContents();
     bool record_current_packet = Conn()->RecordPackets() || flags.SYN() || flags.FIN() || flags.RST();
@@ -94,6 +94,9 @@ protected:
     void FlipRoles() override;
     bool IsReuse(double t, const u_char* pkt) override;
 
+    // From IP::SessionAdapter.
+    bool BypassPayload() override;
+
     void SetPartialStatus(analyzer::tcp::TCP_Flags flags, bool is_orig);
     void SetFirstPacketSeen(bool is_orig);
 
@@ -138,6 +141,11 @@ protected:
     void ResetTimer(double t);
     void DeleteTimer(double t);
     void ConnDeleteTimer(double t);
+    void CoalesceTimer(double t);
+
+    // Arms a timer for passing on data that the reassemblers collected
+    // for a combined delivery at time t, unless there's one already.
+    void ScheduleCoalesceFlush(double t);
 
     void EndpointEOF(analyzer::tcp::TCP_Reassembler* endp);
     void ConnectionClosed(analyzer::tcp::TCP_Endpoint* endpoint, analyzer::tcp::TCP_Endpoint* peer, bool gen_event);
@@ -177,6 +185,9 @@ private:
 
     // Whether we have seen the first ACK from the originator.
     unsigned int seen_first_ACK : 1;
+
+    // Whether a CoalesceTimer is pending.
+    unsigned int coalesce_timer_pending : 1;
 };
 
 } // namespace zeek::packet_analysis::TCP
@@ -16,6 +16,7 @@
 #include "zeek/script_opt/Reduce.h"
 #include "zeek/script_opt/UsageAnalyzer.h"
 #include "zeek/script_opt/UseDefs.h"
+#include "zeek/script_opt/ZAM/Cache.h"
 #include "zeek/script_opt/ZAM/Compile.h"
 
 namespace zeek::detail {
@@ -272,6 +273,13 @@ static void init_options() {
     check_env_opt("ZEEK_NO_ZAM_OPT", analysis_options.no_ZAM_opt);
     check_env_opt("ZEEK_DUMP_ZAM", analysis_options.dump_ZAM);
     check_env_opt("ZEEK_PROFILE", analysis_options.profile_ZAM);
+    check_env_opt("ZEEK_ZAM_CACHE", analysis_options.cache_ZAM);
+
+    auto zcf = getenv("ZEEK_ZAM_CACHE_FILE");
+    if ( zcf ) {
+        analysis_options.ZAM_cache_file = zcf;
+        analysis_options.cache_ZAM = true;
+    }
 
     // Compile-to-C++-related options.
     check_env_opt("ZEEK_GEN_CPP", analysis_options.gen_CPP);
@@ -316,7 +324,7 @@ static void init_options() {
         analysis_options.optimize_AST = true;
     }
 
-    if ( analysis_options.dump_ZAM )
+    if ( analysis_options.dump_ZAM || analysis_options.cache_ZAM )
         analysis_options.gen_ZAM_code = true;
 
     if ( ! analysis_options.only_funcs.empty() || ! analysis_options.only_files.empty() ) {
@@ -437,6 +445,27 @@ static void analyze_scripts_for_ZAM() {
 
     auto pfs = std::make_shared<ProfileFuncs>(funcs, nullptr, true);
 
+    // Try to pick up bodies compiled by a previous run.  We have to do
+    // this prior to inlining, as the inliner modifies the bodies.
+    p_hash_type cache_key = 0;
+    bool used_cache = false;
+
+    if ( analysis_options.cache_ZAM && analysis_options.activate ) {
+        cache_key = compute_ZAM_cache_key(funcs);
+
+        bool all_restored = false;
+        if ( cache_key != 0 && load_ZAM_cache(funcs, cache_key, all_restored) ) {
+            if ( all_restored )
+                return;
+
+            used_cache = true;
+        }
+    }
+
+    // Inlining can add functions (coalesced event handlers), which we
+    // need to distinguish when saving to the cache.
+    auto num_orig_funcs = funcs.size();
+
     bool report_recursive = analysis_options.report_recursive;
     std::unique_ptr<Inliner> inl;
     if ( analysis_options.inliner )
@@ -467,7 +496,7 @@ static void analyze_scripts_for_ZAM() {
         }
     }
 
-    bool did_one = false;
+    bool did_one = used_cache;
 
     for ( auto& f : funcs ) {
         if ( ! f.ShouldAnalyze() )
@@ -502,6 +531,9 @@ static void analyze_scripts_for_ZAM() {
         reporter->FatalError("no matching functions/files for -O ZAM");
 
     finalize_functions(funcs);
+
+    if ( cache_key != 0 && ! used_cache )
+        save_ZAM_cache(funcs, num_orig_funcs, cache_key);
 }
 
 void clear_script_analysis() {
@@ -75,6 +75,13 @@ struct AnalyOpt {
     // Produce a profile of ZAM execution.
     bool profile_ZAM = false;
 
+    // If true, reuse compiled ZAM bodies from a previous run over the
+    // same scripts, and save them for future runs.
+    bool cache_ZAM = false;
+
+    // Where the ZAM cache lives.
+    std::string ZAM_cache_file = ".zeek-zam-cache";
+
     // If true, dump out transformed code: the results of reducing
     // interpreted scripts, and, if optimize is set, of then optimizing
     // them.
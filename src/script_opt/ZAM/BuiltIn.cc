@@ -253,41 +253,12 @@ ZInstAux* ZAMCompiler::BuildCatAux(const ExprPList& args) {
         auto& a_i = args[i];
         auto& t = a_i->GetType();
 
-        std::unique_ptr<CatArg> ca;
-
-        if ( a_i->Tag() == EXPR_CONST ) {
-            auto c = a_i->AsConstExpr()->ValuePtr();
-            aux->Add(i, c); // it will be ignored
-            auto sv = ZAM_val_cat(c);
-            auto s = sv->AsString();
-            auto b = reinterpret_cast<char*>(s->Bytes());
-            ca = std::make_unique<CatArg>(std::string(b, s->Len()));
-        }
-
-        else {
-            auto slot = FrameSlot(a_i->AsNameExpr());
-            aux->Add(i, slot, t);
-
-            switch ( t->Tag() ) {
-                case TYPE_BOOL:
-                case TYPE_INT:
-                case TYPE_COUNT:
-                case TYPE_DOUBLE:
-                case TYPE_TIME:
-                case TYPE_ENUM:
-                case TYPE_PORT:
-                case TYPE_ADDR:
-                case TYPE_SUBNET: ca = std::make_unique<FixedCatArg>(t); break;
-
-                case TYPE_STRING: ca = std::make_unique<StringCatArg>(); break;
-
-                case TYPE_PATTERN: ca = std::make_unique<PatternCatArg>(); break;
-
-                default: ca = std::make_unique<DescCatArg>(t); break;
-            }
-        }
+        if ( a_i->Tag() == EXPR_CONST )
+            aux->Add(i, a_i->AsConstExpr()->ValuePtr()); // it will be ignored
+        else
+            aux->Add(i, FrameSlot(a_i->AsNameExpr()), t);
 
-        aux->cat_args[i] = std::move(ca);
+        aux->cat_args[i] = build_cat_arg(aux->constants[i], aux->types[i]);
     }
 
     return aux;
@@ -4,6 +4,7 @@
 
 #include "zeek/IPAddr.h"
 #include "zeek/RE.h"
+#include "zeek/script_opt/ZAM/Support.h"
 
 namespace zeek::detail {
 
@@ -138,4 +139,31 @@ size_t PatternCatArg::ComputeMaxSize(ZVal* zframe, int slot) {
     return n;
 }
 
+std::unique_ptr<CatArg> build_cat_arg(const ValPtr& c, const TypePtr& t) {
+    if ( c ) {
+        auto sv = ZAM_val_cat(c);
+        auto s = sv->AsString();
+        auto b = reinterpret_cast<char*>(s->Bytes());
+        return std::make_unique<CatArg>(std::string(b, s->Len()));
+    }
+
+    switch ( t->Tag() ) {
+        case TYPE_BOOL:
+        case TYPE_INT:
+        case TYPE_COUNT:
+        case TYPE_DOUBLE:
+        case TYPE_TIME:
+        case TYPE_ENUM:
+        case TYPE_PORT:
+        case TYPE_ADDR:
+        case TYPE_SUBNET: return std::make_unique<FixedCatArg>(t);
+
+        case TYPE_STRING: return std::make_unique<StringCatArg>();
+
+        case TYPE_PATTERN: return std::make_unique<PatternCatArg>();
+
+        default: return std::make_unique<DescCatArg>(t);
+    }
+}
+
 } // namespace zeek::detail
@@ -99,4 +99,9 @@ protected:
     TypePtr t;
 };
 
+// Returns the CatArg to use for a cat() argument that's either the given
+// constant, if non-nil, or otherwise a frame slot of type "t".  Note that
+// the returned object can retain a reference to "t".
+extern std::unique_ptr<CatArg> build_cat_arg(const ValPtr& c, const TypePtr& t);
+
 } // namespace zeek::detail
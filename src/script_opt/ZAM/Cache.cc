@@ -0,0 +1,1147 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek/script_opt/ZAM/Cache.h"
+
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <unordered_set>
+
+#include "zeek/EventRegistry.h"
+#include "zeek/Func.h"
+#include "zeek/IPAddr.h"
+#include "zeek/RE.h"
+#include "zeek/Reporter.h"
+#include "zeek/ScannedFile.h"
+#include "zeek/Scope.h"
+#include "zeek/Var.h"
+#include "zeek/module_util.h"
+#include "zeek/script_opt/ZAM/ZBody.h"
+
+extern const char* zeek_version();
+
+namespace zeek::detail {
+
+// Bump this whenever the layout of the cache changes in a way not
+// reflected in the ZAM instruction set.
+static constexpr int ZAM_CACHE_VERSION = 1;
+
+static constexpr char ZAM_CACHE_MAGIC[] = "ZAMCACHE";
+static constexpr size_t ZAM_CACHE_MAGIC_LEN = sizeof(ZAM_CACHE_MAGIC) - 1;
+
+// How we represent the different flavors of types.
+enum ZAMCacheTypeKind {
+    ZCT_NONE,   // nil type
+    ZCT_BASE,   // atomic type, recovered via base_type()
+    ZCT_NAMED,  // type with a global name
+    ZCT_GLOBAL, // type associated with a global identifier
+    ZCT_VECTOR,
+    ZCT_SET,
+    ZCT_TABLE,
+    ZCT_LIST,
+    ZCT_OPAQUE,
+    ZCT_FILE,
+};
+
+// The disposition of a function's body in the run that wrote the cache.
+enum ZAMCacheFuncKind {
+    ZCF_COMPILED,  // compiled, and included in the cache
+    ZCF_LEAVE,     // not compiled, so leave it alone
+    ZCF_RECOMPILE, // compiled, but needs to be compiled afresh
+};
+
+static bool is_atomic_type_tag(TypeTag tag) {
+    switch ( tag ) {
+        case TYPE_VOID:
+        case TYPE_BOOL:
+        case TYPE_INT:
+        case TYPE_COUNT:
+        case TYPE_DOUBLE:
+        case TYPE_TIME:
+        case TYPE_INTERVAL:
+        case TYPE_STRING:
+        case TYPE_PATTERN:
+        case TYPE_PORT:
+        case TYPE_ADDR:
+        case TYPE_SUBNET:
+        case TYPE_ANY: return true;
+
+        default: return false;
+    }
+}
+
+// Whether instructions with the given operand type include a constant.
+// This mirrors ZInst::ConstVal().
+static bool op_type_has_const(ZAMOpType ot) {
+    switch ( ot ) {
+        case OP_C:
+        case OP_VC:
+        case OP_VC_I1:
+        case OP_VVC:
+        case OP_VVC_I2:
+        case OP_VVVC:
+        case OP_VVVC_I3:
+        case OP_VVVC_I2_I3:
+        case OP_VVVC_I1_I2_I3: return true;
+
+        default: return false;
+    }
+}
+
+std::string ZAMCacheSaver::Contents() {
+    char* data;
+    auto len = fmt.EndWrite(&data);
+    std::string contents(data, len);
+    free(data);
+
+    // Leave ourselves in a usable state.
+    fmt.StartWrite();
+
+    return contents;
+}
+
+const ID* ZAMCacheSaver::GlobalWithType(const Type* t) {
+    if ( ! have_typed_globals ) {
+        for ( const auto& [name, id] : global_scope()->Vars() )
+            if ( id->GetType() )
+                typed_globals.emplace(id->GetType().get(), id.get());
+
+        have_typed_globals = true;
+    }
+
+    auto tg = typed_globals.find(t);
+    return tg == typed_globals.end() ? nullptr : tg->second;
+}
+
+bool ZAMCacheSaver::SaveType(const TypePtr& t) {
+    if ( ! t ) {
+        fmt.Write(ZCT_NONE, "type-kind");
+        return true;
+    }
+
+    auto tag = t->Tag();
+
+    if ( is_atomic_type_tag(tag) ) {
+        fmt.Write(ZCT_BASE, "type-kind");
+        fmt.Write(static_cast<int>(tag), "type-tag");
+        return true;
+    }
+
+    const auto& name = t->GetName();
+    if ( ! name.empty() ) {
+        const auto& id = global_scope()->Find(name);
+        if ( id && id->IsType() && id->GetType() == t ) {
+            fmt.Write(ZCT_NAMED, "type-kind");
+            fmt.Write(name, "type-name");
+            return true;
+        }
+    }
+
+    switch ( tag ) {
+        case TYPE_VECTOR: fmt.Write(ZCT_VECTOR, "type-kind"); return SaveType(t->Yield());
+
+        case TYPE_TABLE: {
+            auto tt = t->AsTableType();
+            if ( tt->IsSet() ) {
+                fmt.Write(ZCT_SET, "type-kind");
+                return SaveType(tt->GetIndices());
+            }
+
+            fmt.Write(ZCT_TABLE, "type-kind");
+            return SaveType(tt->GetIndices()) && SaveType(tt->Yield());
+        }
+
+        case TYPE_LIST: {
+            auto tl = t->AsTypeList();
+            const auto& types = tl->GetTypes();
+
+            fmt.Write(ZCT_LIST, "type-kind");
+            if ( ! SaveType(tl->GetPureType()) )
+                return false;
+
+            fmt.Write(static_cast<uint64_t>(types.size()), "num-types");
+            for ( const auto& lt : types )
+                if ( ! SaveType(lt) )
+                    return false;
+
+            return true;
+        }
+
+        case TYPE_OPAQUE:
+            fmt.Write(ZCT_OPAQUE, "type-kind");
+            fmt.Write(t->AsOpaqueType()->Name(), "opaque-name");
+            return true;
+
+        case TYPE_FILE: fmt.Write(ZCT_FILE, "type-kind"); return SaveType(t->Yield());
+
+        default: break;
+    }
+
+    // Records, enums and functions lacking a name of their own are
+    // usually still the type of some global.
+    if ( auto id = GlobalWithType(t.get()) ) {
+        fmt.Write(ZCT_GLOBAL, "type-kind");
+        fmt.Write(id->Name(), "global-name");
+        return true;
+    }
+
+    return false;
+}
+
+bool ZAMCacheSaver::SaveVal(const ValPtr& v) {
+    fmt.Write(v != nullptr, "have-val");
+    if ( ! v )
+        return true;
+
+    const auto& t = v->GetType();
+    if ( ! SaveType(t) )
+        return false;
+
+    switch ( t->Tag() ) {
+        case TYPE_BOOL: fmt.Write(v->AsBool(), "val"); return true;
+
+        case TYPE_INT: fmt.Write(static_cast<int64_t>(v->AsInt()), "val"); return true;
+
+        case TYPE_ENUM: fmt.Write(static_cast<int64_t>(v->AsEnum()), "val"); return true;
+
+        case TYPE_COUNT:
+        case TYPE_PORT: fmt.Write(static_cast<uint64_t>(v->AsCount()), "val"); return true;
+
+        case TYPE_DOUBLE:
+        case TYPE_TIME:
+        case TYPE_INTERVAL: fmt.Write(v->AsDouble(), "val"); return true;
+
+        case TYPE_STRING: {
+            auto s = v->AsString();
+            fmt.Write(std::string(reinterpret_cast<const char*>(s->Bytes()), s->Len()), "val");
+            return true;
+        }
+
+        case TYPE_ADDR: fmt.Write(v->AsAddr(), "val"); return true;
+
+        case TYPE_SUBNET: fmt.Write(v->AsSubNet(), "val"); return true;
+
+        case TYPE_PATTERN: {
+            auto re = v->AsPattern();
+            fmt.Write(re->PatternText(), "exact-pattern");
+            fmt.Write(re->AnywherePatternText(), "anywhere-pattern");
+            return true;
+        }
+
+        case TYPE_FUNC: return SaveFunc(v->AsFunc());
+
+        default:
+            // Aggregates and the like.
+            return false;
+    }
+}
+
+bool ZAMCacheSaver::SaveGlobal(const ID* id) {
+    if ( ! id->IsGlobal() || global_scope()->Find(id->Name()).get() != id )
+        return false;
+
+    fmt.Write(id->Name(), "global-name");
+    return true;
+}
+
+bool ZAMCacheSaver::SaveFunc(const Func* f) {
+    const auto& id = global_scope()->Find(f->Name());
+    if ( ! id || ! id->GetVal() || id->GetType()->Tag() != TYPE_FUNC || id->GetVal()->AsFunc() != f )
+        // Not accessible by name, such as for lambdas.
+        return false;
+
+    fmt.Write(f->Name(), "func-name");
+    return true;
+}
+
+bool ZAMCacheSaver::SaveInst(const ZInst& z) {
+    if ( z.e || z.attrs )
+        // These are only present for "when" statements and constructors
+        // with attributes, neither of which we can reconstruct.
+        return false;
+
+    if ( z.call_expr && z.call_expr->IsInWhen() )
+        return false;
+
+    fmt.Write(static_cast<int>(z.op), "op");
+    fmt.Write(static_cast<int>(z.op_type), "op-type");
+    fmt.Write(z.v1, "v1");
+    fmt.Write(z.v2, "v2");
+    fmt.Write(z.v3, "v3");
+    fmt.Write(z.v4, "v4");
+    fmt.Write(z.is_managed, "is-managed");
+
+    if ( ! SaveType(z.t) || ! SaveType(z.t2) )
+        return false;
+
+    if ( op_type_has_const(z.op_type) && (! z.t || ! SaveVal(z.c.ToVal(z.t))) )
+        return false;
+
+    fmt.Write(z.func != nullptr, "have-func");
+    if ( z.func && ! SaveFunc(z.func) )
+        return false;
+
+    fmt.Write(z.event_handler != nullptr, "have-event");
+    if ( z.event_handler )
+        fmt.Write(z.event_handler->Name(), "event-name");
+
+    fmt.Write(z.aux != nullptr, "have-aux");
+    if ( z.aux && ! SaveAux(z.aux) )
+        return false;
+
+    SaveLocation(z.loc);
+
+    return true;
+}
+
+bool ZAMCacheSaver::SaveAux(const ZInstAux* aux) {
+    if ( aux->primary_func || aux->wi )
+        // Lambdas and "when" statements.
+        return false;
+
+    fmt.Write(aux->n, "aux-n");
+    fmt.Write(aux->slots != nullptr, "aux-have-slots");
+
+    for ( auto i = 0; i < aux->n; ++i ) {
+        fmt.Write(aux->ints[i], "aux-int");
+        if ( ! SaveVal(aux->constants[i]) || ! SaveType(aux->types[i]) )
+            return false;
+        fmt.Write(aux->is_managed[i], "aux-is-managed");
+    }
+
+    // These are rebuilt upon loading.
+    fmt.Write(aux->cat_args != nullptr, "aux-have-cat-args");
+
+    fmt.Write(aux->lambda_name, "aux-lambda-name");
+
+    fmt.Write(aux->id_val != nullptr, "aux-have-id");
+    if ( aux->id_val && ! SaveGlobal(aux->id_val.get()) )
+        return false;
+
+    fmt.Write(aux->can_change_non_locals, "aux-can-change-non-locals");
+
+    fmt.Write(static_cast<uint64_t>(aux->map.size()), "aux-map-size");
+    for ( auto m : aux->map )
+        fmt.Write(m, "aux-map");
+
+    fmt.Write(static_cast<uint64_t>(aux->loop_vars.size()), "aux-num-loop-vars");
+    for ( auto lv : aux->loop_vars )
+        fmt.Write(lv, "aux-loop-var");
+
+    fmt.Write(static_cast<uint64_t>(aux->loop_var_types.size()), "aux-num-loop-var-types");
+    for ( const auto& lvt : aux->loop_var_types )
+        if ( ! SaveType(lvt) )
+            return false;
+
+    fmt.Write(static_cast<uint64_t>(aux->lvt_is_managed.size()), "aux-num-lvt-is-managed");
+    for ( auto lvt_m : aux->lvt_is_managed )
+        fmt.Write(static_cast<bool>(lvt_m), "aux-lvt-is-managed");
+
+    return SaveType(aux->value_var_type);
+}
+
+void ZAMCacheSaver::SaveLocation(const std::shared_ptr<Location>& loc) {
+    fmt.Write(loc != nullptr, "have-loc");
+    if ( ! loc )
+        return;
+
+    fmt.Write(loc->filename ? loc->filename : "", "loc-file");
+    fmt.Write(loc->first_line, "loc-first-line");
+    fmt.Write(loc->last_line, "loc-last-line");
+    fmt.Write(loc->first_column, "loc-first-column");
+    fmt.Write(loc->last_column, "loc-last-column");
+}
+
+int ZAMCacheLoader::ReadInt() {
+    int v;
+    fmt.Read(&v, "int");
+    return v;
+}
+
+uint64_t ZAMCacheLoader::ReadCount() {
+    uint64_t v;
+    fmt.Read(&v, "count");
+    return v;
+}
+
+bool ZAMCacheLoader::ReadBool() {
+    bool v;
+    fmt.Read(&v, "bool");
+    return v;
+}
+
+std::string ZAMCacheLoader::ReadString() {
+    std::string v;
+    fmt.Read(&v, "string");
+    return v;
+}
+
+const char* ZAMCacheLoader::InternString(const std::string& s) {
+    // These need to persist for the lifetime of the bodies, which is
+    // to say, the lifetime of the process.
+    static std::unordered_set<std::string> interned;
+    return interned.insert(s).first->c_str();
+}
+
+bool ZAMCacheLoader::LoadType(TypePtr& t) {
+    t = nullptr;
+
+    switch ( ReadInt() ) {
+        case ZCT_NONE: return true;
+
+        case ZCT_BASE: {
+            auto tag = static_cast<TypeTag>(ReadInt());
+            if ( ! is_atomic_type_tag(tag) )
+                return false;
+
+            t = base_type(tag);
+            return true;
+        }
+
+        case ZCT_NAMED: {
+            const auto& id = global_scope()->Find(ReadString());
+            if ( ! id || ! id->IsType() )
+                return false;
+
+            t = id->GetType();
+            return true;
+        }
+
+        case ZCT_GLOBAL: {
+            const auto& id = global_scope()->Find(ReadString());
+            if ( ! id || ! id->GetType() )
+                return false;
+
+            t = id->GetType();
+            return true;
+        }
+
+        case ZCT_VECTOR: {
+            TypePtr yield;
+            if ( ! LoadType(yield) || ! yield )
+                return false;
+
+            t = make_intrusive<VectorType>(std::move(yield));
+            return true;
+        }
+
+        case ZCT_SET: {
+            TypePtr indices;
+            if ( ! LoadType(indices) || ! indices || indices->Tag() != TYPE_LIST )
+                return false;
+
+            t = make_intrusive<SetType>(cast_intrusive<TypeList>(std::move(indices)), nullptr);
+            return true;
+        }
+
+        case ZCT_TABLE: {
+            TypePtr indices;
+            TypePtr yield;
+            if ( ! LoadType(indices) || ! indices || indices->Tag() != TYPE_LIST || ! LoadType(yield) || ! yield )
+                return false;
+
+            t = make_intrusive<TableType>(cast_intrusive<TypeList>(std::move(indices)), std::move(yield));
+            return true;
+        }
+
+        case ZCT_LIST: {
+            TypePtr pure;
+            if ( ! LoadType(pure) )
+                return false;
+
+            auto tl = make_intrusive<TypeList>(std::move(pure));
+
+            auto n = ReadCount();
+            for ( auto i = 0U; i < n; ++i ) {
+                TypePtr lt;
+                if ( ! LoadType(lt) || ! lt )
+                    return false;
+                tl->AppendEvenIfNotPure(std::move(lt));
+            }
+
+            t = std::move(tl);
+            return true;
+        }
+
+        case ZCT_OPAQUE: t = make_intrusive<OpaqueType>(ReadString()); return true;
+
+        case ZCT_FILE: {
+            TypePtr yield;
+            if ( ! LoadType(yield) || ! yield )
+                return false;
+
+            t = make_intrusive<FileType>(std::move(yield));
+            return true;
+        }
+
+        default: return false;
+    }
+}
+
+bool ZAMCacheLoader::LoadVal(ValPtr& v) {
+    v = nullptr;
+
+    if ( ! ReadBool() )
+        return true;
+
+    TypePtr t;
+    if ( ! LoadType(t) || ! t )
+        return false;
+
+    switch ( t->Tag() ) {
+        case TYPE_BOOL: v = val_mgr->Bool(ReadBool()); return true;
+
+        case TYPE_INT: {
+            int64_t i;
+            fmt.Read(&i, "val");
+            v = val_mgr->Int(i);
+            return true;
+        }
+
+        case TYPE_ENUM: {
+            int64_t i;
+            fmt.Read(&i, "val");
+            v = t->AsEnumType()->GetEnumVal(i);
+            return v != nullptr;
+        }
+
+        case TYPE_COUNT:
+        case TYPE_PORT: {
+            uint64_t u;
+            fmt.Read(&u, "val");
+            if ( t->Tag() == TYPE_PORT )
+                v = val_mgr->Port(static_cast<uint32_t>(u));
+            else
+                v = val_mgr->Count(u);
+            return true;
+        }
+
+        case TYPE_DOUBLE:
+        case TYPE_TIME:
+        case TYPE_INTERVAL: {
+            double d;
+            fmt.Read(&d, "val");
+            if ( t->Tag() == TYPE_TIME )
+                v = make_intrusive<TimeVal>(d);
+            else if ( t->Tag() == TYPE_INTERVAL )
+                v = make_intrusive<IntervalVal>(d);
+            else
+                v = make_intrusive<DoubleVal>(d);
+            return true;
+        }
+
+        case TYPE_STRING: {
+            auto s = ReadString();
+            v = make_intrusive<StringVal>(s.size(), s.data());
+            return true;
+        }
+
+        case TYPE_ADDR: {
+            IPAddr a;
+            fmt.Read(&a, "val");
+            v = make_intrusive<AddrVal>(a);
+            return true;
+        }
+
+        case TYPE_SUBNET: {
+            IPPrefix p;
+            fmt.Read(&p, "val");
+            v = make_intrusive<SubNetVal>(p);
+            return true;
+        }
+
+        case TYPE_PATTERN: {
+            auto exact = ReadString();
+            auto anywhere = ReadString();
+
+            auto re = new RE_Matcher(exact.c_str(), anywhere.c_str());
+            if ( ! re->Compile() ) {
+                delete re;
+                return false;
+            }
+
+            v = make_intrusive<PatternVal>(re);
+            return true;
+        }
+
+        case TYPE_FUNC: {
+            const auto& id = global_scope()->Find(ReadString());
+            if ( ! id || ! id->GetVal() || id->GetType()->Tag() != TYPE_FUNC )
+                return false;
+
+            v = id->GetVal();
+            return true;
+        }
+
+        default: return false;
+    }
+}
+
+IDPtr ZAMCacheLoader::LoadGlobal() { return global_scope()->Find(ReadString()); }
+
+Func* ZAMCacheLoader::LoadFunc() {
+    const auto& id = global_scope()->Find(ReadString());
+    if ( ! id || ! id->GetVal() || id->GetType()->Tag() != TYPE_FUNC )
+        return nullptr;
+
+    return id->GetVal()->AsFunc();
+}
+
+bool ZAMCacheLoader::LoadInst(ZInst& z) {
+    z.op = static_cast<ZOp>(ReadInt());
+    z.op_type = static_cast<ZAMOpType>(ReadInt());
+    z.v1 = ReadInt();
+    z.v2 = ReadInt();
+    z.v3 = ReadInt();
+    z.v4 = ReadInt();
+    z.is_managed = ReadBool();
+
+    if ( ! LoadType(z.t) || ! LoadType(z.t2) )
+        return false;
+
+    if ( op_type_has_const(z.op_type) ) {
+        ValPtr c;
+        if ( ! z.t || ! LoadVal(c) )
+            return false;
+        z.c = ZVal(c, z.t);
+    }
+
+    if ( ReadBool() ) {
+        z.func = LoadFunc();
+        if ( ! z.func )
+            return false;
+    }
+
+    if ( ReadBool() ) {
+        z.event_handler = event_registry->Lookup(ReadString());
+        if ( ! z.event_handler )
+            return false;
+    }
+
+    if ( ReadBool() && ! LoadAux(z.aux) )
+        return false;
+
+    z.loc = LoadLocation();
+
+    return true;
+}
+
+bool ZAMCacheLoader::LoadAux(ZInstAux*& aux_ptr) {
+    auto aux = std::make_unique<ZInstAux>(ReadInt());
+    bool have_slots = ReadBool();
+
+    for ( auto i = 0; i < aux->n; ++i ) {
+        aux->ints[i] = ReadInt();
+        if ( ! LoadVal(aux->constants[i]) || ! LoadType(aux->types[i]) )
+            return false;
+        aux->is_managed[i] = ReadBool();
+    }
+
+    if ( ! have_slots )
+        aux->slots = nullptr;
+
+    if ( ReadBool() ) {
+        aux->cat_args = new std::unique_ptr<CatArg>[aux->n];
+        for ( auto i = 0; i < aux->n; ++i ) {
+            if ( ! aux->constants[i] && ! aux->types[i] )
+                return false;
+            aux->cat_args[i] = build_cat_arg(aux->constants[i], aux->types[i]);
+        }
+    }
+
+    aux->lambda_name = ReadString();
+
+    if ( ReadBool() ) {
+        aux->id_val = LoadGlobal();
+        if ( ! aux->id_val )
+            return false;
+    }
+
+    aux->can_change_non_locals = ReadBool();
+
+    auto n = ReadCount();
+    for ( auto i = 0U; i < n; ++i )
+        aux->map.push_back(ReadInt());
+
+    n = ReadCount();
+    for ( auto i = 0U; i < n; ++i )
+        aux->loop_vars.push_back(ReadInt());
+
+    n = ReadCount();
+    for ( auto i = 0U; i < n; ++i ) {
+        TypePtr lvt;
+        if ( ! LoadType(lvt) )
+            return false;
+        aux->loop_var_types.push_back(std::move(lvt));
+    }
+
+    n = ReadCount();
+    for ( auto i = 0U; i < n; ++i )
+        aux->lvt_is_managed.push_back(ReadBool());
+
+    if ( ! LoadType(aux->value_var_type) )
+        return false;
+
+    aux_ptr = aux.release();
+    return true;
+}
+
+std::shared_ptr<Location> ZAMCacheLoader::LoadLocation() {
+    if ( ! ReadBool() )
+        return nullptr;
+
+    auto fn = InternString(ReadString());
+    auto l1 = ReadInt();
+    auto l2 = ReadInt();
+    auto c1 = ReadInt();
+    auto c2 = ReadInt();
+
+    return std::make_shared<Location>(fn, l1, l2, c1, c2);
+}
+
+template<typename T>
+static void save_case_maps(SerializationFormat& fmt, const CaseMaps<T>& cms) {
+    fmt.Write(static_cast<uint64_t>(cms.size()), "num-case-maps");
+
+    for ( const auto& cm : cms ) {
+        fmt.Write(static_cast<uint64_t>(cm.size()), "case-map-size");
+        for ( const auto& [val, target] : cm ) {
+            fmt.Write(val, "case-val");
+            fmt.Write(target, "case-target");
+        }
+    }
+}
+
+template<typename T>
+static void load_case_maps(ZAMCacheLoader& l, CaseMaps<T>& cms) {
+    auto n = l.ReadCount();
+
+    for ( auto i = 0U; i < n; ++i ) {
+        CaseMap<T> cm;
+        auto cm_n = l.ReadCount();
+
+        for ( auto j = 0U; j < cm_n; ++j ) {
+            T val;
+            l.Fmt().Read(&val, "case-val");
+            cm[val] = l.ReadInt();
+        }
+
+        cms.push_back(std::move(cm));
+    }
+}
+
+bool ZBody::SaveTo(ZAMCacheSaver& s) const {
+    auto& fmt = s.Fmt();
+
+    fmt.Write(static_cast<uint64_t>(frame_denizens.size()), "num-frame-denizens");
+    for ( const auto& fd : frame_denizens ) {
+        fmt.Write(static_cast<uint64_t>(fd.names.size()), "num-names");
+        for ( auto i = 0U; i < fd.names.size(); ++i ) {
+            fmt.Write(fd.names[i], "name");
+            fmt.Write(static_cast<uint64_t>(fd.id_start[i]), "id-start");
+        }
+
+        fmt.Write(fd.scope_end, "scope-end");
+        fmt.Write(fd.is_managed, "is-managed");
+    }
+
+    fmt.Write(static_cast<uint64_t>(managed_slots.size()), "num-managed-slots");
+    for ( auto ms : managed_slots )
+        fmt.Write(ms, "managed-slot");
+
+    fmt.Write(static_cast<uint64_t>(globals.size()), "num-globals");
+    for ( const auto& g : globals ) {
+        if ( ! s.SaveGlobal(g.id.get()) )
+            return false;
+        fmt.Write(g.slot, "global-slot");
+    }
+
+    fmt.Write(fixed_frame != nullptr, "non-recursive");
+    fmt.Write(static_cast<uint64_t>(table_iters.size()), "num-table-iters");
+    fmt.Write(num_step_iters, "num-step-iters");
+
+    save_case_maps(fmt, int_cases);
+    save_case_maps(fmt, uint_cases);
+    save_case_maps(fmt, double_cases);
+    save_case_maps(fmt, str_cases);
+
+    fmt.Write(static_cast<uint64_t>(end_pc), "num-insts");
+    for ( auto i = 0U; i < end_pc; ++i )
+        if ( ! s.SaveInst(insts[i]) )
+            return false;
+
+    return true;
+}
+
+IntrusivePtr<ZBody> ZBody::LoadFrom(const char* func_name, ZAMCacheLoader& l) {
+    IntrusivePtr<ZBody> zb{AdoptRef{}, new ZBody(func_name)};
+
+    auto n = l.ReadCount();
+    for ( auto i = 0U; i < n; ++i ) {
+        FrameSharingInfo fsi;
+
+        auto num_names = l.ReadCount();
+        for ( auto j = 0U; j < num_names; ++j ) {
+            fsi.names.push_back(ZAMCacheLoader::InternString(l.ReadString()));
+            fsi.id_start.push_back(l.ReadCount());
+        }
+
+        fsi.scope_end = l.ReadInt();
+        fsi.is_managed = l.ReadBool();
+
+        zb->frame_denizens.push_back(std::move(fsi));
+    }
+
+    zb->frame_size = zb->frame_denizens.size();
+
+    n = l.ReadCount();
+    for ( auto i = 0U; i < n; ++i ) {
+        auto ms = l.ReadInt();
+        if ( ms < 0 || ms >= zb->frame_size )
+            return nullptr;
+        zb->managed_slots.push_back(ms);
+    }
+
+    n = l.ReadCount();
+    for ( auto i = 0U; i < n; ++i ) {
+        GlobalInfo gi;
+        gi.id = l.LoadGlobal();
+        if ( ! gi.id )
+            return nullptr;
+        gi.slot = l.ReadInt();
+        zb->globals.push_back(std::move(gi));
+    }
+
+    zb->num_globals = zb->globals.size();
+
+    if ( l.ReadBool() ) {
+        zb->fixed_frame = new ZVal[zb->frame_size];
+
+        for ( auto& ms : zb->managed_slots )
+            zb->fixed_frame[ms].ClearManagedVal();
+    }
+
+    zb->table_iters.resize(l.ReadCount());
+    zb->num_step_iters = l.ReadInt();
+
+    load_case_maps(l, zb->int_cases);
+    load_case_maps(l, zb->uint_cases);
+    load_case_maps(l, zb->double_cases);
+    load_case_maps(l, zb->str_cases);
+
+    std::vector<std::unique_ptr<ZInst>> loaded;
+    std::vector<ZInst*> zinsts;
+
+    n = l.ReadCount();
+    for ( auto i = 0U; i < n; ++i ) {
+        auto z = std::make_unique<ZInst>();
+
+        if ( ! l.LoadInst(*z) ) {
+            for ( auto& lz : loaded )
+                delete lz->aux;
+            return nullptr;
+        }
+
+        zinsts.push_back(z.get());
+        loaded.push_back(std::move(z));
+    }
+
+    zb->SetInsts(zinsts);
+
+    return zb;
+}
+
+p_hash_type compute_ZAM_cache_key(const std::vector<FuncInfo>& funcs) {
+    const auto& ao = analysis_options;
+
+    if ( ao.dump_xform || ao.dump_uds || ao.dump_ZAM || ao.report_recursive || ao.report_uncompilable ||
+         ao.usage_issues > 0 || ! ao.only_funcs.empty() || ! ao.only_files.empty() )
+        // These all require the full analysis/compilation to take place.
+        return 0;
+
+    auto h = p_hash(zeek_version());
+    h = merge_p_hashes(h, p_hash(ZAM_CACHE_VERSION));
+    h = merge_p_hashes(h, p_hash(static_cast<int>(OP_NOP)));
+
+    for ( auto flag : {ao.inliner, ao.optimize_AST, ao.no_ZAM_opt, ao.compile_all, ao.profile_ZAM} )
+        h = merge_p_hashes(h, p_hash(flag ? 1 : 0));
+
+    for ( const auto& sf : files_scanned ) {
+        if ( sf.canonical_path == ScannedFile::canonical_stdin_path )
+            // We can't tell whether this has changed.
+            return 0;
+
+        h = merge_p_hashes(h, p_hash(sf.canonical_path));
+        h = merge_p_hashes(h, p_hash(sf.skipped ? 1 : 0));
+
+        auto f = fopen(sf.canonical_path.c_str(), "r");
+        if ( ! f )
+            return 0;
+
+        std::string contents;
+        char buf[8192];
+        size_t n;
+        while ( (n = fread(buf, 1, sizeof(buf), f)) > 0 )
+            contents.append(buf, n);
+
+        fclose(f);
+
+        h = merge_p_hashes(h, p_hash(contents));
+    }
+
+    for ( const auto& f : funcs ) {
+        h = merge_p_hashes(h, p_hash(f.Func()->Name()));
+        h = merge_p_hashes(h, f.Profile() ? f.Profile()->HashVal() : 0);
+    }
+
+    // Zero is reserved for "don't use the cache".
+    return h ? h : 1;
+}
+
+// Reads the cache file, returning its payload if it's intact and
+// matches the given key.
+static bool read_ZAM_cache_file(const std::string& file, p_hash_type key, std::string& payload) {
+    auto f = fopen(file.c_str(), "rb");
+    if ( ! f )
+        return false;
+
+    char magic[ZAM_CACHE_MAGIC_LEN];
+    uint64_t header[3]; // key, payload length, payload hash
+
+    bool ok = fread(magic, 1, sizeof(magic), f) == sizeof(magic) && fread(header, sizeof(header), 1, f) == 1 &&
+              memcmp(magic, ZAM_CACHE_MAGIC, ZAM_CACHE_MAGIC_LEN) == 0 && header[0] == key;
+
+    if ( ok ) {
+        payload.resize(header[1]);
+        ok = fread(payload.data(), 1, payload.size(), f) == payload.size() && fgetc(f) == EOF &&
+             p_hash(payload) == header[2];
+    }
+
+    fclose(f);
+
+    return ok;
+}
+
+static void write_ZAM_cache_file(const std::string& file, p_hash_type key, const std::string& payload) {
+    // Write to a temporary and then rename, so concurrent Zeek processes
+    // never see a partial cache.
+    auto tmp = file + ".tmp." + std::to_string(getpid());
+
+    auto f = fopen(tmp.c_str(), "wb");
+    if ( ! f ) {
+        reporter->Warning("can't create ZAM cache file %s: %s", tmp.c_str(), strerror(errno));
+        return;
+    }
+
+    uint64_t header[3] = {key, payload.size(), p_hash(payload)};
+
+    bool ok = fwrite(ZAM_CACHE_MAGIC, 1, ZAM_CACHE_MAGIC_LEN, f) == ZAM_CACHE_MAGIC_LEN &&
+              fwrite(header, sizeof(header), 1, f) == 1 &&
+              fwrite(payload.data(), 1, payload.size(), f) == payload.size();
+
+    if ( fclose(f) != 0 )
+        ok = false;
+
+    if ( ! ok || rename(tmp.c_str(), file.c_str()) != 0 ) {
+        reporter->Warning("can't write ZAM cache file %s: %s", file.c_str(), strerror(errno));
+        unlink(tmp.c_str());
+    }
+}
+
+// An entry in the cache.
+struct ZAMCacheEntry {
+    std::string name;
+    int kind = ZCF_RECOMPILE;
+    int frame_size = 0;
+    std::string body;
+};
+
+bool load_ZAM_cache(std::vector<FuncInfo>& funcs, p_hash_type key, bool& all_restored) {
+    std::string payload;
+    if ( ! read_ZAM_cache_file(analysis_options.ZAM_cache_file, key, payload) )
+        return false;
+
+    std::vector<ZAMCacheEntry> entries;
+    std::vector<ZAMCacheEntry> coalesced;
+
+    {
+        ZAMCacheLoader top(payload);
+
+        auto n = top.ReadCount();
+        if ( n != funcs.size() )
+            return false;
+
+        for ( auto i = 0U; i < n; ++i ) {
+            ZAMCacheEntry e;
+            e.name = top.ReadString();
+            e.kind = top.ReadInt();
+            e.frame_size = top.ReadInt();
+            if ( e.kind == ZCF_COMPILED )
+                e.body = top.ReadString();
+
+            if ( e.name != funcs[i].Func()->Name() )
+                return false;
+
+            entries.push_back(std::move(e));
+        }
+
+        n = top.ReadCount();
+        for ( auto i = 0U; i < n; ++i ) {
+            ZAMCacheEntry e;
+            e.name = top.ReadString();
+            e.kind = ZCF_COMPILED;
+            e.frame_size = top.ReadInt();
+            e.body = top.ReadString();
+            coalesced.push_back(std::move(e));
+        }
+    }
+
+    all_restored = true;
+
+    // Functions for which at least one body will go through the usual
+    // analysis, or be left alone.  We can't adjust the frame sizes of
+    // these.
+    std::unordered_set<const ScriptFunc*> not_restored;
+
+    // Frame sizes for the rest.
+    std::unordered_map<ScriptFunc*, int> frame_sizes;
+
+    for ( auto i = 0U; i < entries.size(); ++i ) {
+        auto& f = funcs[i];
+        auto& e = entries[i];
+        auto func = f.Func();
+
+        if ( e.kind == ZCF_LEAVE ) {
+            f.SetShouldNotAnalyze();
+            not_restored.insert(func);
+            continue;
+        }
+
+        if ( e.kind == ZCF_COMPILED ) {
+            ZAMCacheLoader l(e.body);
+            auto zb = ZBody::LoadFrom(func->Name(), l);
+
+            if ( zb ) {
+                func->ReplaceBody(f.Body(), zb);
+                f.SetBody(zb);
+                f.SetShouldNotAnalyze();
+                frame_sizes[func] = std::max(frame_sizes[func], e.frame_size);
+                continue;
+            }
+        }
+
+        all_restored = false;
+        not_restored.insert(func);
+    }
+
+    for ( auto& [func, fs] : frame_sizes )
+        if ( not_restored.count(func) == 0 )
+            func->SetFrameSize(fs);
+
+    for ( auto& e : coalesced ) {
+        auto eh = event_registry->Lookup(e.name);
+        if ( ! eh || ! eh->GetFunc() || eh->GetFunc()->GetKind() != Func::SCRIPT_FUNC )
+            continue;
+
+        auto func = cast_intrusive<ScriptFunc>(eh->GetFunc());
+        if ( not_restored.count(func.get()) > 0 )
+            continue;
+
+        const auto& bodies = func->GetBodies();
+        const FuncInfo* info0 = nullptr;
+
+        for ( const auto& f : funcs )
+            if ( f.Body() == bodies[0].stmts ) {
+                info0 = &f;
+                break;
+            }
+
+        if ( ! info0 )
+            continue;
+
+        ZAMCacheLoader l(e.body);
+        auto zb = ZBody::LoadFrom(func->Name(), l);
+        if ( ! zb )
+            continue;
+
+        auto scope = info0->Scope();
+        auto cfunc = make_intrusive<CoalescedScriptFunc>(zb, scope, func);
+        cfunc->SetFrameSize(e.frame_size);
+
+        eh->SetFunc(cfunc);
+
+        auto fid = lookup_ID(func->Name(), GLOBAL_MODULE_NAME, false, false, false);
+        ASSERT(fid);
+        fid->SetVal(make_intrusive<FuncVal>(cfunc));
+
+        funcs.emplace_back(cfunc, scope, zb, 0);
+        funcs.back().SetProfile(std::make_shared<ProfileFunc>(cfunc.get(), zb, true));
+        funcs.back().SetShouldNotAnalyze();
+    }
+
+    return true;
+}
+
+// Saves the given body, returning false if it can't be represented.
+static bool save_ZAM_body(const StmtPtr& body, std::string& contents) {
+    ZAMCacheSaver s;
+    if ( ! static_cast<const ZBody*>(body.get())->SaveTo(s) )
+        return false;
+
+    contents = s.Contents();
+    return true;
+}
+
+void save_ZAM_cache(const std::vector<FuncInfo>& funcs, size_t num_orig_funcs, p_hash_type key) {
+    ZAMCacheSaver top;
+    auto& fmt = top.Fmt();
+
+    fmt.Write(static_cast<uint64_t>(num_orig_funcs), "num-funcs");
+
+    for ( auto i = 0U; i < num_orig_funcs; ++i ) {
+        const auto& f = funcs[i];
+        auto func = f.Func();
+
+        ZAMCacheEntry e;
+        e.kind = ZCF_LEAVE;
+
+        if ( f.Body() && f.Body()->Tag() == STMT_ZAM ) {
+            e.kind = ZCF_RECOMPILE;
+
+            // Lambdas aren't accessible by name, so we can't restore them.
+            if ( ! is_lambda(func) && ! is_when_lambda(func) && save_ZAM_body(f.Body(), e.body) )
+                e.kind = ZCF_COMPILED;
+        }
+
+        fmt.Write(func->Name(), "name");
+        fmt.Write(e.kind, "kind");
+        fmt.Write(func->FrameSize(), "frame-size");
+        if ( e.kind == ZCF_COMPILED )
+            fmt.Write(e.body, "body");
+    }
+
+    std::vector<ZAMCacheEntry> coalesced;
+
+    for ( auto i = num_orig_funcs; i < funcs.size(); ++i ) {
+        const auto& f = funcs[i];
+
+        ZAMCacheEntry e;
+        if ( f.Body() && f.Body()->Tag() == STMT_ZAM && save_ZAM_body(f.Body(), e.body) ) {
+            e.name = f.Func()->Name();
+            e.frame_size = f.Func()->FrameSize();
+            coalesced.push_back(std::move(e));
+        }
+    }
+
+    fmt.Write(static_cast<uint64_t>(coalesced.size()), "num-coalesced");
+    for ( const auto& e : coalesced ) {
+        fmt.Write(e.name, "name");
+        fmt.Write(e.frame_size, "frame-size");
+        fmt.Write(e.body, "body");
+    }
+
+    write_ZAM_cache_file(analysis_options.ZAM_cache_file, key, top.Contents());
+}
+
+} // namespace zeek::detail
@@ -0,0 +1,106 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+// Persistent on-disk cache of compiled ZAM function bodies.  Compiling
+// a full set of scripts to ZAM takes several seconds, which adds up when
+// every cluster node does it on each restart.  The cache lets subsequent
+// runs over the same scripts (and same optimization options) reload the
+// compiled bodies instead of regenerating them.
+//
+// Not every body can be represented in the cache: those that include
+// lambdas, "when" statements, attributes, anonymous record types, or
+// aggregate constants are simply compiled afresh on each run.
+
+#pragma once
+
+#include "zeek/SerializationFormat.h"
+#include "zeek/script_opt/ProfileFunc.h"
+#include "zeek/script_opt/ScriptOpt.h"
+#include "zeek/script_opt/ZAM/ZInst.h"
+
+namespace zeek::detail {
+
+// Writes out the elements of a single ZAM body.  The Save methods return
+// false if the given element can't be represented in the cache, in which
+// case the body as a whole needs to be skipped.
+class ZAMCacheSaver {
+public:
+    ZAMCacheSaver() { fmt.StartWrite(); }
+
+    SerializationFormat& Fmt() { return fmt; }
+
+    // Returns the saved bytes.
+    std::string Contents();
+
+    bool SaveType(const TypePtr& t);
+    bool SaveVal(const ValPtr& v);
+    bool SaveGlobal(const ID* id);
+    bool SaveFunc(const Func* f);
+    bool SaveInst(const ZInst& z);
+
+private:
+    bool SaveAux(const ZInstAux* aux);
+    void SaveLocation(const std::shared_ptr<Location>& loc);
+
+    // Returns the global whose type is exactly the given one, if any.
+    const ID* GlobalWithType(const Type* t);
+
+    BinarySerializationFormat fmt;
+
+    // Lazily-built map of types to globals having that type, used for
+    // types that we can't otherwise describe.
+    std::unordered_map<const Type*, const ID*> typed_globals;
+    bool have_typed_globals = false;
+};
+
+// The counterpart for reading back a body written by ZAMCacheSaver.  The
+// contents have already been checked for integrity, so the Load methods
+// only return nil/false if the saved element doesn't correspond to what's
+// present in the current scripts.
+class ZAMCacheLoader {
+public:
+    ZAMCacheLoader(const std::string& contents) { fmt.StartRead(contents.data(), contents.size()); }
+    ~ZAMCacheLoader() { fmt.EndRead(); }
+
+    SerializationFormat& Fmt() { return fmt; }
+
+    int ReadInt();
+    uint64_t ReadCount();
+    bool ReadBool();
+    std::string ReadString();
+
+    // Returns a persistent copy of the given string, suitable for use
+    // in Location's and frame denizen names.
+    static const char* InternString(const std::string& s);
+
+    bool LoadType(TypePtr& t);
+    bool LoadVal(ValPtr& v);
+    IDPtr LoadGlobal();
+    Func* LoadFunc();
+    bool LoadInst(ZInst& z);
+
+private:
+    bool LoadAux(ZInstAux*& aux);
+    std::shared_ptr<Location> LoadLocation();
+
+    BinarySerializationFormat fmt;
+};
+
+// Returns the key identifying the current scripts and optimization
+// options.  A cache is only used if its key matches.  Returns 0 if the
+// cache can't be used for this invocation.
+extern p_hash_type compute_ZAM_cache_key(const std::vector<FuncInfo>& funcs);
+
+// Restores compiled bodies from the cache for the given functions.  Those
+// restored, or which in the run that wrote the cache didn't require
+// compilation, are marked as not needing analysis.  Returns false if the
+// cache is missing or stale.  Otherwise, sets "all_restored" to whether
+// every function was handled, in which case no further optimization or
+// compilation is required.
+extern bool load_ZAM_cache(std::vector<FuncInfo>& funcs, p_hash_type key, bool& all_restored);
+
+// Writes the compiled bodies for the given functions to the cache.
+// "num_orig_funcs" is the number of functions prior to optimization
+// adding further ones (namely, coalesced event handlers).
+extern void save_ZAM_cache(const std::vector<FuncInfo>& funcs, size_t num_orig_funcs, p_hash_type key);
+
+} // namespace zeek::detail
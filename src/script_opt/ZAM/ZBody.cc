@@ -151,20 +151,34 @@ ZBody::ZBody(const char* _func_name, const ZAMCompiler* zc) : Stmt(STMT_ZAM) {
     table_iters = zc->GetTableIters();
     num_step_iters = zc->NumStepIters();
 
-    // It's a little weird doing this in the constructor, but unless
+    InitZAMGlobals();
+}
+
+ZBody::ZBody(const char* _func_name) : Stmt(STMT_ZAM) {
+    func_name = _func_name;
+    frame_size = 0;
+    num_step_iters = 0;
+    num_globals = 0;
+
+    InitZAMGlobals();
+}
+
+void ZBody::InitZAMGlobals() {
+    // It's a little weird doing this when constructing bodies, but unless
     // we add a general "initialize for ZAM" function, this is as good
     // a place as any.
-    if ( ! did_init ) {
-        auto log_ID_type = lookup_ID("ID", "Log");
-        ASSERT(log_ID_type);
-        log_ID_enum_type = log_ID_type->GetType<EnumType>();
+    if ( did_init )
+        return;
 
-        any_base_type = base_type(TYPE_ANY);
+    auto log_ID_type = lookup_ID("ID", "Log");
+    ASSERT(log_ID_type);
+    log_ID_enum_type = log_ID_type->GetType<EnumType>();
 
-        ZVal::SetZValNilStatusAddr(&ZAM_error);
+    any_base_type = base_type(TYPE_ANY);
 
-        did_init = false;
-    }
+    ZVal::SetZValNilStatusAddr(&ZAM_error);
+
+    did_init = true;
 }
 
 ZBody::~ZBody() {
@@ -26,6 +26,9 @@ using CaseMaps = std::vector<CaseMap<T>>;
 
 using TableIterVec = std::vector<TableIterInfo>;
 
+class ZAMCacheSaver;
+class ZAMCacheLoader;
+
 class ZBody : public Stmt {
 public:
     ZBody(const char* _func_name, const ZAMCompiler* zc);
@@ -33,24 +36,35 @@ public:
     ~ZBody() override;
 
     // These are split out from the constructor to allow construction
-    // of a ZBody from either save-file full instructions (first method,
-    // not currently supported) or intermediary instructions (second method).
+    // of a ZBody from either save-file full instructions (first method)
+    // or intermediary instructions (second method).
     void SetInsts(std::vector<ZInst*>& insts);
     void SetInsts(std::vector<ZInstI*>& instsI);
 
     ValPtr Exec(Frame* f, StmtFlowType& flow) override;
 
-    // Older code exists for save files, but let's see if we can
-    // avoid having to support them, as they're a fairly elaborate
-    // production.
-    //
-    // void SaveTo(FILE* f, int interp_frame_size) const;
+    // Writes the body to a ZAM cache.  Returns false if the body includes
+    // elements that can't be saved, in which case the function will need
+    // to be recompiled on subsequent runs.
+    bool SaveTo(ZAMCacheSaver& s) const;
+
+    // Reconstructs a body previously written using SaveTo().  Returns
+    // nil if the saved information can't be matched up with the currently
+    // loaded scripts.
+    static IntrusivePtr<ZBody> LoadFrom(const char* func_name, ZAMCacheLoader& l);
 
     void Dump() const;
 
     void ProfileExecution() const;
 
 protected:
+    // Used by LoadFrom() - the remaining state is then filled in from
+    // the cache.
+    ZBody(const char* _func_name);
+
+    // One-time initialization of globals used by ZAM execution.
+    static void InitZAMGlobals();
+
     // Initializes profiling information, if needed.
     void InitProfile();
 
@@ -205,6 +205,8 @@ void Manager::GetStats(Stats& s) {
 
     s.num_fragments = zeek::detail::fragment_mgr->Size();
     s.max_fragments = zeek::detail::fragment_mgr->MaxFragments();
+    s.fragment_bytes = zeek::detail::fragment_mgr->MemoryUsage();
+    s.fragment_evictions = zeek::detail::fragment_mgr->Evictions();
     s.num_packets = packet_mgr->PacketsProcessed();
 }
 
@@ -44,6 +44,8 @@ struct Stats {
 
     size_t num_fragments;
     size_t max_fragments;
+    uint64_t fragment_bytes;
+    uint64_t fragment_evictions;
     uint64_t num_packets;
 };
 
@@ -1252,7 +1252,28 @@ bool GlueCompiler::CreateSpicyHook(glue::Event* ev) {
     body.startProfiler(hilti::util::fmt("zeek/event/%s", ev->name));
 #endif
 
-    // If the event comes with a condition, evaluate that first.
+    auto handler_expr = builder::id(handler_id);
+
+    if ( _driver->hiltiOptions().cxx_enable_dynamic_globals ) {
+        // Store reference to handler locally to avoid repeated lookups through globals store.
+        body.addLocal("handler", builder::id(handler_id), meta);
+        handler_expr = builder::id("handler");
+    }
+
+    // Nothing to do if there's no handler defined.
+    auto add_handler_check = [&]() {
+        auto have_handler = builder::call("zeek_rt::have_handler", {handler_expr}, meta);
+        auto exit_ = body.addIf(builder::not_(have_handler), meta);
+        exit_->addReturn(meta);
+    };
+
+    // Unless we're logging all events for debugging, check that first so
+    // that neither the condition nor any of the arguments get evaluated for
+    // events that nobody handles.
+    if ( ! _driver->hiltiOptions().debug )
+        add_handler_check();
+
+    // If the event comes with a condition, evaluate that next.
     if ( ev->condition.size() ) {
         auto cond = ::spicy::parseExpression(ev->condition, meta);
         if ( ! cond ) {
@@ -1293,18 +1314,10 @@ bool GlueCompiler::CreateSpicyHook(glue::Event* ev) {
         body.addExpression(call);
     }
 
-    auto handler_expr = builder::id(handler_id);
-
-    if ( _driver->hiltiOptions().cxx_enable_dynamic_globals ) {
-        // Store reference to handler locally to avoid repeated lookups through globals store.
-        body.addLocal("handler", builder::id(handler_id), meta);
-        handler_expr = builder::id("handler");
-    }
-
-    // Nothing to do if there's not handler defined.
-    auto have_handler = builder::call("zeek_rt::have_handler", {handler_expr}, meta);
-    auto exit_ = body.addIf(builder::not_(have_handler), meta);
-    exit_->addReturn(meta);
+    // In debug mode, we check only now so that the log shows events
+    // without handlers as well.
+    if ( _driver->hiltiOptions().debug )
+        add_handler_check();
 
     // Build event's argument vector.
     body.addLocal(hilti::ID("args"), hilti::type::Vector(builder::typeByID("zeek_rt::Val"), meta), meta);
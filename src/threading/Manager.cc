@@ -188,6 +188,8 @@ void Manager::Flush() {
         if ( do_beat )
             t->Heartbeat();
 
+        double start = t->max_process_time > 0 ? util::current_time(true) : 0;
+
         while ( t->HasOut() ) {
             Message* msg = t->RetrieveOut();
             assert(msg);
@@ -203,6 +205,9 @@ void Manager::Flush() {
             }
 
             delete msg;
+
+            if ( t->OutOfProcessTime(start) )
+                break;
         }
     }
 
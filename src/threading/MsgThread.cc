@@ -181,7 +181,9 @@ MsgThread::MsgThread() : BasicThread(), queue_in(this, nullptr), queue_out(nullp
     failed = false;
     thread_mgr->AddMsgThread(this);
 
-    if ( ! iosource_mgr->RegisterFd(flare.FD(), this) )
+    // Process() always empties the flare, re-firing it if it leaves
+    // messages behind.
+    if ( ! iosource_mgr->RegisterFd(flare.FD(), this, iosource::IOSource::READ | iosource::IOSource::EDGE_TRIGGERED) )
         reporter->FatalError("Failed to register MsgThread fd with iosource_mgr");
 
     SetClosed(false);
@@ -417,9 +419,20 @@ void MsgThread::GetStats(Stats* stats) {
     queue_out.GetStats(&stats->queue_out_stats);
 }
 
+bool MsgThread::OutOfProcessTime(double start) {
+    if ( max_process_time <= 0 || util::current_time(true) - start < max_process_time )
+        return false;
+
+    // Come back for the rest.
+    flare.Fire();
+    return true;
+}
+
 void MsgThread::Process() {
     flare.Extinguish();
 
+    double start = max_process_time > 0 ? util::current_time(true) : 0;
+
     while ( HasOut() ) {
         Message* msg = RetrieveOut();
         assert(msg);
@@ -430,6 +443,9 @@ void MsgThread::Process() {
         }
 
         delete msg;
+
+        if ( OutOfProcessTime(start) )
+            break;
     }
 }
 
@@ -286,6 +286,17 @@ protected:
      */
     virtual const zeek::detail::Location* GetLocationInfo() const { return nullptr; }
 
+    /**
+     * Limits how long the main thread spends on processing this thread's
+     * messages in one go. Once exceeded, the remaining messages are left
+     * for the next round, so that a burst doesn't stall everything else.
+     *
+     * Must be called before the thread starts.
+     *
+     * @param secs The limit in seconds, or 0 for no limit.
+     */
+    void SetMaxProcessTime(double secs) { max_process_time = secs; }
+
 private:
     /**
      * Pops a message sent by the main thread from the main-to-chold
@@ -350,6 +361,11 @@ private:
 
     std::string BuildMsgWithLocation(const char* msg);
 
+    // Returns true if processing messages started at *start* has
+    // exceeded the time limit, and arranges for processing to continue
+    // later if so.
+    bool OutOfProcessTime(double start);
+
     Queue<BasicInputMessage*> queue_in;
     Queue<BasicOutputMessage*> queue_out;
 
@@ -363,6 +379,8 @@ private:
     bool failed;            // Set to true when a command failed.
 
     zeek::detail::Flare flare;
+
+    double max_process_time = 0; // Seconds; 0 means no limit.
 };
 
 /**
@@ -163,6 +163,10 @@ bool Value::Read(detail::SerializationFormat* fmt) {
     if ( ! present )
         return true;
 
+    return ReadData(fmt);
+}
+
+bool Value::ReadData(detail::SerializationFormat* fmt) {
     switch ( type ) {
         case TYPE_BOOL:
         case TYPE_INT: return fmt->Read(&val.int_val, "int");
@@ -279,6 +283,10 @@ bool Value::Write(detail::SerializationFormat* fmt) const {
     if ( ! present )
         return true;
 
+    return WriteData(fmt);
+}
+
+bool Value::WriteData(detail::SerializationFormat* fmt) const {
     switch ( type ) {
         case TYPE_BOOL:
         case TYPE_INT: return fmt->Write(val.int_val, "int");
@@ -209,6 +209,29 @@ struct Value {
      */
     bool Write(zeek::detail::SerializationFormat* fmt) const;
 
+    /**
+     * Unserializes just the data of a present value, as written by
+     * WriteData(). The value's type and subtype must have been set
+     * already.
+     *
+     * @param fmt The serialization format to use. The format handles low-level I/O.
+     *
+     * @return False if an error occurred.
+     */
+    bool ReadData(zeek::detail::SerializationFormat* fmt);
+
+    /**
+     * Serializes just the data of a present value, omitting its type
+     * and presence. This is for callers that convey these separately,
+     * such as when sending many values of the same type.
+     *
+     * @param fmt The serialization format to use. The format handles
+     * low-level I/O.
+     *
+     * @return False if an error occurred.
+     */
+    bool WriteData(zeek::detail::SerializationFormat* fmt) const;
+
     /**
      * Returns true if the type can be represented by a Value. If
      * `atomic_only` is true, will not permit composite types. This
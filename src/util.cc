@@ -1933,6 +1933,7 @@ uint64_t calculate_unique_id(size_t pool) {
             // globally unique.
             struct {
                 char hostname[120];
+                char node[64];
                 uint64_t pool;
                 struct timeval time;
                 pid_t pid;
@@ -1942,6 +1943,12 @@ uint64_t calculate_unique_id(size_t pool) {
             memset(&unique, 0, sizeof(unique)); // Make valgrind happy.
             gethostname(unique.hostname, 120);
             unique.hostname[sizeof(unique.hostname) - 1] = '\0';
+
+            // Cluster nodes running in containers may well share their
+            // hostname and PID, so include the node's name, too.
+            if ( const char* node = getenv("CLUSTER_NODE") )
+                strncpy(unique.node, node, sizeof(unique.node) - 1);
+
             gettimeofday(&unique.time, 0);
             unique.pool = (uint64_t)pool;
             unique.pid = getpid();
@@ -44,7 +44,10 @@
 #include "zeek/ScannedFile.h"
 #include "zeek/Scope.h"
 #include "zeek/ScriptCoverageManager.h"
+#include "zeek/ScriptProfile.h"
+#include "zeek/SlabAlloc.h"
 #include "zeek/Stats.h"
+#include "zeek/SubsystemStats.h"
 #include "zeek/Stmt.h"
 #include "zeek/Tag.h"
 #include "zeek/Timer.h"
@@ -814,6 +817,9 @@ SetupResult setup(int argc, char** argv, Options* zopts) {
         RecordType::InitPostScript();
 
         telemetry_mgr->InitPostScript();
+#ifdef ENABLE_SLAB_ALLOC
+        init_slab_alloc_telemetry();
+#endif
         iosource_mgr->InitPostScript();
         log_mgr->InitPostScript();
         plugin_mgr->InitPostScript();
@@ -990,6 +996,8 @@ SetupResult setup(int argc, char** argv, Options* zopts) {
         exit(0);
     }
 
+    SubsystemScope::Init();
+
     if ( profiling_interval > 0 ) {
         const auto& profiling_file = id::find_val("profiling_file");
         profiling_logger = std::make_shared<ProfileLogger>(profiling_file->AsFile(), profiling_interval);
@@ -1007,6 +1015,11 @@ SetupResult setup(int argc, char** argv, Options* zopts) {
     if ( CPP_activation_hook )
         (*CPP_activation_hook)();
 
+    // Start sampling only now, so that parsing and setting up scripts
+    // doesn't show up in the profile.
+    if ( script_sampler )
+        script_sampler->Start();
+
     if ( zeek_init )
         event_mgr.Enqueue(zeek_init, Args{});
 